@@ -0,0 +1,209 @@
+#include "bench.hpp"
+#include <regex>
+#include <thread>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+int64_t g_benchMaxNodes = 1000000;
+
+namespace {
+    struct bench_case {
+        std::string name;
+        bench_fn fn;
+        std::vector<std::vector<int64_t>> args;
+    };
+
+    struct bench_result {
+        std::string name;
+        uint64_t iterations;
+        double realNs;          // per iteration
+        double cpuNs;
+        double itemsPerSecond;
+        std::map<std::string, double> counters;
+    };
+
+    // a run never goes past this many iterations, however fast it is
+    constexpr uint64_t s_maxIterations = 1000000000;
+
+    std::vector<bench_case>& cases() {
+        static std::vector<bench_case> res;
+        return res;
+    }
+
+    std::string runName(std::string const& name, std::vector<int64_t> const& args) {
+        auto res = name;
+        for (auto arg : args)
+            res += "/" + std::to_string(arg);
+        return res;
+    }
+
+    // google benchmark's approach: time one iteration, then keep growing
+    // the count towards what should fill `minTime`, at most 10x a step
+    bool run(bench_case const& c, std::vector<int64_t> const& args, double minTime, bench_result& out) {
+        uint64_t iterations = 1;
+        while (true) {
+            bench_state state(args, iterations);
+            c.fn(state);
+
+            if (!state.skipped().empty()) {
+                std::fprintf(stderr, "%-40s skipped: %s\n", runName(c.name, args).c_str(), state.skipped().c_str());
+                return false;
+            }
+
+            auto wall = state.wallSeconds();
+            if (wall >= minTime || iterations >= s_maxIterations) {
+                out.name = runName(c.name, args);
+                out.iterations = iterations;
+                out.realNs = wall * 1e9 / iterations;
+                out.cpuNs = state.cpuSeconds() * 1e9 / iterations;
+                out.itemsPerSecond = state.items() > 0.0 && wall > 0.0 ? state.items() * iterations / wall : 0.0;
+                out.counters = state.counters();
+                return true;
+            }
+
+            auto multiplier = wall > 0.0 ? minTime * 1.4 / wall : 10.0;
+            multiplier = std::min(std::max(multiplier, 2.0), 10.0);
+            iterations = std::min(
+                static_cast<uint64_t>(iterations * multiplier),
+                s_maxIterations
+            );
+        }
+    }
+
+    std::string jsonString(std::string const& str) {
+        std::string res = "\"";
+        for (auto c : str) {
+            switch (c) {
+                case '"':   res += "\\\""; break;
+                case '\\':  res += "\\\\"; break;
+                case '\n':  res += "\\n"; break;
+                default:    res += c; break;
+            }
+        }
+        return res + "\"";
+    }
+
+    std::string toJson(std::vector<bench_result> const& results, char const* executable) {
+        char date[64];
+        auto now = std::time(nullptr);
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+
+        std::ostringstream res;
+        res.precision(17);
+        res << "{\n  \"context\": {\n"
+            << "    \"date\": " << jsonString(date) << ",\n"
+            << "    \"executable\": " << jsonString(executable) << ",\n"
+            << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+#ifdef NDEBUG
+            << "    \"library_build_type\": \"release\",\n"
+#else
+            << "    \"library_build_type\": \"debug\",\n"
+#endif
+            << "    \"max_nodes\": " << g_benchMaxNodes << "\n"
+            << "  },\n  \"benchmarks\": [";
+
+        for (size_t i = 0; i < results.size(); i++) {
+            auto const& r = results[i];
+            res << (i ? ",\n" : "\n")
+                << "    {\n"
+                << "      \"name\": " << jsonString(r.name) << ",\n"
+                << "      \"run_name\": " << jsonString(r.name) << ",\n"
+                << "      \"run_type\": \"iteration\",\n"
+                << "      \"iterations\": " << r.iterations << ",\n"
+                << "      \"real_time\": " << r.realNs << ",\n"
+                << "      \"cpu_time\": " << r.cpuNs << ",\n"
+                << "      \"time_unit\": \"ns\"";
+            if (r.itemsPerSecond > 0.0)
+                res << ",\n      \"items_per_second\": " << r.itemsPerSecond;
+            for (auto const& [name, value] : r.counters)
+                res << ",\n      " << jsonString(name) << ": " << value;
+            res << "\n    }";
+        }
+
+        res << "\n  ]\n}\n";
+        return res.str();
+    }
+
+    char const* flagValue(char const* arg, char const* flag) {
+        auto len = std::strlen(flag);
+        if (std::strncmp(arg, flag, len) || arg[len] != '=')
+            return nullptr;
+        return arg + len + 1;
+    }
+}
+
+bool registerBench(char const* name, bench_fn fn, std::vector<std::vector<int64_t>> args) {
+    if (args.empty())
+        args.push_back({});
+    cases().push_back({ name, fn, std::move(args) });
+    return true;
+}
+
+// usage: cocos-designer-bench [--benchmark_filter=<regex>] [--benchmark_out=<file>]
+//                             [--benchmark_min_time=<seconds>] [--max-nodes=<count>]
+// the json goes to the --benchmark_out file, or stdout without one.
+// the human readable table always goes to stderr
+int main(int argc, char** argv) {
+    std::string filter = ".*";
+    std::string outPath;
+    double minTime = 0.5;
+
+    for (int i = 1; i < argc; i++) {
+        if (auto v = flagValue(argv[i], "--benchmark_filter")) {
+            filter = v;
+        } else if (auto v = flagValue(argv[i], "--benchmark_out")) {
+            outPath = v;
+        } else if (auto v = flagValue(argv[i], "--benchmark_min_time")) {
+            minTime = std::atof(v);
+        } else if (auto v = flagValue(argv[i], "--max-nodes")) {
+            g_benchMaxNodes = std::atoll(v);
+        } else {
+            std::fprintf(stderr, "unknown argument %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    std::regex pattern(filter);
+    std::vector<bench_result> results;
+
+    std::fprintf(stderr, "%-40s %15s %15s %12s\n", "Benchmark", "Time (ns)", "CPU (ns)", "Iterations");
+    for (auto const& c : cases()) {
+        for (auto const& args : c.args) {
+            if (!std::regex_search(runName(c.name, args), pattern))
+                continue;
+
+            bench_result result;
+            if (!run(c, args, minTime, result))
+                continue;
+
+            std::fprintf(
+                stderr, "%-40s %15.0f %15.0f %12llu", result.name.c_str(),
+                result.realNs, result.cpuNs, static_cast<unsigned long long>(result.iterations)
+            );
+            if (result.itemsPerSecond > 0.0)
+                std::fprintf(stderr, "  items/s=%.4g", result.itemsPerSecond);
+            for (auto const& [name, value] : result.counters)
+                std::fprintf(stderr, "  %s=%.4g", name.c_str(), value);
+            std::fprintf(stderr, "\n");
+
+            results.push_back(std::move(result));
+        }
+    }
+
+    auto json = toJson(results, argv[0]);
+    if (outPath.empty()) {
+        std::fputs(json.c_str(), stdout);
+    } else {
+        std::ofstream file(outPath);
+        if (!(file << json)) {
+            std::fprintf(stderr, "couldn't write %s\n", outPath.c_str());
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,104 @@
+#ifndef __BENCH_HPP__
+#define __BENCH_HPP__
+
+#include <map>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <ctime>
+
+// a small stand-in for google benchmark: cases register themselves with
+// BENCH(), the runner grows the iteration count until a run takes long
+// enough and writes the results in google benchmark's json format, so
+// the usual comparison tooling can track them
+class bench_state {
+    public:
+        bench_state(std::vector<int64_t> const& args, uint64_t iterations)
+          : m_args(args), m_iterations(iterations) {}
+
+        // true while there are iterations left, the first call starts the timer
+        bool next() {
+            if (!m_started) {
+                m_started = true;
+                this->resume();
+            }
+            if (m_done < m_iterations) {
+                m_done++;
+                return true;
+            }
+            this->pause();
+            return false;
+        }
+
+        // for setup inside the loop that shouldn't be timed. before the
+        // first next() nothing is timed anyway
+        void pause() {
+            if (!m_running)
+                return;
+            m_wall += std::chrono::steady_clock::now() - m_wallStart;
+            m_cpu += std::clock() - m_cpuStart;
+            m_running = false;
+        }
+
+        void resume() {
+            if (m_running || !m_started)
+                return;
+            m_wallStart = std::chrono::steady_clock::now();
+            m_cpuStart = std::clock();
+            m_running = true;
+        }
+
+        int64_t arg(size_t i) const { return m_args[i]; }
+        uint64_t iterations() const { return m_iterations; }
+
+        // things done per iteration, reported per second
+        void setItemsPerIteration(double items) { m_items = items; }
+        void counter(std::string const& name, double value) { m_counters[name] = value; }
+        // marks the case as not runnable with these args, e.g. too big
+        void skip(std::string const& reason) { m_skipped = reason; }
+
+        double wallSeconds() const { return std::chrono::duration<double>(m_wall).count(); }
+        double cpuSeconds() const { return static_cast<double>(m_cpu) / CLOCKS_PER_SEC; }
+        double items() const { return m_items; }
+        std::map<std::string, double> const& counters() const { return m_counters; }
+        std::string const& skipped() const { return m_skipped; }
+
+    protected:
+        std::vector<int64_t> m_args;
+        uint64_t m_iterations;
+        uint64_t m_done = 0;
+        bool m_started = false;
+        bool m_running = false;
+
+        std::chrono::steady_clock::time_point m_wallStart;
+        std::chrono::steady_clock::duration m_wall {};
+        std::clock_t m_cpuStart = 0;
+        std::clock_t m_cpu = 0;
+
+        double m_items = 0.0;
+        std::map<std::string, double> m_counters;
+        std::string m_skipped;
+};
+
+using bench_fn = void(*)(bench_state&);
+
+// `args` holds one argument list per run; the run's name is the case
+// name followed by its arguments, "hit_test/10000"
+bool registerBench(char const* name, bench_fn fn, std::vector<std::vector<int64_t>> args);
+
+#define BENCH_CONCAT_(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_(a, b)
+#define BENCH(fn, ...) \
+    static bool BENCH_CONCAT(benchRegistered_, __LINE__) = registerBench(#fn, fn, { __VA_ARGS__ })
+
+// the usual scene sizes, capped by --max-nodes
+extern int64_t g_benchMaxNodes;
+
+// stops the optimizer from dropping a result
+template <class T>
+inline void keep(T const& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+#endif
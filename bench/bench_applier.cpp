@@ -0,0 +1,137 @@
+#include "bench.hpp"
+#include "synthetic_scene.hpp"
+#include "scene_graph.hpp"
+#include "properties.hpp"
+#include "task_scheduler.hpp"
+#include <random>
+#include <algorithm>
+#include <memory>
+
+// applying saved edits on scene load: scene_edit_applier's one walk
+// sharing path prefixes between neighbouring locations, against the
+// old loop resolving every location from the scene on its own. runs
+// over a 100k node scene with thousands of edits, either spread over
+// the whole tree or packed into one part of it, like after reworking
+// a single menu. the arguments are node count, edit count, packed
+
+namespace {
+    // edits that put nodes back where they already are, so applying
+    // them over and over leaves the shared scene as it was
+    void buildEdits(synthetic_scene const& s, size_t count, bool packed, scene_edit& out) {
+        std::mt19937 rng(13);
+        auto total = s.nodes.size() - 1;
+        count = std::min(count, total);
+
+        std::vector<CCNode*> picked;
+        if (packed) {
+            auto start = std::uniform_int_distribution<size_t>(1, total - count + 1)(rng);
+            picked.assign(s.nodes.begin() + start, s.nodes.begin() + start + count);
+        } else {
+            std::uniform_int_distribution<size_t> pick(1, total);
+            for (size_t i = 0; i < count; i++)
+                picked.push_back(s.nodes[pick(rng)]);
+        }
+
+        out.rtti_name = "CCScene";
+        out.nodes.clear();
+        for (auto node : picked) {
+            auto& edit = out.nodes[getNodeLocationInTree(node)];
+            edit.props = npPosition;
+            edit.position = node->getPosition();
+        }
+    }
+}
+
+#define APPLY_ARGS \
+    { 100000, 1000, 0 }, { 100000, 1000, 1 }, \
+    { 100000, 10000, 0 }, { 100000, 10000, 1 }
+
+// the pre-applier loadSceneChanges, minus the debug string it built
+void apply_edits_lookup(bench_state& state) {
+    auto s = sharedScene(state, state.arg(0));
+    if (!s)
+        return;
+
+    state.pause();
+    scene_edit edits;
+    buildEdits(*s, static_cast<size_t>(state.arg(1)), state.arg(2) != 0, edits);
+    state.resume();
+
+    unsigned int applied = 0;
+    while (state.next()) {
+        applied = 0;
+        for (auto const& [location, edit] : edits.nodes) {
+            auto tloc = std::vector<int>(location.begin() + 1, location.end());
+            auto node = getNodeByTreeLocation(s->scene, tloc);
+            if (!node)
+                continue;
+            applyNodeEdit(node, edit);
+            applied++;
+        }
+    }
+
+    state.setItemsPerIteration(static_cast<double>(edits.nodes.size()));
+    state.counter("applied", applied);
+}
+BENCH(apply_edits_lookup, APPLY_ARGS);
+
+void apply_edits_walk(bench_state& state) {
+    auto s = sharedScene(state, state.arg(0));
+    if (!s)
+        return;
+
+    state.pause();
+    scene_edit edits;
+    buildEdits(*s, static_cast<size_t>(state.arg(1)), state.arg(2) != 0, edits);
+    state.resume();
+
+    unsigned int applied = 0;
+    while (state.next()) {
+        scene_edit_applier applier(s->scene, edits);
+        applier.beginSlice();
+        while (!applier.done())
+            applier.step();
+        applied = applier.applied;
+    }
+
+    state.setItemsPerIteration(static_cast<double>(edits.nodes.size()));
+    state.counter("applied", applied);
+}
+BENCH(apply_edits_walk, APPLY_ARGS);
+
+// the walk as the dll runs it with a big save: a task doing 64 steps
+// at a time, for as many frames as the scheduler's budget takes. the
+// path starts over from the scene once per slice
+void apply_edits_sliced(bench_state& state) {
+    auto s = sharedScene(state, state.arg(0));
+    if (!s)
+        return;
+
+    state.pause();
+    scene_edit edits;
+    buildEdits(*s, static_cast<size_t>(state.arg(1)), state.arg(2) != 0, edits);
+    state.resume();
+
+    TaskScheduler tasks;
+    unsigned int applied = 0, frames = 0;
+    while (state.next()) {
+        auto applier = std::make_shared<scene_edit_applier>(s->scene, edits);
+        tasks.start("apply", tpHigh, [applier](task_context& ctx) {
+            if (!ctx.steps)
+                applier->beginSlice();
+            for (int i = 0; i < 64 && !applier->done(); i++)
+                applier->step();
+            return !applier->done();
+        });
+
+        frames = 1;
+        for (; !tasks.tasks().empty(); frames++)
+            tasks.run();
+        applied = applier->applied;
+    }
+
+    state.setItemsPerIteration(static_cast<double>(edits.nodes.size()));
+    state.counter("applied", applied);
+    state.counter("frames", frames);
+}
+BENCH(apply_edits_sliced, APPLY_ARGS);
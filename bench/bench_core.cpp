@@ -0,0 +1,452 @@
+#include "bench.hpp"
+#include "synthetic_scene.hpp"
+#include "spatial_index.hpp"
+#include "snapping.hpp"
+#include "scene_graph.hpp"
+#include "scene_mirror.hpp"
+#include "change_tracker.hpp"
+#include "frame_context.hpp"
+#include "edit_store.hpp"
+#include "scene_snapshot.hpp"
+#include "analysis.hpp"
+#include <thread>
+#include <random>
+#include <cmath>
+
+// the core's share of the explorer's hot paths, over the synthetic
+// scenes. the dll wraps these in drawing (the hover outline, the snap
+// guides) that isn't measured here, so each case runs the same calls in
+// the same order as its caller in main.cpp does:
+//
+//   hit_test        getNodesUnderMouse: the per frame validate + nodeAt
+//   snap_begin      onSelectNode: the indices built when a drag starts
+//   snap            snapNodePosition: the queries each frame of a drag
+//   tree_location   getNodeLocationInTree + getNodeByTreeLocation, with
+//                   and without the mirror
+//   mirror_churn    the child hooks plus the mirror catching up, with
+//                   a few nodes coming and going every frame
+//   save_changes    saveSceneChanges: collecting and encoding the edits
+//   load_changes    loadSceneChanges: decoding and applying them
+//   snapshot_build  updateAnalysis: copying the scene out of the mirror
+//   analysis        the pool's stats and search over that copy, from
+//                   submitting it to the results being polled back
+
+#define SCENE_SIZES { 1000 }, { 10000 }, { 100000 }, { 1000000 }
+
+namespace {
+    // same as the dll's default
+    constexpr float s_snapThreshold = 10.0f;
+
+    // enough distinct queries that the caches see a realistic mix
+    constexpr size_t s_queryCount = 1024;
+
+    std::vector<CCPoint> randomPoints(size_t count, uint32_t seed) {
+        std::mt19937 rng(seed);
+        auto winSize = CCDirector::sharedDirector()->getWinSize();
+        std::uniform_real_distribution<float> x(0.0f, winSize.width), y(0.0f, winSize.height);
+
+        std::vector<CCPoint> res;
+        for (size_t i = 0; i < count; i++)
+            res.push_back({ x(rng), y(rng) });
+        return res;
+    }
+
+    std::vector<CCNode*> randomNodes(synthetic_scene const& s, size_t count, uint32_t seed) {
+        std::mt19937 rng(seed);
+        // the scene itself is nodes[0], it has no location worth asking for
+        std::uniform_int_distribution<size_t> pick(1, s.nodes.size() - 1);
+
+        std::vector<CCNode*> res;
+        for (size_t i = 0; i < count; i++)
+            res.push_back(s.nodes[pick(rng)]);
+        return res;
+    }
+
+    // what a drag works on: a child of the busiest parent, so there
+    // are plenty of siblings to snap against
+    CCNode* draggedNode(synthetic_scene const& s) {
+        return static_cast<CCNode*>(s.widestParent->getChildren()->objectAtIndex(0));
+    }
+}
+
+void hit_test_build(bench_state& state) {
+    auto s = sharedScene(state, state.arg(0));
+    if (!s)
+        return;
+
+    SpatialIndex index;
+    while (state.next()) {
+        index.build(s->root);
+        keep(index.entries().size());
+    }
+    state.setItemsPerIteration(static_cast<double>(s->nodes.size()));
+}
+BENCH(hit_test_build, SCENE_SIZES);
+
+void hit_test(bench_state& state) {
+    auto s = sharedScene(state, state.arg(0));
+    if (!s)
+        return;
+
+    auto director = CCDirector::sharedDirector();
+    auto points = randomPoints(s_queryCount, 2);
+
+    state.pause();
+    SpatialIndex index;
+    index.build(s->root);
+    state.resume();
+
+    size_t i = 0, hits = 0;
+    while (state.next()) {
+        // every query is a new frame, like the mouse moving every frame
+        director->drawScene();
+        index.validateSlice(2048);
+        index.refresh();
+
+        auto node = index.nodeAt(points[i++ % points.size()], false);
+        hits += node != nullptr;
+        keep(node);
+    }
+    state.counter("hit_ratio", static_cast<double>(hits) / static_cast<double>(state.iterations()));
+}
+BENCH(hit_test, SCENE_SIZES);
+
+void snap_begin(bench_state& state) {
+    auto s = sharedScene(state, state.arg(0));
+    if (!s)
+        return;
+
+    auto dragged = draggedNode(*s);
+    auto winSize = CCDirector::sharedDirector()->getWinSize();
+
+    state.pause();
+    SpatialIndex index;
+    index.build(s->root);
+    state.resume();
+
+    AlignmentIndex align;
+    SiblingHash siblings;
+    SpacingIndex spacing;
+    while (state.next()) {
+        index.refresh();
+        align.build(index, dragged, winSize, true);
+        siblings.build(dragged);
+        spacing.build(dragged, 1.0f);
+    }
+    state.counter("siblings", static_cast<double>(s->widestParent->getChildrenCount()));
+}
+BENCH(snap_begin, SCENE_SIZES);
+
+void snap(bench_state& state) {
+    auto s = sharedScene(state, state.arg(0));
+    if (!s)
+        return;
+
+    auto director = CCDirector::sharedDirector();
+    auto dragged = draggedNode(*s);
+    auto parent = dragged->getParent();
+    auto startPos = dragged->getPosition();
+
+    state.pause();
+    SpatialIndex index;
+    index.build(s->root);
+    AlignmentIndex align;
+    align.build(index, dragged, director->getWinSize(), true);
+    SiblingHash siblings;
+    siblings.build(dragged);
+    SpacingIndex spacing;
+    spacing.build(dragged, 1.0f);
+
+    // the mouse wandering around the node's original position
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> offset(-60.0f, 60.0f);
+    std::vector<CCPoint> path;
+    for (size_t i = 0; i < s_queryCount; i++)
+        path.push_back(startPos + CCPoint { offset(rng), offset(rng) });
+    state.resume();
+
+    size_t i = 0;
+    while (state.next()) {
+        director->drawScene();
+        dragged->setPosition(path[i++ % path.size()]);
+        g_frame.invalidate(dragged);
+
+        // snapNodeToGrid
+        auto pos = dragged->getPosition();
+        for (auto axis : { saX, saY }) {
+            spacing_match match;
+            if (!spacing.snap(axis, pos, s_snapThreshold, match))
+                continue;
+            if (axis == saX)
+                pos.x += match.delta;
+            else
+                pos.y += match.delta;
+            auto [begin, end] = spacing.gapsOf(axis, match.gap);
+            keep(end - begin);
+        }
+        dragged->setPosition(pos);
+
+        // snapNodeToNear
+        auto cc = dragged->getScaledContentSize() / 2;
+        auto rect = CCRect { pos.x - cc.width, pos.y - cc.height, cc.width * 2, cc.height * 2 };
+        sibling_rect const* nearest[SiblingHash::maxNearest * SiblingHash::sideCount];
+        auto count = siblings.nearest(rect, SiblingHash::maxNearest, nearest);
+
+        float bestX = s_snapThreshold, bestY = s_snapThreshold;
+        auto snappedPos = pos;
+        for (unsigned int j = 0; j < count; j++) {
+            auto const& nrect = nearest[j]->rect;
+            auto cc2 = nrect.size / 2;
+            auto pos2 = CCPoint { nrect.getMidX(), nrect.getMidY() };
+
+            auto gapx = fabsf(fabsf(pos.x - pos2.x) - cc.width - cc2.width);
+            if (gapx < bestX) {
+                bestX = gapx;
+                snappedPos.x = pos.x < pos2.x ? pos2.x - cc2.width - cc.width : pos2.x + cc2.width + cc.width;
+            }
+            auto gapy = fabsf(fabsf(pos.y - pos2.y) - cc.height - cc2.height);
+            if (gapy < bestY) {
+                bestY = gapy;
+                snappedPos.y = pos.y < pos2.y ? pos2.y - cc2.height - cc.height : pos2.y + cc2.height + cc.height;
+            }
+        }
+        dragged->setPosition(snappedPos);
+        g_frame.invalidate(dragged);
+
+        // snapNodeToLines
+        auto wrect = getNodeWorldRect(dragged);
+        auto wpos = g_frame.toWorld(parent, dragged->getPosition());
+        snap_match match;
+        float xs[] = { wrect.getMinX(), wrect.getMidX(), wrect.getMaxX() };
+        if (align.closest(saX, xs, 3, s_snapThreshold, true, match))
+            wpos.x += match.delta;
+        float ys[] = { wrect.getMinY(), wrect.getMidY(), wrect.getMaxY() };
+        if (align.closest(saY, ys, 3, s_snapThreshold, true, match))
+            wpos.y += match.delta;
+        dragged->setPosition(g_frame.toNode(parent, wpos));
+        g_frame.invalidate(dragged);
+    }
+
+    dragged->setPosition(startPos);
+    g_frame.invalidate(dragged);
+}
+BENCH(snap, SCENE_SIZES);
+
+// the second argument is whether the mirror is up, without it both
+// directions walk the cocos children arrays
+void tree_location(bench_state& state) {
+    auto s = sharedScene(state, state.arg(0));
+    if (!s)
+        return;
+
+    auto mirrored = state.arg(1) != 0;
+    auto nodes = randomNodes(*s, s_queryCount, 4);
+
+    state.pause();
+    if (!mirrored)
+        g_mirror.sync(nullptr);
+    state.resume();
+
+    size_t i = 0, found = 0;
+    while (state.next()) {
+        auto node = nodes[i++ % nodes.size()];
+        auto loc = getNodeLocationInTree(node);
+        // the location starts with the scene's own 0
+        auto res = getNodeByTreeLocation(s->scene, std::vector<int>(loc.begin() + 1, loc.end()));
+        found += res == node;
+        keep(res);
+    }
+
+    state.pause();
+    if (!mirrored)
+        g_mirror.sync(s->scene);
+    state.resume();
+
+    if (found != state.iterations())
+        state.skip("locations didn't round trip");
+}
+BENCH(tree_location,
+    { 1000, 0 }, { 1000, 1 }, { 10000, 0 }, { 10000, 1 },
+    { 100000, 0 }, { 100000, 1 }, { 1000000, 0 }, { 1000000, 1 }
+);
+
+// every frame the sprites added last frame go and as many new ones
+// show up under random parents, like a game spawning particles
+void mirror_churn(bench_state& state) {
+    auto s = sharedScene(state, state.arg(0));
+    if (!s)
+        return;
+
+    constexpr size_t churn = 8;
+    auto parents = randomNodes(*s, s_queryCount, 8);
+    std::vector<CCNode*> added;
+
+    size_t i = 0;
+    while (state.next()) {
+        for (auto node : added) {
+            auto parent = node->getParent();
+            g_mirror.removing(parent, node);
+            parent->removeChild(node, true);
+        }
+        added.clear();
+
+        for (size_t j = 0; j < churn; j++) {
+            auto parent = parents[i++ % parents.size()];
+            auto node = new CCSprite();
+            parent->addChild(node);
+            node->release();
+            g_mirror.childrenChanged(parent);
+            added.push_back(node);
+        }
+
+        g_mirror.sync(s->scene);
+    }
+
+    state.pause();
+    for (auto node : added) {
+        auto parent = node->getParent();
+        g_mirror.removing(parent, node);
+        parent->removeChild(node, true);
+    }
+    g_mirror.sync(s->scene);
+    state.resume();
+
+    state.setItemsPerIteration(2.0 * churn);
+}
+BENCH(mirror_churn, SCENE_SIZES);
+
+namespace {
+    // a tenth of the scene is edited, up to what a big session might save
+    size_t editCount(synthetic_scene const& s) {
+        return std::min<size_t>(s.nodes.size() / 10, 20000);
+    }
+}
+
+void save_changes(bench_state& state) {
+    auto s = sharedScene(state, state.arg(0));
+    if (!s)
+        return;
+
+    state.pause();
+    auto nodes = randomNodes(*s, editCount(*s), 5);
+    std::vector<CCPoint> original;
+    ChangeTracker changes;
+    for (auto node : nodes) {
+        original.push_back(node->getPosition());
+        changes.track(node);
+        node->setPosition(node->getPosition() + CCPoint { 1.0f, 1.0f });
+        changes.mark(node, npPosition);
+    }
+    state.resume();
+
+    size_t bytes = 0;
+    while (state.next()) {
+        scene_map scenes;
+        auto& edit = scenes["CCScene"];
+        edit.rtti_name = "CCScene";
+        collectSceneChanges(changes, edit);
+        auto data = edit_format::encode(scenes);
+        bytes = data.size();
+        keep(data.data());
+    }
+
+    state.pause();
+    changes.clear();
+    // backwards, a node picked twice got moved twice
+    for (auto i = nodes.size(); i-- > 0;)
+        nodes[i]->setPosition(original[i]);
+    g_frame.invalidate();
+    state.resume();
+
+    state.setItemsPerIteration(static_cast<double>(nodes.size()));
+    state.counter("bytes", static_cast<double>(bytes));
+}
+BENCH(save_changes, SCENE_SIZES);
+
+void load_changes(bench_state& state) {
+    auto s = sharedScene(state, state.arg(0));
+    if (!s)
+        return;
+
+    // edits that put every node back where it already is, so applying
+    // them over and over leaves the shared scene as it was
+    state.pause();
+    scene_map saved;
+    auto& saveEdit = saved["CCScene"];
+    saveEdit.rtti_name = "CCScene";
+    for (auto node : randomNodes(*s, editCount(*s), 6)) {
+        auto& edit = saveEdit.nodes[getNodeLocationInTree(node)];
+        edit.props = npPosition;
+        edit.position = node->getPosition();
+    }
+    auto data = edit_format::encode(saved);
+    state.resume();
+
+    unsigned int applied = 0;
+    while (state.next()) {
+        scene_map scenes;
+        if (!edit_format::decode(data.data(), data.size(), scenes)) {
+            state.skip("couldn't decode the edits");
+            return;
+        }
+
+        scene_edit_applier applier(s->scene, scenes["CCScene"]);
+        applier.beginSlice();
+        while (!applier.done())
+            applier.step();
+        applied = applier.applied;
+    }
+
+    state.setItemsPerIteration(static_cast<double>(saveEdit.nodes.size()));
+    state.counter("applied", applied);
+}
+BENCH(load_changes, SCENE_SIZES);
+
+void snapshot_build(bench_state& state) {
+    auto s = sharedScene(state, state.arg(0));
+    if (!s)
+        return;
+
+    // reused like the pool's spare, so only the first capture allocates
+    scene_snapshot snapshot;
+    uint64_t sequence = 0;
+    while (state.next()) {
+        captureSnapshot(snapshot, ++sequence);
+        keep(snapshot.size());
+    }
+
+    state.setItemsPerIteration(static_cast<double>(snapshot.size()));
+    state.counter("strings", static_cast<double>(snapshot.strings.size()));
+}
+BENCH(snapshot_build, SCENE_SIZES);
+
+// the main thread never waits on the pool, this does so there's
+// something to time. the query matches a slice of the labels
+void analysis(bench_state& state) {
+    auto s = sharedScene(state, state.arg(0));
+    if (!s)
+        return;
+
+    state.pause();
+    AnalysisPool pool;
+    auto snapshot = pool.acquireSnapshot();
+    captureSnapshot(*snapshot, 1);
+    state.resume();
+
+    unsigned int hits = 0;
+    while (state.next()) {
+        pool.submit(snapshot, "label 1");
+        while (pool.busy())
+            std::this_thread::yield();
+        pool.poll();
+        hits = pool.search().total;
+    }
+
+    state.pause();
+    pool.shutdown();
+    state.resume();
+
+    state.setItemsPerIteration(static_cast<double>(snapshot->size()));
+    state.counter("hits", hits);
+}
+BENCH(analysis, SCENE_SIZES);
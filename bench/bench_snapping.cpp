@@ -0,0 +1,191 @@
+#include "bench.hpp"
+#include "snapping.hpp"
+#include <random>
+#include <cmath>
+#include <algorithm>
+
+// the sibling grid against checking every sibling, on one flat parent
+// with 1k and 10k children, about as dense as a crowded editor layer.
+// the brute force keeps the same per-side k-best lists as
+// SiblingHash::nearest, so both answer the same question
+
+namespace {
+    struct flat_parent {
+        CCLayer* parent;
+        CCNode* dragged;
+        std::vector<CCPoint> queries;
+    };
+
+    void buildFlatParent(flat_parent& out, unsigned int count) {
+        std::mt19937 rng(11);
+        // ~60 units of room per child, whatever the count
+        auto side = std::sqrt(static_cast<float>(count)) * 60.0f;
+        std::uniform_real_distribution<float> pos(0.0f, side), size(8.0f, 80.0f);
+
+        out.parent = new CCLayer();
+        out.parent->setContentSize({ side, side });
+        for (unsigned int i = 0; i < count; i++) {
+            auto child = new CCSprite();
+            child->setContentSize({ size(rng), size(rng) });
+            child->setPosition({ pos(rng), pos(rng) });
+            out.parent->addChild(child, 0, static_cast<int>(i));
+            child->release();
+        }
+        out.dragged = static_cast<CCNode*>(out.parent->getChildren()->objectAtIndex(0));
+
+        out.queries.clear();
+        for (unsigned int i = 0; i < 1024; i++)
+            out.queries.push_back({ pos(rng), pos(rng) });
+    }
+
+    CCRect queryRect(flat_parent const& f, CCPoint const& pos) {
+        auto cc = f.dragged->getScaledContentSize() / 2;
+        return CCRect { pos.x - cc.width, pos.y - cc.height, cc.width * 2, cc.height * 2 };
+    }
+
+    float gapBetween(CCRect const& a, CCRect const& b) {
+        auto dx = std::max(0.0f, std::max(a.getMinX() - b.getMaxX(), b.getMinX() - a.getMaxX()));
+        auto dy = std::max(0.0f, std::max(a.getMinY() - b.getMaxY(), b.getMinY() - a.getMaxY()));
+        return sqrtf(dx * dx + dy * dy);
+    }
+
+    // every sibling checked against the k-best list of its side
+    unsigned int bruteNearest(
+        std::vector<sibling_rect> const& rects, CCRect const& rect,
+        unsigned int k, sibling_rect const** out
+    ) {
+        sibling_rect const* best[SiblingHash::sideCount][SiblingHash::maxNearest];
+        float dists[SiblingHash::sideCount][SiblingHash::maxNearest];
+        unsigned int found[SiblingHash::sideCount] = {};
+
+        for (auto const& item : rects) {
+            auto dx = item.rect.getMidX() - rect.getMidX();
+            auto dy = item.rect.getMidY() - rect.getMidY();
+            auto side = fabsf(dx) >= fabsf(dy) ?
+                (dx < 0.0f ? SiblingHash::ssLeft : SiblingHash::ssRight) :
+                (dy < 0.0f ? SiblingHash::ssBelow : SiblingHash::ssAbove);
+
+            auto dist = gapBetween(rect, item.rect);
+            auto& n = found[side];
+            if (n == k && dist >= dists[side][k - 1])
+                continue;
+
+            auto ix = n < k ? n++ : k - 1;
+            while (ix > 0 && dists[side][ix - 1] > dist) {
+                dists[side][ix] = dists[side][ix - 1];
+                best[side][ix] = best[side][ix - 1];
+                ix--;
+            }
+            dists[side][ix] = dist;
+            best[side][ix] = &item;
+        }
+
+        unsigned int count = 0;
+        for (unsigned int side = 0; side < SiblingHash::sideCount; side++)
+            for (unsigned int i = 0; i < found[side]; i++)
+                out[count++] = best[side][i];
+        return count;
+    }
+
+    // what SiblingHash::build collects, done once for the brute force
+    std::vector<sibling_rect> siblingRects(CCNode* dragged) {
+        std::vector<sibling_rect> res;
+        CCObject* obj;
+        CCARRAY_FOREACH(dragged->getParent()->getChildren(), obj) {
+            auto node = reinterpret_cast<CCNode*>(obj);
+            if (node == dragged)
+                continue;
+            auto pos = node->getPosition();
+            auto size = node->getScaledContentSize();
+            res.push_back({ CCRect { pos.x - size.width / 2, pos.y - size.height / 2, size.width, size.height }, node });
+        }
+        return res;
+    }
+
+    // the same nodes at the same gaps, ties may come out in any order
+    bool sameNearest(
+        sibling_rect const** a, unsigned int aCount,
+        sibling_rect const** b, unsigned int bCount,
+        CCRect const& rect
+    ) {
+        if (aCount != bCount)
+            return false;
+
+        std::vector<float> ga, gb;
+        for (unsigned int i = 0; i < aCount; i++) {
+            ga.push_back(gapBetween(rect, a[i]->rect));
+            gb.push_back(gapBetween(rect, b[i]->rect));
+        }
+        std::sort(ga.begin(), ga.end());
+        std::sort(gb.begin(), gb.end());
+        return ga == gb;
+    }
+}
+
+#define SIBLING_COUNTS { 1000 }, { 10000 }
+
+void siblings_build(bench_state& state) {
+    state.pause();
+    flat_parent f;
+    buildFlatParent(f, static_cast<unsigned int>(state.arg(0)));
+    state.resume();
+
+    SiblingHash hash;
+    while (state.next())
+        hash.build(f.dragged);
+
+    state.setItemsPerIteration(static_cast<double>(state.arg(0)));
+    f.parent->release();
+}
+BENCH(siblings_build, SIBLING_COUNTS);
+
+void siblings_nearest(bench_state& state) {
+    state.pause();
+    flat_parent f;
+    buildFlatParent(f, static_cast<unsigned int>(state.arg(0)));
+    SiblingHash hash;
+    hash.build(f.dragged);
+    state.resume();
+
+    sibling_rect const* nearest[SiblingHash::maxNearest * SiblingHash::sideCount];
+    size_t i = 0;
+    while (state.next()) {
+        auto rect = queryRect(f, f.queries[i++ % f.queries.size()]);
+        keep(hash.nearest(rect, SiblingHash::maxNearest, nearest));
+    }
+
+    // checked against the brute force once, outside the timing
+    state.pause();
+    auto rects = siblingRects(f.dragged);
+    sibling_rect const* expected[SiblingHash::maxNearest * SiblingHash::sideCount];
+    size_t same = 0;
+    for (auto const& pos : f.queries) {
+        auto rect = queryRect(f, pos);
+        auto count = hash.nearest(rect, SiblingHash::maxNearest, nearest);
+        auto expectedCount = bruteNearest(rects, rect, SiblingHash::maxNearest, expected);
+        same += sameNearest(nearest, count, expected, expectedCount, rect);
+    }
+    state.counter("agreement", static_cast<double>(same) / static_cast<double>(f.queries.size()));
+    state.resume();
+
+    f.parent->release();
+}
+BENCH(siblings_nearest, SIBLING_COUNTS);
+
+void siblings_brute(bench_state& state) {
+    state.pause();
+    flat_parent f;
+    buildFlatParent(f, static_cast<unsigned int>(state.arg(0)));
+    auto rects = siblingRects(f.dragged);
+    state.resume();
+
+    sibling_rect const* nearest[SiblingHash::maxNearest * SiblingHash::sideCount];
+    size_t i = 0;
+    while (state.next()) {
+        auto rect = queryRect(f, f.queries[i++ % f.queries.size()]);
+        keep(bruteNearest(rects, rect, SiblingHash::maxNearest, nearest));
+    }
+
+    f.parent->release();
+}
+BENCH(siblings_brute, SIBLING_COUNTS);
@@ -0,0 +1,216 @@
+#include "bench.hpp"
+#include "synthetic_scene.hpp"
+#include "spatial_index.hpp"
+#include "scene_graph.hpp"
+#include <random>
+
+// hovering with the spatial index against the recursive walk it
+// replaced, which converted the mouse into every node's parent space
+// and collected all the hits to pick the topmost. the index cases are
+// a warm frame (validate a slice, refit, query), a cold one where the
+// index is built from scratch, and one with a few nodes coming and
+// going every frame that get patched in from the mirror's log
+
+namespace {
+    bool filterNode(CCNode* node, bool isContainer) {
+        if (!node->isVisible())
+            return false;
+        return isContainerNode(node) == isContainer;
+    }
+
+    // the pre-index getNodesUnderMouse
+    void linearNodesUnderMouse(CCNode* parent, CCArray* res, CCPoint mpos, bool containers) {
+        CCObject* obj;
+        CCARRAY_FOREACH(parent->getChildren(), obj) {
+            auto node = reinterpret_cast<CCNode*>(obj);
+
+            if (!node) continue;
+            if (!node->getParent()) continue;
+
+            auto pos = node->getPosition();
+            auto size = node->getScaledContentSize();
+            auto rect = CCRect { pos.x, pos.y, size.width, size.height };
+
+            rect.origin = rect.origin - rect.size / 2;
+
+            auto mposn = node->getParent()->convertToNodeSpace(mpos);
+
+            if (rect.containsPoint(mposn) && filterNode(node, containers))
+                res->addObject(node);
+
+            if (node->getChildrenCount() && !stopCheckingChildren(node))
+                linearNodesUnderMouse(node, res, mpos, containers);
+        }
+    }
+
+    CCNode* getTopMost(CCArray* nodes) {
+        CCObject* obj;
+        CCNode* res = nullptr;
+        CCARRAY_FOREACH(nodes, obj) {
+            auto node = reinterpret_cast<CCNode*>(obj);
+            if (!res || node->getZOrder() >= res->getZOrder())
+                res = node;
+        }
+        return res;
+    }
+
+    std::vector<CCPoint> mousePath(size_t count) {
+        std::mt19937 rng(7);
+        auto winSize = CCDirector::sharedDirector()->getWinSize();
+        std::uniform_real_distribution<float> x(0.0f, winSize.width), y(0.0f, winSize.height);
+
+        std::vector<CCPoint> res;
+        for (size_t i = 0; i < count; i++)
+            res.push_back({ x(rng), y(rng) });
+        return res;
+    }
+}
+
+#define HOVER_SIZES { 10000 }, { 100000 }
+
+void hover_linear(bench_state& state) {
+    auto s = sharedScene(state, state.arg(0));
+    if (!s)
+        return;
+
+    auto path = mousePath(256);
+    size_t i = 0;
+    while (state.next()) {
+        auto array = new CCArray();
+        linearNodesUnderMouse(s->root, array, path[i++ % path.size()], false);
+        keep(getTopMost(array));
+        array->release();
+    }
+}
+BENCH(hover_linear, HOVER_SIZES);
+
+void hover_index(bench_state& state) {
+    auto s = sharedScene(state, state.arg(0));
+    if (!s)
+        return;
+
+    auto director = CCDirector::sharedDirector();
+    auto path = mousePath(256);
+
+    state.pause();
+    SpatialIndex index;
+    index.build(s->root);
+    state.resume();
+
+    size_t i = 0;
+    while (state.next()) {
+        director->drawScene();
+        index.validateSlice(2048);
+        index.refresh();
+        keep(index.nodeAt(path[i++ % path.size()], false));
+    }
+}
+BENCH(hover_index, HOVER_SIZES);
+
+void hover_index_cold(bench_state& state) {
+    auto s = sharedScene(state, state.arg(0));
+    if (!s)
+        return;
+
+    auto path = mousePath(256);
+    size_t i = 0;
+    while (state.next()) {
+        SpatialIndex index;
+        index.build(s->root);
+        keep(index.nodeAt(path[i++ % path.size()], false));
+    }
+}
+BENCH(hover_index_cold, HOVER_SIZES);
+
+void hover_index_churn(bench_state& state) {
+    auto s = sharedScene(state, state.arg(0));
+    if (!s)
+        return;
+
+    auto director = CCDirector::sharedDirector();
+    auto path = mousePath(256);
+
+    // anything under the root, past the root itself
+    std::mt19937 rng(9);
+    std::uniform_int_distribution<size_t> pick(2, s->nodes.size() - 1);
+    std::vector<CCNode*> parents;
+    for (size_t i = 0; i < 1024; i++)
+        parents.push_back(s->nodes[pick(rng)]);
+
+    state.pause();
+    SpatialIndex index;
+    index.build(s->root);
+    state.resume();
+
+    constexpr size_t churn = 8;
+    std::vector<CCNode*> added;
+    size_t i = 0, rebuilds = 0;
+    while (state.next()) {
+        director->drawScene();
+
+        for (auto node : added) {
+            auto parent = node->getParent();
+            g_mirror.removing(parent, node);
+            parent->removeChild(node, true);
+        }
+        added.clear();
+
+        for (size_t j = 0; j < churn; j++) {
+            auto parent = parents[i % parents.size()];
+            auto node = new CCSprite();
+            node->setContentSize({ 24.0f, 24.0f });
+            parent->addChild(node);
+            node->release();
+            g_mirror.childrenChanged(parent);
+            added.push_back(node);
+        }
+
+        if (index.needsRebuild(s->root)) {
+            index.build(s->root);
+            rebuilds++;
+        } else {
+            index.validateSlice(2048);
+            index.refresh();
+        }
+        keep(index.nodeAt(path[i++ % path.size()], false));
+    }
+
+    state.pause();
+    for (auto node : added) {
+        auto parent = node->getParent();
+        g_mirror.removing(parent, node);
+        parent->removeChild(node, true);
+    }
+    g_mirror.sync(s->scene);
+    state.resume();
+
+    state.counter("rebuilds", static_cast<double>(rebuilds));
+}
+BENCH(hover_index_churn, HOVER_SIZES);
+
+// how often the index picks the node the walk would have. anything
+// under 1 should come from rotated or skewed nodes, which the walk
+// tested as if they were axis aligned in their parent's space
+void hover_agreement(bench_state& state) {
+    auto s = sharedScene(state, state.arg(0));
+    if (!s)
+        return;
+
+    auto path = mousePath(256);
+
+    state.pause();
+    SpatialIndex index;
+    index.build(s->root);
+    state.resume();
+
+    size_t i = 0, same = 0;
+    while (state.next()) {
+        auto pos = path[i++ % path.size()];
+        auto array = new CCArray();
+        linearNodesUnderMouse(s->root, array, pos, false);
+        same += getTopMost(array) == index.nodeAt(pos, false);
+        array->release();
+    }
+    state.counter("agreement", static_cast<double>(same) / static_cast<double>(state.iterations()));
+}
+BENCH(hover_agreement, HOVER_SIZES);
@@ -0,0 +1,7 @@
+#ifndef __MOCK_CCSCALE9SPRITE_H__
+#define __MOCK_CCSCALE9SPRITE_H__
+
+// the real header lives in the extensions, the mock keeps it with the rest
+#include "cocos2d.h"
+
+#endif
@@ -0,0 +1,577 @@
+#ifndef __MOCK_COCOS2D_H__
+#define __MOCK_COCOS2D_H__
+
+// a stand-in for the part of cocos2d-x 2.2 the explorer core uses, so
+// the core can be built and benchmarked without the game. the names,
+// signatures and behaviour (reference counting, lazily created child
+// arrays, nodeToParentTransform) follow cocos; anything the core
+// doesn't touch is left out. nothing here draws
+
+#include <cmath>
+#include <cfloat>
+#include <cstdint>
+#include <climits>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#define CC_DLL
+#define CC_DEGREES_TO_RADIANS(angle) ((angle) * 0.01745329252f)
+
+typedef unsigned char GLubyte;
+
+namespace cocos2d {
+
+class CCSize;
+
+class CCPoint {
+    public:
+        float x;
+        float y;
+
+        CCPoint() : x(0.0f), y(0.0f) {}
+        CCPoint(float x, float y) : x(x), y(y) {}
+        CCPoint(CCSize const& size);
+
+        CCPoint operator+(CCPoint const& right) const { return CCPoint(x + right.x, y + right.y); }
+        CCPoint operator-(CCPoint const& right) const { return CCPoint(x - right.x, y - right.y); }
+        CCPoint operator-() const { return CCPoint(-x, -y); }
+        CCPoint operator*(float a) const { return CCPoint(x * a, y * a); }
+        CCPoint operator/(float a) const { return CCPoint(x / a, y / a); }
+
+        bool equals(CCPoint const& target) const {
+            return std::fabs(x - target.x) < FLT_EPSILON && std::fabs(y - target.y) < FLT_EPSILON;
+        }
+        float getLength() const { return std::sqrt(x * x + y * y); }
+        float getDistance(CCPoint const& other) const { return (*this - other).getLength(); }
+};
+
+class CCSize {
+    public:
+        float width;
+        float height;
+
+        CCSize() : width(0.0f), height(0.0f) {}
+        CCSize(float width, float height) : width(width), height(height) {}
+        CCSize(CCPoint const& point) : width(point.x), height(point.y) {}
+
+        CCSize operator+(CCSize const& right) const { return CCSize(width + right.width, height + right.height); }
+        CCSize operator-(CCSize const& right) const { return CCSize(width - right.width, height - right.height); }
+        CCSize operator*(float a) const { return CCSize(width * a, height * a); }
+        CCSize operator/(float a) const { return CCSize(width / a, height / a); }
+
+        bool equals(CCSize const& target) const {
+            return std::fabs(width - target.width) < FLT_EPSILON && std::fabs(height - target.height) < FLT_EPSILON;
+        }
+};
+
+inline CCPoint::CCPoint(CCSize const& size) : x(size.width), y(size.height) {}
+
+class CCRect {
+    public:
+        CCPoint origin;
+        CCSize size;
+
+        CCRect() {}
+        CCRect(float x, float y, float width, float height) : origin(x, y), size(width, height) {}
+
+        float getMinX() const { return origin.x; }
+        float getMidX() const { return origin.x + size.width / 2.0f; }
+        float getMaxX() const { return origin.x + size.width; }
+        float getMinY() const { return origin.y; }
+        float getMidY() const { return origin.y + size.height / 2.0f; }
+        float getMaxY() const { return origin.y + size.height; }
+
+        bool equals(CCRect const& rect) const {
+            return origin.equals(rect.origin) && size.equals(rect.size);
+        }
+
+        bool containsPoint(CCPoint const& point) const {
+            return point.x >= getMinX() && point.x <= getMaxX() &&
+                point.y >= getMinY() && point.y <= getMaxY();
+        }
+
+        bool intersectsRect(CCRect const& rect) const {
+            return !(
+                getMaxX() < rect.getMinX() || rect.getMaxX() < getMinX() ||
+                getMaxY() < rect.getMinY() || rect.getMaxY() < getMinY()
+            );
+        }
+};
+
+#define CCPointZero CCPoint(0.0f, 0.0f)
+#define CCSizeZero CCSize(0.0f, 0.0f)
+#define CCRectZero CCRect(0.0f, 0.0f, 0.0f, 0.0f)
+
+inline CCPoint ccp(float x, float y) { return CCPoint(x, y); }
+inline float ccpDistance(CCPoint const& a, CCPoint const& b) { return a.getDistance(b); }
+
+struct ccColor3B {
+    GLubyte r;
+    GLubyte g;
+    GLubyte b;
+};
+
+inline ccColor3B ccc3(GLubyte r, GLubyte g, GLubyte b) { return { r, g, b }; }
+
+struct CCAffineTransform {
+    float a, b, c, d;
+    float tx, ty;
+};
+
+inline CCAffineTransform CCAffineTransformMake(float a, float b, float c, float d, float tx, float ty) {
+    return { a, b, c, d, tx, ty };
+}
+
+inline CCAffineTransform CCAffineTransformMakeIdentity() {
+    return CCAffineTransformMake(1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f);
+}
+
+inline CCPoint CCPointApplyAffineTransform(CCPoint const& point, CCAffineTransform const& t) {
+    return CCPoint(
+        t.a * point.x + t.c * point.y + t.tx,
+        t.b * point.x + t.d * point.y + t.ty
+    );
+}
+
+inline CCRect CCRectApplyAffineTransform(CCRect const& rect, CCAffineTransform const& t) {
+    auto top = rect.getMinY();
+    auto left = rect.getMinX();
+    auto right = rect.getMaxX();
+    auto bottom = rect.getMaxY();
+
+    auto topLeft = CCPointApplyAffineTransform(CCPoint(left, top), t);
+    auto topRight = CCPointApplyAffineTransform(CCPoint(right, top), t);
+    auto bottomLeft = CCPointApplyAffineTransform(CCPoint(left, bottom), t);
+    auto bottomRight = CCPointApplyAffineTransform(CCPoint(right, bottom), t);
+
+    auto minX = std::min({ topLeft.x, topRight.x, bottomLeft.x, bottomRight.x });
+    auto maxX = std::max({ topLeft.x, topRight.x, bottomLeft.x, bottomRight.x });
+    auto minY = std::min({ topLeft.y, topRight.y, bottomLeft.y, bottomRight.y });
+    auto maxY = std::max({ topLeft.y, topRight.y, bottomLeft.y, bottomRight.y });
+
+    return CCRect(minX, minY, maxX - minX, maxY - minY);
+}
+
+inline CCAffineTransform CCAffineTransformTranslate(CCAffineTransform const& t, float tx, float ty) {
+    return CCAffineTransformMake(t.a, t.b, t.c, t.d, t.tx + t.a * tx + t.c * ty, t.ty + t.b * tx + t.d * ty);
+}
+
+// t1 then t2
+inline CCAffineTransform CCAffineTransformConcat(CCAffineTransform const& t1, CCAffineTransform const& t2) {
+    return CCAffineTransformMake(
+        t1.a * t2.a + t1.b * t2.c, t1.a * t2.b + t1.b * t2.d,
+        t1.c * t2.a + t1.d * t2.c, t1.c * t2.b + t1.d * t2.d,
+        t1.tx * t2.a + t1.ty * t2.c + t2.tx,
+        t1.tx * t2.b + t1.ty * t2.d + t2.ty
+    );
+}
+
+inline CCAffineTransform CCAffineTransformInvert(CCAffineTransform const& t) {
+    auto determinant = 1.0f / (t.a * t.d - t.b * t.c);
+
+    return CCAffineTransformMake(
+        determinant * t.d, -determinant * t.b, -determinant * t.c, determinant * t.a,
+        determinant * (t.c * t.ty - t.d * t.tx), determinant * (t.b * t.tx - t.a * t.ty)
+    );
+}
+
+class CCObject {
+    public:
+        CCObject() : m_uReference(1) {}
+        virtual ~CCObject() {}
+
+        void retain() { m_uReference++; }
+        void release() {
+            if (!--m_uReference)
+                delete this;
+        }
+        unsigned int retainCount() const { return m_uReference; }
+
+    protected:
+        unsigned int m_uReference;
+};
+
+// CCArray retains what it holds, like the real one
+class CCArray : public CCObject {
+    public:
+        ~CCArray() { removeAllObjects(); }
+
+        unsigned int count() const { return static_cast<unsigned int>(m_objects.size()); }
+        CCObject* objectAtIndex(unsigned int index) const { return m_objects[index]; }
+        CCObject* lastObject() const { return m_objects.empty() ? nullptr : m_objects.back(); }
+
+        unsigned int indexOfObject(CCObject* object) const {
+            auto it = std::find(m_objects.begin(), m_objects.end(), object);
+            return it == m_objects.end() ? UINT_MAX : static_cast<unsigned int>(it - m_objects.begin());
+        }
+        bool containsObject(CCObject* object) const { return indexOfObject(object) != UINT_MAX; }
+
+        void addObject(CCObject* object) {
+            object->retain();
+            m_objects.push_back(object);
+        }
+        void insertObject(CCObject* object, unsigned int index) {
+            object->retain();
+            m_objects.insert(m_objects.begin() + index, object);
+        }
+        void removeObject(CCObject* object, bool releaseObj = true) {
+            auto it = std::find(m_objects.begin(), m_objects.end(), object);
+            if (it == m_objects.end())
+                return;
+            m_objects.erase(it);
+            if (releaseObj)
+                object->release();
+        }
+        void removeAllObjects() {
+            auto objects = std::move(m_objects);
+            m_objects.clear();
+            for (auto object : objects)
+                object->release();
+        }
+
+        // what CCARRAY_FOREACH walks, data->arr in the real one
+        CCObject** data() { return m_objects.data(); }
+
+    protected:
+        std::vector<CCObject*> m_objects;
+};
+
+#define CCARRAY_FOREACH(__array__, __object__) \
+    if ((__array__) && (__array__)->count() > 0) \
+    for (CCObject** __arr__ = (__array__)->data(), **__end__ = __arr__ + (__array__)->count() - 1; \
+        __arr__ <= __end__ && (((__object__) = *__arr__) != nullptr); \
+        __arr__++)
+
+class CCNode : public CCObject {
+    public:
+        ~CCNode() {
+            if (m_pChildren) {
+                CCObject* child;
+                CCARRAY_FOREACH(m_pChildren, child)
+                    static_cast<CCNode*>(child)->m_pParent = nullptr;
+                m_pChildren->release();
+            }
+        }
+
+        virtual void addChild(CCNode* child) { addChild(child, child->m_nZOrder, child->m_nTag); }
+        virtual void addChild(CCNode* child, int zOrder) { addChild(child, zOrder, child->m_nTag); }
+        virtual void addChild(CCNode* child, int zOrder, int tag) {
+            if (!m_pChildren)
+                m_pChildren = new CCArray();
+
+            // the real one appends and sorts by z before the next visit
+            auto index = m_pChildren->count();
+            while (index > 0 && static_cast<CCNode*>(m_pChildren->objectAtIndex(index - 1))->m_nZOrder > zOrder)
+                index--;
+            m_pChildren->insertObject(child, index);
+
+            child->m_nZOrder = zOrder;
+            child->m_nTag = tag;
+            child->m_pParent = this;
+            child->m_uOrderOfArrival = s_globalOrderOfArrival++;
+        }
+
+        virtual void removeChild(CCNode* child, bool) {
+            if (!m_pChildren || !m_pChildren->containsObject(child))
+                return;
+            child->m_pParent = nullptr;
+            m_pChildren->removeObject(child);
+        }
+        virtual void removeFromParentAndCleanup(bool cleanup) {
+            if (m_pParent)
+                m_pParent->removeChild(this, cleanup);
+        }
+        virtual void removeAllChildrenWithCleanup(bool) {
+            if (!m_pChildren)
+                return;
+            CCObject* child;
+            CCARRAY_FOREACH(m_pChildren, child)
+                static_cast<CCNode*>(child)->m_pParent = nullptr;
+            m_pChildren->removeAllObjects();
+        }
+
+        // nothing runs actions or timers here, only the recursion is kept
+        virtual void cleanup() {
+            CCObject* child;
+            CCARRAY_FOREACH(m_pChildren, child)
+                static_cast<CCNode*>(child)->cleanup();
+        }
+
+        virtual CCArray* getChildren() { return m_pChildren; }
+        virtual unsigned int getChildrenCount() const { return m_pChildren ? m_pChildren->count() : 0; }
+        virtual CCNode* getParent() { return m_pParent; }
+
+        virtual int getTag() const { return m_nTag; }
+        virtual void setTag(int tag) { m_nTag = tag; }
+        virtual int getZOrder() { return m_nZOrder; }
+        virtual void setZOrder(int zOrder) { m_nZOrder = zOrder; }
+        virtual unsigned int getOrderOfArrival() { return m_uOrderOfArrival; }
+        virtual void setOrderOfArrival(unsigned int order) { m_uOrderOfArrival = order; }
+        virtual bool isVisible() { return m_bVisible; }
+        virtual void setVisible(bool visible) { m_bVisible = visible; }
+
+        virtual CCPoint const& getPosition() { return m_obPosition; }
+        virtual void setPosition(CCPoint const& position) { m_obPosition = position; m_bTransformDirty = true; }
+        virtual float getPositionX() { return m_obPosition.x; }
+        virtual float getPositionY() { return m_obPosition.y; }
+        virtual void setPositionX(float x) { setPosition(CCPoint(x, m_obPosition.y)); }
+        virtual void setPositionY(float y) { setPosition(CCPoint(m_obPosition.x, y)); }
+
+        virtual CCPoint const& getAnchorPoint() { return m_obAnchorPoint; }
+        virtual void setAnchorPoint(CCPoint const& point) {
+            m_obAnchorPoint = point;
+            m_obAnchorPointInPoints = CCPoint(m_obContentSize.width * point.x, m_obContentSize.height * point.y);
+            m_bTransformDirty = true;
+        }
+        virtual CCSize const& getContentSize() const { return m_obContentSize; }
+        virtual void setContentSize(CCSize const& size) {
+            m_obContentSize = size;
+            setAnchorPoint(m_obAnchorPoint);
+        }
+        CCSize getScaledContentSize() {
+            return CCSize(m_obContentSize.width * m_fScaleX, m_obContentSize.height * m_fScaleY);
+        }
+        virtual bool isIgnoreAnchorPointForPosition() { return m_bIgnoreAnchorPointForPosition; }
+        virtual void ignoreAnchorPointForPosition(bool ignore) {
+            m_bIgnoreAnchorPointForPosition = ignore;
+            m_bTransformDirty = true;
+        }
+
+        virtual float getScale() { return m_fScaleX; }
+        virtual void setScale(float scale) { m_fScaleX = m_fScaleY = scale; m_bTransformDirty = true; }
+        virtual float getScaleX() { return m_fScaleX; }
+        virtual void setScaleX(float scale) { m_fScaleX = scale; m_bTransformDirty = true; }
+        virtual float getScaleY() { return m_fScaleY; }
+        virtual void setScaleY(float scale) { m_fScaleY = scale; m_bTransformDirty = true; }
+
+        virtual float getRotation() { return m_fRotationX; }
+        virtual void setRotation(float rotation) { m_fRotationX = m_fRotationY = rotation; m_bTransformDirty = true; }
+        virtual float getRotationX() { return m_fRotationX; }
+        virtual void setRotationX(float rotation) { m_fRotationX = rotation; m_bTransformDirty = true; }
+        virtual float getRotationY() { return m_fRotationY; }
+        virtual void setRotationY(float rotation) { m_fRotationY = rotation; m_bTransformDirty = true; }
+
+        virtual float getSkewX() { return m_fSkewX; }
+        virtual void setSkewX(float skew) { m_fSkewX = skew; m_bTransformDirty = true; }
+        virtual float getSkewY() { return m_fSkewY; }
+        virtual void setSkewY(float skew) { m_fSkewY = skew; m_bTransformDirty = true; }
+
+        // same math as CCNode::nodeToParentTransform in 2.2
+        virtual CCAffineTransform nodeToParentTransform() {
+            if (!m_bTransformDirty)
+                return m_sTransform;
+
+            auto x = m_obPosition.x;
+            auto y = m_obPosition.y;
+            if (m_bIgnoreAnchorPointForPosition) {
+                x += m_obAnchorPointInPoints.x;
+                y += m_obAnchorPointInPoints.y;
+            }
+
+            float cx = 1.0f, sx = 0.0f, cy = 1.0f, sy = 0.0f;
+            if (m_fRotationX || m_fRotationY) {
+                auto radiansX = -CC_DEGREES_TO_RADIANS(m_fRotationX);
+                auto radiansY = -CC_DEGREES_TO_RADIANS(m_fRotationY);
+                cx = std::cos(radiansX);
+                sx = std::sin(radiansX);
+                cy = std::cos(radiansY);
+                sy = std::sin(radiansY);
+            }
+
+            auto needsSkewMatrix = m_fSkewX || m_fSkewY;
+            auto hasAnchor = !m_obAnchorPointInPoints.equals(CCPointZero);
+            if (!needsSkewMatrix && hasAnchor) {
+                x += cy * -m_obAnchorPointInPoints.x * m_fScaleX + -sx * -m_obAnchorPointInPoints.y * m_fScaleY;
+                y += sy * -m_obAnchorPointInPoints.x * m_fScaleX + cx * -m_obAnchorPointInPoints.y * m_fScaleY;
+            }
+
+            m_sTransform = CCAffineTransformMake(cy * m_fScaleX, sy * m_fScaleX, -sx * m_fScaleY, cx * m_fScaleY, x, y);
+
+            if (needsSkewMatrix) {
+                auto skew = CCAffineTransformMake(
+                    1.0f, std::tan(CC_DEGREES_TO_RADIANS(m_fSkewY)),
+                    std::tan(CC_DEGREES_TO_RADIANS(m_fSkewX)), 1.0f,
+                    0.0f, 0.0f
+                );
+                m_sTransform = CCAffineTransformConcat(skew, m_sTransform);
+                if (hasAnchor)
+                    m_sTransform = CCAffineTransformTranslate(m_sTransform, -m_obAnchorPointInPoints.x, -m_obAnchorPointInPoints.y);
+            }
+
+            m_bTransformDirty = false;
+            return m_sTransform;
+        }
+
+        // these walk every ancestor each call, like the real ones
+        CCAffineTransform nodeToWorldTransform() {
+            auto t = this->nodeToParentTransform();
+            for (auto p = m_pParent; p; p = p->getParent())
+                t = CCAffineTransformConcat(t, p->nodeToParentTransform());
+            return t;
+        }
+        CCAffineTransform worldToNodeTransform() {
+            return CCAffineTransformInvert(this->nodeToWorldTransform());
+        }
+        CCPoint convertToNodeSpace(CCPoint const& worldPoint) {
+            return CCPointApplyAffineTransform(worldPoint, this->worldToNodeTransform());
+        }
+        CCPoint convertToWorldSpace(CCPoint const& nodePoint) {
+            return CCPointApplyAffineTransform(nodePoint, this->nodeToWorldTransform());
+        }
+
+    protected:
+        CCNode* m_pParent = nullptr;
+        CCArray* m_pChildren = nullptr;     // created with the first child
+        int m_nTag = -1;
+        int m_nZOrder = 0;
+        unsigned int m_uOrderOfArrival = 0;
+        bool m_bVisible = true;
+
+        CCPoint m_obPosition;
+        CCPoint m_obAnchorPoint;
+        CCPoint m_obAnchorPointInPoints;
+        CCSize m_obContentSize;
+        bool m_bIgnoreAnchorPointForPosition = false;
+        float m_fScaleX = 1.0f, m_fScaleY = 1.0f;
+        float m_fRotationX = 0.0f, m_fRotationY = 0.0f;
+        float m_fSkewX = 0.0f, m_fSkewY = 0.0f;
+
+        CCAffineTransform m_sTransform {};
+        bool m_bTransformDirty = true;
+
+        static inline unsigned int s_globalOrderOfArrival = 1;
+};
+
+class CCRGBAProtocol {
+    public:
+        virtual ~CCRGBAProtocol() {}
+
+        virtual void setColor(ccColor3B const& color) = 0;
+        virtual ccColor3B const& getColor() = 0;
+        virtual GLubyte getOpacity() = 0;
+        virtual void setOpacity(GLubyte opacity) = 0;
+};
+
+class CCLabelProtocol {
+    public:
+        virtual ~CCLabelProtocol() {}
+
+        virtual void setString(char const* label) = 0;
+        virtual char const* getString() = 0;
+};
+
+class CCNodeRGBA : public CCNode, public CCRGBAProtocol {
+    public:
+        void setColor(ccColor3B const& color) override { m_tColor = color; }
+        ccColor3B const& getColor() override { return m_tColor; }
+        GLubyte getOpacity() override { return m_cOpacity; }
+        void setOpacity(GLubyte opacity) override { m_cOpacity = opacity; }
+
+    protected:
+        ccColor3B m_tColor { 255, 255, 255 };
+        GLubyte m_cOpacity = 255;
+};
+
+// layers, scenes and menus are window sized and ignore their anchor
+class CCLayer : public CCNode {
+    public:
+        CCLayer() {
+            m_bIgnoreAnchorPointForPosition = true;
+            setAnchorPoint(CCPoint(0.5f, 0.5f));
+        }
+};
+
+class CCLayerRGBA : public CCLayer, public CCRGBAProtocol {
+    public:
+        void setColor(ccColor3B const& color) override { m_tColor = color; }
+        ccColor3B const& getColor() override { return m_tColor; }
+        GLubyte getOpacity() override { return m_cOpacity; }
+        void setOpacity(GLubyte opacity) override { m_cOpacity = opacity; }
+
+    protected:
+        ccColor3B m_tColor { 255, 255, 255 };
+        GLubyte m_cOpacity = 255;
+};
+
+class CCLayerColor : public CCLayerRGBA {};
+
+class CCScene : public CCNode {
+    public:
+        CCScene() {
+            m_bIgnoreAnchorPointForPosition = true;
+            setAnchorPoint(CCPoint(0.5f, 0.5f));
+        }
+};
+
+class CCTransitionScene : public CCScene {};
+
+class CCMenu : public CCLayerRGBA {};
+
+class CCSprite : public CCNodeRGBA {
+    public:
+        CCSprite() { setAnchorPoint(CCPoint(0.5f, 0.5f)); }
+};
+
+class CCSpriteBatchNode : public CCNode {};
+
+class CCMenuItem : public CCNodeRGBA {
+    public:
+        CCMenuItem() { setAnchorPoint(CCPoint(0.5f, 0.5f)); }
+};
+
+class CCMenuItemSprite : public CCMenuItem {};
+
+class CCLabelBMFont : public CCSpriteBatchNode, public CCLabelProtocol, public CCRGBAProtocol {
+    public:
+        CCLabelBMFont() { setAnchorPoint(CCPoint(0.5f, 0.5f)); }
+
+        void setString(char const* label) override { m_sString = label; }
+        char const* getString() override { return m_sString.c_str(); }
+
+        void setColor(ccColor3B const& color) override { m_tColor = color; }
+        ccColor3B const& getColor() override { return m_tColor; }
+        GLubyte getOpacity() override { return m_cOpacity; }
+        void setOpacity(GLubyte opacity) override { m_cOpacity = opacity; }
+
+    protected:
+        std::string m_sString;
+        ccColor3B m_tColor { 255, 255, 255 };
+        GLubyte m_cOpacity = 255;
+};
+
+class CCScale9Sprite : public CCNodeRGBA {};
+
+// the director is where the core gets the frame counter, the design
+// size and the running scene from. the benchmarks drive it by hand
+class CCDirector {
+    public:
+        static CCDirector* sharedDirector() {
+            static CCDirector director;
+            return &director;
+        }
+
+        CCScene* getRunningScene() { return m_pRunningScene; }
+        void runWithScene(CCScene* scene) {
+            if (scene)
+                scene->retain();
+            if (m_pRunningScene)
+                m_pRunningScene->release();
+            m_pRunningScene = scene;
+        }
+
+        CCSize getWinSize() { return m_obWinSizeInPoints; }
+        void setWinSize(CCSize const& size) { m_obWinSizeInPoints = size; }
+
+        unsigned int getTotalFrames() { return m_uTotalFrames; }
+        void drawScene() { m_uTotalFrames++; }
+
+    protected:
+        CCScene* m_pRunningScene = nullptr;
+        CCSize m_obWinSizeInPoints { 569.0f, 320.0f };
+        unsigned int m_uTotalFrames = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,157 @@
+#include "synthetic_scene.hpp"
+#include "scene_mirror.hpp"
+#include "frame_context.hpp"
+#include <deque>
+#include <random>
+#include <string>
+
+namespace {
+    // nested layers stop here, whatever the count
+    constexpr unsigned int s_maxDepth = 12;
+
+    synthetic_scene s_shared;
+    int64_t s_sharedCount = -1;
+}
+
+void buildSyntheticScene(synthetic_scene& out, unsigned int count, uint32_t seed) {
+    std::mt19937 rng(seed);
+    auto uniform = [&](float min, float max) {
+        return std::uniform_real_distribution<float>(min, max)(rng);
+    };
+    auto between = [&](int min, int max) {
+        return std::uniform_int_distribution<int>(min, max)(rng);
+    };
+
+    auto winSize = CCDirector::sharedDirector()->getWinSize();
+
+    out = {};
+    out.scene = new CCScene();
+    out.scene->setContentSize(winSize);
+    out.root = new CCLayer();
+    out.root->setContentSize(winSize);
+    out.scene->addChild(out.root);
+    out.root->release();
+
+    struct container {
+        CCNode* node;
+        unsigned int depth;
+        bool menu;
+    };
+    std::deque<container> open { { out.root, 0, false } };
+    unsigned int made = 1;
+
+    while (made < count && !open.empty()) {
+        auto parent = open.front();
+        open.pop_front();
+
+        auto area = parent.node->getContentSize();
+        if (area.width <= 0.0f || area.height <= 0.0f)
+            area = winSize;
+
+        auto children = between(4, 24);
+        for (int i = 0; i < children && made < count; i++) {
+            CCNode* child;
+            auto isContainer = false;
+            auto isMenu = false;
+            auto roll = uniform(0.0f, 1.0f);
+
+            if (parent.menu) {
+                child = new CCMenuItemSprite();
+                child->setContentSize({ uniform(20.0f, 120.0f), uniform(20.0f, 60.0f) });
+            } else if (roll < 0.12f && parent.depth < s_maxDepth) {
+                child = new CCLayer();
+                child->setContentSize(area * uniform(0.4f, 1.0f));
+                isContainer = true;
+            } else if (roll < 0.18f && parent.depth < s_maxDepth) {
+                child = new CCMenu();
+                child->setContentSize(area * uniform(0.2f, 0.6f));
+                isContainer = isMenu = true;
+            } else if (roll < 0.25f && parent.depth < s_maxDepth) {
+                // a plain node grouping a few others, sizeless like most are
+                child = new CCNode();
+                isContainer = true;
+            } else if (roll < 0.45f) {
+                auto label = new CCLabelBMFont();
+                label->setString(("Label " + std::to_string(made)).c_str());
+                label->setContentSize({ uniform(30.0f, 200.0f), uniform(12.0f, 32.0f) });
+                child = label;
+            } else {
+                child = new CCSprite();
+                child->setContentSize({ uniform(8.0f, 80.0f), uniform(8.0f, 80.0f) });
+            }
+
+            // a little past the parent's bounds on every side
+            child->setPosition({
+                uniform(-0.1f, 1.1f) * area.width,
+                uniform(-0.1f, 1.1f) * area.height
+            });
+            if (uniform(0.0f, 1.0f) < 0.1f)
+                child->setRotation(uniform(-180.0f, 180.0f));
+            if (uniform(0.0f, 1.0f) < 0.1f)
+                child->setScale(uniform(0.5f, 2.0f));
+            if (uniform(0.0f, 1.0f) < 0.05f)
+                child->setVisible(false);
+
+            parent.node->addChild(child, between(-2, 2), static_cast<int>(made));
+            child->release();
+            made++;
+
+            if (isContainer)
+                open.push_back({ child, parent.depth + 1, isMenu });
+        }
+    }
+
+    std::vector<CCNode*> stack { out.scene };
+    unsigned int widest = 0;
+    while (!stack.empty()) {
+        auto node = stack.back();
+        stack.pop_back();
+        out.nodes.push_back(node);
+
+        auto children = node->getChildrenCount();
+        if (!children) {
+            out.leaves.push_back(node);
+            continue;
+        }
+        if (children > widest) {
+            widest = children;
+            out.widestParent = node;
+        }
+
+        // pushed backwards so the first child comes out first
+        for (auto i = children; i-- > 0;)
+            stack.push_back(static_cast<CCNode*>(node->getChildren()->objectAtIndex(i)));
+    }
+}
+
+void destroySyntheticScene(synthetic_scene& scene) {
+    if (scene.scene)
+        scene.scene->release();
+    scene = {};
+}
+
+synthetic_scene* sharedScene(bench_state& state, int64_t count) {
+    if (count > g_benchMaxNodes) {
+        state.skip("over --max-nodes");
+        return nullptr;
+    }
+    if (count == s_sharedCount)
+        return &s_shared;
+
+    // building a big tree takes a while, it shouldn't count
+    state.pause();
+
+    auto director = CCDirector::sharedDirector();
+    director->runWithScene(nullptr);
+    g_mirror.sync(nullptr);
+    g_frame.invalidate();
+    destroySyntheticScene(s_shared);
+
+    buildSyntheticScene(s_shared, static_cast<unsigned int>(count));
+    s_sharedCount = count;
+    director->runWithScene(s_shared.scene);
+    g_mirror.sync(s_shared.scene);
+
+    state.resume();
+    return &s_shared;
+}
@@ -0,0 +1,32 @@
+#ifndef __SYNTHETIC_SCENE_HPP__
+#define __SYNTHETIC_SCENE_HPP__
+
+#include <vector>
+#include <cstdint>
+#include <cocos2d.h>
+#include "bench.hpp"
+
+using namespace cocos2d;
+
+// a made up scene shaped roughly like a game's: a layer holding nested
+// layers and menus a few levels deep, with sprites, labels and menu
+// items spread over (and a bit past) the window. the same count and
+// seed always give the same tree
+struct synthetic_scene {
+    CCScene* scene = nullptr;
+    CCLayer* root = nullptr;        // the scene's last child, what the explorer works on
+    std::vector<CCNode*> nodes;     // everything under the scene, depth first
+    std::vector<CCNode*> leaves;
+    CCNode* widestParent = nullptr; // the node with the most children
+};
+
+void buildSyntheticScene(synthetic_scene& out, unsigned int count, uint32_t seed = 1);
+void destroySyntheticScene(synthetic_scene& scene);
+
+// the scene of `count` nodes, built on first use and kept around until
+// a different size is asked for. it's also made the running scene and
+// mirrored, like it would be in the game. nullptr (and the run skipped)
+// if `count` is over --max-nodes
+synthetic_scene* sharedScene(bench_state& state, int64_t count);
+
+#endif
@@ -0,0 +1,206 @@
+#include "analysis.hpp"
+#include <chrono>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+    double msSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start
+        ).count();
+    }
+
+    void computeStats(scene_snapshot const& snap, scene_stats& out) {
+        auto start = std::chrono::steady_clock::now();
+        auto count = snap.size();
+
+        out.sequence = snap.sequence;
+        out.nodes = static_cast<unsigned int>(count);
+        out.visible = 0;
+        out.labels = 0;
+        out.maxDepth = 0;
+        out.offscreen = 0;
+        out.empty = 0;
+        out.types.clear();
+        out.captureMs = snap.captureMs;
+
+        // parents always come before their children, so one pass
+        // forward has every parent's world transform ready
+        std::vector<CCAffineTransform> world(count);
+        std::vector<uint8_t> shown(count);
+        std::unordered_map<node_type const*, unsigned int> types;
+
+        auto window = CCRect { 0.0f, 0.0f, snap.winSize.width, snap.winSize.height };
+
+        for (size_t i = 0; i < count; i++) {
+            auto parent = snap.parent[i];
+
+            auto parentWorld = parent == scene_snapshot::npos ? CCAffineTransformMakeIdentity() : world[parent];
+            world[i] = CCAffineTransformConcat(snap.transform[i], parentWorld);
+            shown[i] = snap.visible[i] && (parent == scene_snapshot::npos || shown[parent]);
+
+            types[snap.type[i]]++;
+            out.maxDepth = std::max(out.maxDepth, snap.depth[i]);
+            if (snap.text[i] != scene_snapshot::npos)
+                out.labels++;
+
+            if (!shown[i])
+                continue;
+            out.visible++;
+
+            if (snap.width[i] == 0.0f || snap.height[i] == 0.0f) {
+                out.empty++;
+                continue;
+            }
+
+            // the node's own transform has its anchor, scale, rotation
+            // and skew in it already
+            auto rect = CCRectApplyAffineTransform(CCRect {
+                0.0f, 0.0f, snap.width[i], snap.height[i]
+            }, world[i]);
+
+            if (!rect.intersectsRect(window))
+                out.offscreen++;
+        }
+
+        for (auto const& [type, n] : types)
+            out.types.push_back({ type->name, n });
+        std::sort(out.types.begin(), out.types.end(), [](type_count const& a, type_count const& b) {
+            return a.count > b.count;
+        });
+
+        out.analysisMs = msSince(start);
+    }
+
+    bool containsNoCase(char const* haystack, std::string const& needle) {
+        if (!haystack)
+            return false;
+
+        auto end = haystack + std::strlen(haystack);
+        auto it = std::search(haystack, end, needle.begin(), needle.end(), [](char a, char b) {
+            return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+        });
+        return it != end;
+    }
+
+    // class name or label text containing the query, or the tag if it's a number
+    void runSearch(scene_snapshot const& snap, std::string const& query, search_results& out) {
+        auto start = std::chrono::steady_clock::now();
+
+        out.sequence = snap.sequence;
+        out.query = query;
+        out.hits.clear();
+        out.total = 0;
+
+        if (!query.empty()) {
+            char* numEnd;
+            auto tag = static_cast<int>(std::strtol(query.c_str(), &numEnd, 10));
+            auto isTag = *numEnd == '\0';
+
+            for (size_t i = 0; i < snap.size(); i++) {
+                auto text = snap.textOf(static_cast<uint32_t>(i));
+                auto hit = isTag
+                    ? snap.tag[i] == tag
+                    : containsNoCase(snap.type[i]->name, query) || containsNoCase(text, query);
+                if (!hit)
+                    continue;
+
+                if (out.total++ < AnalysisPool::maxHits)
+                    out.hits.push_back({ snap.node[i], snap.type[i]->name, snap.tag[i], text ? text : "" });
+            }
+        }
+
+        out.analysisMs = msSince(start);
+    }
+}
+
+AnalysisPool::~AnalysisPool() {
+    this->shutdown();
+}
+
+void AnalysisPool::shutdown() {
+    if (m_threads.empty())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+
+    // a job that's already running finishes first, it writes into this
+    for (auto& t : m_threads)
+        t.join();
+    m_threads.clear();
+
+    m_jobs.clear();
+    m_pending.store(0, std::memory_order_release);
+    m_stop = false;
+}
+
+void AnalysisPool::start() {
+    for (unsigned int i = 0; i < workerCount; i++)
+        m_threads.emplace_back(&AnalysisPool::work, this);
+}
+
+void AnalysisPool::work() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+            if (m_stop)
+                return;
+
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+
+        job();
+        m_pending.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+void AnalysisPool::post(std::function<void()> job) {
+    m_pending.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back(std::move(job));
+    }
+    m_wake.notify_one();
+}
+
+std::shared_ptr<scene_snapshot> AnalysisPool::acquireSnapshot() {
+    if (!m_spare || m_spare.use_count() > 1)
+        m_spare = std::make_shared<scene_snapshot>();
+    return m_spare;
+}
+
+bool AnalysisPool::submit(std::shared_ptr<scene_snapshot const> snapshot, std::string const& query) {
+    if (this->busy())
+        return false;
+
+    if (m_threads.empty())
+        this->start();
+
+    // only one snapshot is in flight, so each job can keep its output
+    // around between runs and reuse its vectors
+    this->post([this, snapshot] {
+        computeStats(*snapshot, m_statsWork);
+        m_statsOut.publish(m_statsWork);
+    });
+    this->post([this, snapshot, query] {
+        runSearch(*snapshot, query, m_searchWork);
+        m_searchOut.publish(m_searchWork);
+    });
+
+    return true;
+}
+
+void AnalysisPool::poll() {
+    m_statsOut.take(m_stats);
+    m_searchOut.take(m_search);
+}
@@ -0,0 +1,129 @@
+#ifndef __ANALYSIS_HPP__
+#define __ANALYSIS_HPP__
+
+#include <mutex>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <condition_variable>
+#include "scene_snapshot.hpp"
+
+// hands values from one worker to the main thread. the worker swaps a
+// finished value in, the main thread swaps it out along with the one
+// it was showing, so both sides keep reusing the same two buffers. the
+// main thread only ever try_locks: if the worker is mid-swap it just
+// picks the value up next frame
+template <class T>
+class DoubleBuffer {
+    public:
+        void publish(T& value) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::swap(m_back, value);
+            m_fresh = true;
+        }
+
+        bool take(T& into) {
+            std::unique_lock<std::mutex> lock(m_mutex, std::try_to_lock);
+            if (!lock.owns_lock() || !m_fresh)
+                return false;
+
+            std::swap(m_back, into);
+            m_fresh = false;
+            return true;
+        }
+
+    protected:
+        std::mutex m_mutex;
+        T m_back {};
+        bool m_fresh = false;
+};
+
+struct type_count {
+    char const* name;
+    unsigned int count;
+};
+
+struct scene_stats {
+    uint64_t sequence;
+    unsigned int nodes;
+    unsigned int visible;       // along with all of their ancestors
+    unsigned int labels;
+    unsigned int maxDepth;
+    unsigned int offscreen;     // visible, but entirely outside the window
+    unsigned int empty;         // visible with no size
+    std::vector<type_count> types;  // most common first
+    double captureMs;
+    double analysisMs;
+};
+
+struct search_hit {
+    CCNode* node;               // only for looking up in the mirror again
+    char const* name;
+    int tag;
+    std::string text;
+};
+
+struct search_results {
+    uint64_t sequence;
+    std::string query;
+    std::vector<search_hit> hits;
+    unsigned int total;         // hits before the cap
+    double analysisMs;
+};
+
+// a couple of worker threads that work through snapshots of the scene.
+// the main thread takes a snapshot, submits it and keeps going; results
+// show up in stats() / search() on some later poll(). only one snapshot
+// is worked on at a time, submitting while busy is refused rather than
+// queued
+class AnalysisPool {
+    public:
+        static constexpr unsigned int workerCount = 2;
+        static constexpr unsigned int maxHits = 200;
+
+        ~AnalysisPool();
+
+        // stops and joins the workers. call it before unloading, the
+        // destructor only runs under the loader lock where joining
+        // could hang. submitting afterwards starts them again
+        void shutdown();
+
+        // a snapshot to capture into, reusing the last one's buffers if
+        // no worker holds onto it anymore
+        std::shared_ptr<scene_snapshot> acquireSnapshot();
+        bool submit(std::shared_ptr<scene_snapshot const> snapshot, std::string const& query);
+        bool busy() const { return m_pending.load(std::memory_order_acquire) != 0; }
+
+        void poll();
+
+        scene_stats const& stats() const { return m_stats; }
+        search_results const& search() const { return m_search; }
+
+    protected:
+        void start();
+        void work();
+        void post(std::function<void()> job);
+
+        std::vector<std::thread> m_threads;
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::deque<std::function<void()>> m_jobs;
+        bool m_stop = false;
+        std::atomic<unsigned int> m_pending { 0 };
+
+        std::shared_ptr<scene_snapshot> m_spare;
+
+        scene_stats m_statsWork {};
+        search_results m_searchWork {};
+        DoubleBuffer<scene_stats> m_statsOut;
+        DoubleBuffer<search_results> m_searchOut;
+        scene_stats m_stats {};
+        search_results m_search {};
+};
+
+#endif
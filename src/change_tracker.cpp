@@ -0,0 +1,127 @@
+#include "change_tracker.hpp"
+#include "properties.hpp"
+
+namespace {
+    size_t hashNode(CCNode* node) {
+        // nodes are at least 8 byte aligned, drop the bits that never change
+        auto key = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(node) >> 3);
+        return static_cast<size_t>(key * 0x9e3779b1u);
+    }
+
+    bool isPartOfScene(CCNode* node) {
+        while (node->getParent())
+            node = node->getParent();
+
+        return getNodeType(node).is(ntScene);
+    }
+}
+
+tracked_node& ChangeTracker::track(CCNode* node) {
+    auto slot = this->slotOf(node);
+    if (!m_slots.empty() && m_slots[slot] != emptySlot)
+        return m_entries[m_slots[slot] - 1];
+
+    // keep the load factor under a half
+    if ((m_entries.size() + 1) * 2 > m_slots.size()) {
+        this->rehash(m_slots.empty() ? 64 : m_slots.size() * 2);
+        slot = this->slotOf(node);
+    }
+
+    node->retain();
+
+    tracked_node entry;
+    entry.node = node;
+    entry.dirty = 0;
+    entry.unknown = 0;
+    entry.type = &getNodeType(node);
+    entry.baseline = captureNodeEdit(node, npAll, *entry.type);
+
+    m_entries.push_back(std::move(entry));
+    m_slots[slot] = static_cast<uint32_t>(m_entries.size());
+
+    return m_entries.back();
+}
+
+void ChangeTracker::mark(CCNode* node, unsigned int props) {
+    auto slot = this->slotOf(node);
+    auto known = !m_slots.empty() && m_slots[slot] != emptySlot;
+
+    auto& entry = this->track(node);
+
+    // the node was already changed by the time we first saw it, so
+    // the baseline can't be trusted for these
+    if (!known)
+        entry.unknown |= props;
+
+    if (!entry.dirty && props)
+        m_dirtyCount++;
+
+    entry.dirty |= props;
+}
+
+void ChangeTracker::prune() {
+    size_t kept = 0;
+    m_dirtyCount = 0;
+
+    for (auto& entry : m_entries) {
+        if (!isPartOfScene(entry.node)) {
+            entry.node->release();
+            continue;
+        }
+
+        if (entry.dirty)
+            m_dirtyCount++;
+
+        if (&m_entries[kept] != &entry)
+            m_entries[kept] = std::move(entry);
+        kept++;
+    }
+
+    if (kept == m_entries.size())
+        return;
+
+    m_entries.resize(kept);
+    this->rehash(m_slots.size());
+}
+
+void ChangeTracker::clear() {
+    for (auto& entry : m_entries)
+        entry.node->release();
+
+    m_entries.clear();
+    m_slots.clear();
+    m_dirtyCount = 0;
+}
+
+node_edit ChangeTracker::changesOf(tracked_node const& entry) const {
+    auto res = captureNodeEdit(entry.node, entry.dirty, *entry.type);
+
+    res.props = diffNodeEdit(res, entry.baseline, res.props) | (res.props & entry.unknown);
+
+    return res;
+}
+
+size_t ChangeTracker::slotOf(CCNode* node) const {
+    if (m_slots.empty())
+        return 0;
+
+    auto mask = m_slots.size() - 1;
+    auto slot = hashNode(node) & mask;
+
+    while (m_slots[slot] != emptySlot && m_entries[m_slots[slot] - 1].node != node)
+        slot = (slot + 1) & mask;
+
+    return slot;
+}
+
+void ChangeTracker::rehash(size_t slotCount) {
+    m_slots.assign(slotCount, emptySlot);
+
+    auto mask = slotCount - 1;
+    for (size_t i = 0; i < m_entries.size(); i++) {
+        auto slot = hashNode(m_entries[i].node) & mask;
+        while (m_slots[slot] != emptySlot)
+            slot = (slot + 1) & mask;
+        m_slots[slot] = static_cast<uint32_t>(i + 1);
+    }
+}
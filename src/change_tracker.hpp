@@ -0,0 +1,53 @@
+#ifndef __CHANGE_TRACKER_HPP__
+#define __CHANGE_TRACKER_HPP__
+
+#include <vector>
+#include <cstdint>
+#include <cocos2d.h>
+#include "scene.hpp"
+#include "node_types.hpp"
+
+using namespace cocos2d;
+
+struct tracked_node {
+    CCNode* node;
+    unsigned int dirty;         // node_prop bits touched since tracking began
+    unsigned int unknown;       // touched before tracking began, always saved
+    node_type const* type;
+    node_edit baseline;         // every property, as it was when first tracked
+};
+
+// the nodes modified in the current scene. maps each node to the
+// properties that were touched and their values from before the first
+// change, so a save only writes what actually differs. tracked nodes
+// are retained; ones that end up detached from their scene are pruned
+class ChangeTracker {
+    public:
+        // start tracking a node before it gets modified, so the baseline
+        // holds its original values. does nothing if already tracked
+        tracked_node& track(CCNode* node);
+        void mark(CCNode* node, unsigned int props);
+
+        // drop nodes that are no longer part of a scene
+        void prune();
+        void clear();
+
+        // the touched properties whose values differ from the baseline
+        node_edit changesOf(tracked_node const& entry) const;
+
+        std::vector<tracked_node> const& entries() const { return m_entries; }
+        unsigned int dirtyCount() const { return m_dirtyCount; }
+
+    protected:
+        static constexpr uint32_t emptySlot = 0;
+
+        size_t slotOf(CCNode* node) const;
+        void rehash(size_t slotCount);
+
+        // dense entries plus an open addressing table of entry index + 1
+        std::vector<tracked_node> m_entries;
+        std::vector<uint32_t> m_slots;
+        unsigned int m_dirtyCount = 0;
+};
+
+#endif
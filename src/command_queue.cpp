@@ -0,0 +1,59 @@
+#include "command_queue.hpp"
+#include <chrono>
+#include <algorithm>
+
+CommandQueue::CommandQueue() {
+    for (size_t i = 0; i < capacity; i++)
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    m_batch.reserve(capacity);
+}
+
+void CommandQueue::drain() {
+    auto start = std::chrono::steady_clock::now();
+
+    // take everything that's been published so far. anything pushed
+    // while the batch runs waits for the next drain
+    for (size_t n = 0; n < capacity; n++) {
+        auto& s = m_slots[m_dequeue & (capacity - 1)];
+        auto seq = s.sequence.load(std::memory_order_acquire);
+        if (seq != m_dequeue + 1)
+            break;
+
+        m_batch.push_back({ std::move(s.cmd), s.key });
+        s.sequence.store(m_dequeue + capacity, std::memory_order_release);
+        m_dequeue++;
+    }
+
+    for (size_t i = 0; i < m_batch.size(); i++)
+        if (m_batch[i].key.prop)
+            m_latest[m_batch[i].key] = i;
+
+    unsigned int coalesced = 0;
+    for (size_t i = 0; i < m_batch.size(); i++) {
+        auto& item = m_batch[i];
+        if (item.key.prop && m_latest[item.key] != i) {
+            coalesced++;
+            continue;
+        }
+        item.cmd();
+    }
+
+    auto depth = static_cast<unsigned int>(m_batch.size());
+
+    m_batch.clear();
+    m_latest.clear();
+
+    m_stats.depth = depth;
+    m_stats.maxDepth = std::max(m_stats.maxDepth, depth);
+    m_stats.coalesced += coalesced;
+    m_stats.executed += depth - coalesced;
+    m_stats.drainMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start
+    ).count();
+}
+
+command_queue_stats CommandQueue::stats() const {
+    auto res = m_stats;
+    res.dropped = m_dropped.load(std::memory_order_relaxed);
+    return res;
+}
@@ -0,0 +1,173 @@
+#ifndef __COMMAND_QUEUE_HPP__
+#define __COMMAND_QUEUE_HPP__
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <unordered_map>
+#include <vector>
+
+// a type-erased void() callable stored inline, without allocating
+class command {
+    public:
+        static constexpr size_t inlineSize = 48;
+
+        command() = default;
+        command(command const&) = delete;
+        command& operator=(command const&) = delete;
+
+        command(command&& other) noexcept {
+            *this = std::move(other);
+        }
+
+        command& operator=(command&& other) noexcept {
+            if (this != &other) {
+                this->reset();
+                if (other.m_ops) {
+                    other.m_ops->move(m_storage, other.m_storage);
+                    m_ops = other.m_ops;
+                    other.reset();
+                }
+            }
+            return *this;
+        }
+
+        ~command() {
+            this->reset();
+        }
+
+        template <class F>
+        void emplace(F&& fn) {
+            using fn_t = std::decay_t<F>;
+            static_assert(sizeof(fn_t) <= inlineSize, "command is too big to be stored inline");
+            static_assert(alignof(fn_t) <= alignof(std::max_align_t), "command is overaligned");
+
+            static constexpr ops table = {
+                [](void* self) { (*reinterpret_cast<fn_t*>(self))(); },
+                [](void* dst, void* src) { new (dst) fn_t(std::move(*reinterpret_cast<fn_t*>(src))); },
+                [](void* self) { reinterpret_cast<fn_t*>(self)->~fn_t(); },
+            };
+
+            this->reset();
+            new (m_storage) fn_t(std::forward<F>(fn));
+            m_ops = &table;
+        }
+
+        void operator()() {
+            if (m_ops)
+                m_ops->invoke(m_storage);
+        }
+
+        void reset() {
+            if (m_ops) {
+                m_ops->destroy(m_storage);
+                m_ops = nullptr;
+            }
+        }
+
+    protected:
+        struct ops {
+            void(*invoke)(void*);
+            void(*move)(void*, void*);
+            void(*destroy)(void*);
+        };
+
+        alignas(std::max_align_t) unsigned char m_storage[inlineSize];
+        ops const* m_ops = nullptr;
+};
+
+// commands with the same key pushed before the same drain replace each
+// other, only the last one runs. a zero prop means never coalesce
+struct command_key {
+    void const* target;
+    unsigned int prop;
+
+    bool operator==(command_key const& other) const {
+        return target == other.target && prop == other.prop;
+    }
+};
+
+struct command_key_hash {
+    size_t operator()(command_key const& key) const {
+        return std::hash<void const*>()(key.target) ^ (static_cast<size_t>(key.prop) * 0x9e3779b9u);
+    }
+};
+
+struct command_queue_stats {
+    unsigned int depth;         // commands run in the last drain
+    unsigned int maxDepth;
+    unsigned int coalesced;
+    unsigned int dropped;
+    unsigned long long executed;
+    double drainMs;
+};
+
+// bounded multi-producer single-consumer ring of commands to run on the
+// main thread. producers never block: a push into a full ring fails
+// and is counted as dropped
+class CommandQueue {
+    public:
+        static constexpr size_t capacity = 1024;
+
+        CommandQueue();
+
+        template <class F>
+        bool push(F&& fn, void const* target = nullptr, unsigned int prop = 0) {
+            auto pos = m_enqueue.load(std::memory_order_relaxed);
+            slot* s;
+
+            while (true) {
+                s = &m_slots[pos & (capacity - 1)];
+                auto seq = s->sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+
+                if (diff == 0) {
+                    if (m_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                } else if (diff < 0) {
+                    m_dropped.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                } else {
+                    pos = m_enqueue.load(std::memory_order_relaxed);
+                }
+            }
+
+            s->cmd.emplace(std::forward<F>(fn));
+            s->key = { target, prop };
+            s->sequence.store(pos + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        // consumer side, only ever call from the main thread
+        void drain();
+
+        command_queue_stats stats() const;
+
+    protected:
+        struct slot {
+            std::atomic<size_t> sequence;
+            command cmd;
+            command_key key;
+        };
+
+        struct pending {
+            command cmd;
+            command_key key;
+        };
+
+        slot m_slots[capacity];
+        alignas(64) std::atomic<size_t> m_enqueue { 0 };
+        alignas(64) size_t m_dequeue = 0;
+        std::atomic<unsigned int> m_dropped { 0 };
+
+        std::vector<pending> m_batch;
+        std::unordered_map<command_key, size_t, command_key_hash> m_latest;
+
+        command_queue_stats m_stats {};
+};
+
+#endif
@@ -0,0 +1,80 @@
+#include "draw_profiler.hpp"
+#include <algorithm>
+
+DrawProfiler g_drawProfiler;
+
+namespace {
+    // weight of the newest frame in the smoothed costs
+    constexpr float s_smoothing = 0.2f;
+}
+
+void DrawProfiler::endFrame() {
+    m_clock.update();
+
+    // a hook got switched off halfway through a visit
+    m_stack.clear();
+
+    if (!m_clock.ready()) {
+        m_samples.clear();
+        return;
+    }
+
+    m_frame++;
+    m_stats.nodes = static_cast<unsigned int>(m_samples.size());
+    m_stats.frameMs = 0.0f;
+    m_stats.maxExclusive = 0.0f;
+
+    auto toMs = [this](uint64_t ticks) {
+        return m_clock.toMs(ticks);
+    };
+
+    // a node visited more than once (e.g. into a render texture) is
+    // charged for all of them, so everything is summed up first
+    for (auto const& sample : m_samples) {
+        auto it = m_costs.find(sample.node);
+        if (it == m_costs.end()) {
+            m_costs[sample.node] = {
+                toMs(sample.inclusive), toMs(sample.exclusive), toMs(sample.draw), m_frame
+            };
+            continue;
+        }
+
+        auto& cost = it->second;
+        if (cost.frame != m_frame) {
+            cost.inclusive *= 1.0f - s_smoothing;
+            cost.exclusive *= 1.0f - s_smoothing;
+            cost.draw *= 1.0f - s_smoothing;
+            cost.frame = m_frame;
+        }
+        cost.inclusive += toMs(sample.inclusive) * s_smoothing;
+        cost.exclusive += toMs(sample.exclusive) * s_smoothing;
+        cost.draw += toMs(sample.draw) * s_smoothing;
+    }
+
+    // the scene is the last node to finish its visit
+    if (!m_samples.empty())
+        m_stats.frameMs = m_costs[m_samples.back().node].inclusive;
+    m_samples.clear();
+
+    // nodes that weren't drawn this frame may not exist anymore
+    for (auto it = m_costs.begin(); it != m_costs.end();) {
+        if (it->second.frame != m_frame) {
+            it = m_costs.erase(it);
+        } else {
+            m_stats.maxExclusive = std::max(m_stats.maxExclusive, it->second.exclusive);
+            it++;
+        }
+    }
+}
+
+void DrawProfiler::reset() {
+    m_stack.clear();
+    m_samples.clear();
+    m_costs.clear();
+    m_stats = {};
+}
+
+draw_cost const* DrawProfiler::costOf(CCNode* node) const {
+    auto it = m_costs.find(node);
+    return it == m_costs.end() ? nullptr : &it->second;
+}
@@ -0,0 +1,88 @@
+#ifndef __DRAW_PROFILER_HPP__
+#define __DRAW_PROFILER_HPP__
+
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include <cocos2d.h>
+#include "tsc_clock.hpp"
+
+using namespace cocos2d;
+
+// ms, smoothed over the last few frames
+struct draw_cost {
+    float inclusive;            // the node and everything visited under it
+    float exclusive;            // only its own transform, sorting and draw
+    float draw;                 // the part of exclusive spent in draw()
+    uint32_t frame;             // last frame it was visited in
+};
+
+struct draw_profiler_stats {
+    unsigned int nodes;         // visited last frame
+    float frameMs;              // the running scene's inclusive time
+    float maxExclusive;
+};
+
+// per node render times from the visit/draw hooks in main.cpp. those
+// hooks are only enabled while profiling, so none of this runs (or
+// costs anything) otherwise. a visit pushes a frame with its start
+// tick onto a stack, and on the way out its total is charged to the
+// parent's children, which gives the exclusive time without a second
+// pass. samples are only folded into the per node costs once a frame
+class DrawProfiler {
+    public:
+        void enter(CCNode* node) {
+            m_stack.push_back({ node, __rdtsc(), 0, 0 });
+        }
+
+        void leave() {
+            auto now = __rdtsc();
+            auto f = m_stack.back();
+            m_stack.pop_back();
+
+            auto total = now - f.start;
+            if (!m_stack.empty())
+                m_stack.back().children += total;
+            m_samples.push_back({ f.node, total, total - f.children, f.draw });
+        }
+
+        void drawn(uint64_t ticks) {
+            if (!m_stack.empty())
+                m_stack.back().draw += ticks;
+        }
+
+        // call once a frame, after the scene was drawn
+        void endFrame();
+        void reset();
+
+        // nullptr if the node wasn't drawn last frame
+        draw_cost const* costOf(CCNode* node) const;
+        std::unordered_map<CCNode*, draw_cost> const& costs() const { return m_costs; }
+        draw_profiler_stats const& stats() const { return m_stats; }
+
+    protected:
+        struct visit_frame {
+            CCNode* node;
+            uint64_t start;
+            uint64_t children;
+            uint64_t draw;
+        };
+
+        struct visit_sample {
+            CCNode* node;
+            uint64_t inclusive;
+            uint64_t exclusive;
+            uint64_t draw;
+        };
+
+        std::vector<visit_frame> m_stack;
+        std::vector<visit_sample> m_samples;
+        std::unordered_map<CCNode*, draw_cost> m_costs;
+        uint32_t m_frame = 0;
+        draw_profiler_stats m_stats {};
+        tsc_clock m_clock;
+};
+
+extern DrawProfiler g_drawProfiler;
+
+#endif
@@ -0,0 +1,412 @@
+#include "edit_store.hpp"
+#include "properties.hpp"
+#include <fstream>
+#include <iterator>
+#include <cstring>
+#include <cstdio>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace {
+    struct writer {
+        std::vector<uint8_t> data;
+
+        void varint(uint64_t v) {
+            while (v >= 0x80) {
+                data.push_back(static_cast<uint8_t>(v | 0x80));
+                v >>= 7;
+            }
+            data.push_back(static_cast<uint8_t>(v));
+        }
+
+        void zigzag(int64_t v) {
+            this->varint((static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+        }
+
+        void f32(float v) {
+            uint8_t bytes[sizeof(float)];
+            memcpy(bytes, &v, sizeof(float));
+            data.insert(data.end(), bytes, bytes + sizeof(float));
+        }
+
+        void byte(uint8_t v) {
+            data.push_back(v);
+        }
+    };
+
+    struct reader {
+        uint8_t const* cur;
+        uint8_t const* end;
+        bool ok = true;
+
+        size_t remaining() const {
+            return static_cast<size_t>(end - cur);
+        }
+
+        uint64_t varint() {
+            uint64_t res = 0;
+            for (unsigned int shift = 0; shift < 64; shift += 7) {
+                if (cur >= end) break;
+                auto b = *cur++;
+                res |= static_cast<uint64_t>(b & 0x7f) << shift;
+                if (!(b & 0x80))
+                    return res;
+            }
+            ok = false;
+            return 0;
+        }
+
+        int64_t zigzag() {
+            auto v = this->varint();
+            return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+        }
+
+        float f32() {
+            float v = 0.0f;
+            if (this->remaining() < sizeof(float)) {
+                ok = false;
+                return v;
+            }
+            memcpy(&v, cur, sizeof(float));
+            cur += sizeof(float);
+            return v;
+        }
+
+        uint8_t byte() {
+            if (cur >= end) {
+                ok = false;
+                return 0;
+            }
+            return *cur++;
+        }
+
+        // a count of items that each take at least one byte
+        size_t count() {
+            auto v = this->varint();
+            if (v > this->remaining()) {
+                ok = false;
+                return 0;
+            }
+            return static_cast<size_t>(v);
+        }
+    };
+
+    struct string_table {
+        std::unordered_map<std::string, uint32_t> ids;
+        std::vector<std::string const*> strings;
+
+        uint32_t intern(std::string const& str) {
+            auto it = ids.find(str);
+            if (it != ids.end())
+                return it->second;
+
+            auto id = static_cast<uint32_t>(strings.size());
+            auto res = ids.insert({ str, id });
+            strings.push_back(&res.first->first);
+            return id;
+        }
+    };
+
+    // how each property value type is laid out in the file
+    void encodeValue(writer& w, string_table&, CCPoint const& v) {
+        w.f32(v.x);
+        w.f32(v.y);
+    }
+
+    void encodeValue(writer& w, string_table&, CCSize const& v) {
+        w.f32(v.width);
+        w.f32(v.height);
+    }
+
+    void encodeValue(writer& w, string_table&, int v) {
+        w.zigzag(v);
+    }
+
+    void encodeValue(writer& w, string_table&, vec3f_t const& v) {
+        w.f32(v.x);
+        w.f32(v.y);
+        w.f32(v.both);
+    }
+
+    void encodeValue(writer& w, string_table&, bool v) {
+        w.byte(v);
+    }
+
+    void encodeValue(writer& w, string_table& table, std::string const& v) {
+        w.varint(table.intern(v));
+    }
+
+    void encodeValue(writer& w, string_table&, ccColor3B const& v) {
+        w.byte(v.r);
+        w.byte(v.g);
+        w.byte(v.b);
+    }
+
+    void encodeValue(writer& w, string_table&, GLubyte v) {
+        w.byte(v);
+    }
+
+    using string_list = std::vector<std::string>;
+
+    void decodeValue(reader& r, string_list const&, CCPoint& v) {
+        v.x = r.f32();
+        v.y = r.f32();
+    }
+
+    void decodeValue(reader& r, string_list const&, CCSize& v) {
+        v.width = r.f32();
+        v.height = r.f32();
+    }
+
+    void decodeValue(reader& r, string_list const&, int& v) {
+        v = static_cast<int>(r.zigzag());
+    }
+
+    void decodeValue(reader& r, string_list const&, vec3f_t& v) {
+        v.x = r.f32();
+        v.y = r.f32();
+        v.both = r.f32();
+    }
+
+    void decodeValue(reader& r, string_list const&, bool& v) {
+        v = r.byte();
+    }
+
+    void decodeValue(reader& r, string_list const& strings, std::string& v) {
+        auto id = r.varint();
+        if (id >= strings.size())
+            r.ok = false;
+        else
+            v = strings[static_cast<size_t>(id)];
+    }
+
+    void decodeValue(reader& r, string_list const&, ccColor3B& v) {
+        v.r = r.byte();
+        v.g = r.byte();
+        v.b = r.byte();
+    }
+
+    void decodeValue(reader& r, string_list const&, GLubyte& v) {
+        v = r.byte();
+    }
+}
+
+std::vector<uint8_t> edit_format::encode(scene_map const& scenes) {
+    string_table table;
+    writer body;
+
+    body.varint(scenes.size());
+    for (auto const& [name, scene] : scenes) {
+        body.varint(table.intern(name));
+        body.varint(scene.nodes.size());
+
+        for (auto const& [location, edit] : scene.nodes) {
+            body.varint(location.size());
+            for (auto ix : location)
+                body.varint(static_cast<uint32_t>(ix));
+
+            body.varint(edit.props);
+
+            forEachProperty([&](auto const& prop) {
+                if (edit.props & prop.bit)
+                    encodeValue(body, table, edit.*prop.field);
+            });
+        }
+    }
+
+    writer res;
+    res.data.insert(res.data.end(), magic, magic + sizeof(magic));
+    for (unsigned int i = 0; i < sizeof(version); i++)
+        res.byte(static_cast<uint8_t>(version >> (i * 8)));
+
+    res.varint(table.strings.size());
+    for (auto str : table.strings) {
+        res.varint(str->size());
+        res.data.insert(res.data.end(), str->begin(), str->end());
+    }
+
+    res.data.insert(res.data.end(), body.data.begin(), body.data.end());
+
+    return std::move(res.data);
+}
+
+bool edit_format::decode(uint8_t const* data, size_t size, scene_map& scenes) {
+    if (size < sizeof(magic) + sizeof(version))
+        return false;
+    if (memcmp(data, magic, sizeof(magic)))
+        return false;
+
+    uint32_t fileVersion = 0;
+    for (unsigned int i = 0; i < sizeof(version); i++)
+        fileVersion |= static_cast<uint32_t>(data[sizeof(magic) + i]) << (i * 8);
+    if (fileVersion != version)
+        return false;
+
+    reader r { data + sizeof(magic) + sizeof(version), data + size };
+
+    string_list strings(r.count());
+    for (auto& str : strings) {
+        auto len = r.count();
+        if (!r.ok) return false;
+        str.assign(reinterpret_cast<char const*>(r.cur), len);
+        r.cur += len;
+    }
+
+    scene_map res;
+
+    auto sceneCount = r.count();
+    for (size_t i = 0; r.ok && i < sceneCount; i++) {
+        std::string name;
+        decodeValue(r, strings, name);
+
+        auto& scene = res[name];
+        scene.rtti_name = name;
+
+        auto entryCount = r.count();
+        for (size_t j = 0; r.ok && j < entryCount; j++) {
+            std::vector<int> location(r.count());
+            for (auto& ix : location)
+                ix = static_cast<int>(r.varint());
+
+            node_edit edit;
+            edit.props = static_cast<unsigned int>(r.varint());
+
+            forEachProperty([&](auto const& prop) {
+                if (edit.props & prop.bit)
+                    decodeValue(r, strings, edit.*prop.field);
+            });
+
+            scene.nodes[std::move(location)] = std::move(edit);
+        }
+    }
+
+    if (!r.ok)
+        return false;
+
+    scenes = std::move(res);
+    return true;
+}
+
+EditStore::EditStore(std::string const& path) : m_path(path) {}
+
+EditStore::~EditStore() {
+    // globals go away under the loader lock, where waiting on a thread
+    // that still has to exit deadlocks. a writer that flush() didn't
+    // get to is left to the process
+    if (m_writer.joinable())
+        m_writer.detach();
+}
+
+void EditStore::flush() {
+    std::thread writer;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        writer = std::move(m_writer);
+    }
+
+    // it keeps going until nothing is pending
+    if (writer.joinable())
+        writer.join();
+}
+
+bool EditStore::load(scene_map& scenes) {
+#ifdef _WIN32
+    auto file = CreateFileA(
+        m_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr
+    );
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || !size.QuadPart) {
+        CloseHandle(file);
+        return false;
+    }
+
+    auto mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+
+    auto view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    auto res = view && edit_format::decode(
+        reinterpret_cast<uint8_t const*>(view), static_cast<size_t>(size.QuadPart), scenes
+    );
+
+    if (view)
+        UnmapViewOfFile(view);
+    CloseHandle(mapping);
+    CloseHandle(file);
+
+    return res;
+#else
+    std::ifstream file(m_path, std::ios::binary);
+    if (!file)
+        return false;
+
+    std::vector<uint8_t> data(
+        (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>()
+    );
+    return edit_format::decode(data.data(), data.size(), scenes);
+#endif
+}
+
+void EditStore::save(scene_map const& scenes) {
+    auto data = edit_format::encode(scenes);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_pending = std::move(data);
+    m_hasPending = true;
+
+    if (m_writing)
+        return;
+
+    // the previous writer has already finished its last write
+    if (m_writer.joinable())
+        m_writer.join();
+
+    m_writing = true;
+    m_writer = std::thread(&EditStore::writeLoop, this);
+}
+
+void EditStore::writeLoop() {
+    while (true) {
+        std::vector<uint8_t> data;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_hasPending) {
+                m_writing = false;
+                return;
+            }
+            data = std::move(m_pending);
+            m_hasPending = false;
+        }
+
+        this->writeFile(data);
+    }
+}
+
+bool EditStore::writeFile(std::vector<uint8_t> const& data) {
+    auto tmp = m_path + ".tmp";
+
+    {
+        std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return false;
+        file.write(reinterpret_cast<char const*>(data.data()), data.size());
+        if (!file.flush())
+            return false;
+    }
+
+#ifdef _WIN32
+    return MoveFileExA(tmp.c_str(), m_path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+    return !std::rename(tmp.c_str(), m_path.c_str());
+#endif
+}
@@ -0,0 +1,62 @@
+#ifndef __EDIT_STORE_HPP__
+#define __EDIT_STORE_HPP__
+
+#include <map>
+#include <mutex>
+#include <thread>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "scene.hpp"
+
+using scene_map = std::map<std::string, scene_edit>;
+
+// binary layout, all integers are LEB128 varints unless noted:
+//
+//   "CEXE" u32 version
+//   string count, { length, bytes }...
+//   scene count, {
+//       name (string index), entry count, {
+//           location length, location...,
+//           props, property values in node_prop bit order
+//       }...
+//   }...
+//
+// floats are stored as raw little-endian 32-bit values, z order is
+// zigzag encoded, text is a string index and colors are raw bytes
+namespace edit_format {
+    constexpr char magic[4] = { 'C', 'E', 'X', 'E' };
+    constexpr uint32_t version = 1;
+
+    std::vector<uint8_t> encode(scene_map const& scenes);
+    bool decode(uint8_t const* data, size_t size, scene_map& scenes);
+}
+
+// keeps scene edits on disk between sessions. the file is mapped and
+// decoded on startup; saves are encoded on the calling thread and then
+// written out to a temporary file that replaces the old one on a
+// background thread, so a crash mid-write never leaves a torn file
+class EditStore {
+    public:
+        EditStore(std::string const& path);
+        ~EditStore();
+
+        bool load(scene_map& scenes);
+        void save(scene_map const& scenes);
+        // waits until everything saved so far is on disk. the unload
+        // path calls it, the destructor never blocks
+        void flush();
+
+    protected:
+        void writeLoop();
+        bool writeFile(std::vector<uint8_t> const& data);
+
+        std::string m_path;
+        std::thread m_writer;
+        std::mutex m_mutex;
+        std::vector<uint8_t> m_pending;
+        bool m_hasPending = false;
+        bool m_writing = false;
+};
+
+#endif
@@ -0,0 +1,102 @@
+#include "frame_context.hpp"
+
+FrameContext g_frame;
+
+void FrameContext::sync() {
+    auto director = CCDirector::sharedDirector();
+
+    auto frame = director->getTotalFrames();
+    if (frame == m_frame)
+        return;
+
+    m_frame = frame;
+    m_winSize = director->getWinSize();
+    m_transforms.clear();
+}
+
+CCPoint FrameContext::toWindow(CCPoint const& world) {
+    this->sync();
+
+    return CCPoint {
+        world.x / m_winSize.width * m_windowSize.width,
+        m_windowSize.height - world.y / m_winSize.height * m_windowSize.height
+    };
+}
+
+CCRect FrameContext::toWindow(CCRect const& world) {
+    this->sync();
+
+    auto sx = m_windowSize.width / m_winSize.width;
+    auto sy = m_windowSize.height / m_winSize.height;
+
+    return CCRect {
+        world.origin.x * sx,
+        m_windowSize.height - (world.origin.y + world.size.height) * sy,
+        world.size.width * sx,
+        world.size.height * sy
+    };
+}
+
+CCSize FrameContext::windowSize() {
+    this->sync();
+    return m_windowSize;
+}
+
+FrameContext::cached_transform& FrameContext::transformOf(CCNode* node) {
+    auto it = m_transforms.find(node);
+    if (it != m_transforms.end())
+        return it->second;
+
+    cached_transform res;
+    res.hasInverse = false;
+
+    auto parent = node->getParent();
+    if (parent)
+        res.world = CCAffineTransformConcat(node->nodeToParentTransform(), this->transformOf(parent).world);
+    else
+        res.world = node->nodeToParentTransform();
+
+    return m_transforms.emplace(node, res).first->second;
+}
+
+CCAffineTransform const& FrameContext::worldTransform(CCNode* node) {
+    this->sync();
+    return this->transformOf(node).world;
+}
+
+CCPoint FrameContext::toWorld(CCNode* node, CCPoint const& local) {
+    return CCPointApplyAffineTransform(local, this->worldTransform(node));
+}
+
+CCPoint FrameContext::toNode(CCNode* node, CCPoint const& world) {
+    this->sync();
+
+    auto& t = this->transformOf(node);
+    if (!t.hasInverse) {
+        t.inverse = CCAffineTransformInvert(t.world);
+        t.hasInverse = true;
+    }
+
+    return CCPointApplyAffineTransform(world, t.inverse);
+}
+
+CCRect FrameContext::worldRect(CCNode* node) {
+    auto pos = node->getPosition();
+    auto size = node->getScaledContentSize();
+    auto rect = CCRect { pos.x, pos.y, size.width, size.height };
+
+    rect.origin = rect.origin - rect.size / 2;
+
+    return CCRectApplyAffineTransform(rect, this->worldTransform(node->getParent()));
+}
+
+void FrameContext::invalidate(CCNode* node) {
+    // descendants are only ever cached along with their ancestors, so
+    // if this node isn't cached nothing under it is either
+    if (m_transforms.count(node))
+        m_transforms.clear();
+}
+
+void FrameContext::invalidate() {
+    m_transforms.clear();
+}
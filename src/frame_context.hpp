@@ -0,0 +1,56 @@
+#ifndef __FRAME_CONTEXT_HPP__
+#define __FRAME_CONTEXT_HPP__
+
+#include <unordered_map>
+#include <cocos2d.h>
+
+using namespace cocos2d;
+
+// coordinate conversions for the current frame. the window mapping is
+// read once per frame, and world transforms are computed top-down: a
+// node's transform is its parent's cached one times its own, so every
+// ancestor is worked out once no matter how many descendants are asked
+// about. everything is dropped when the director moves on to the next
+// frame, or earlier if one of our own edits moves a cached node
+class FrameContext {
+    public:
+        // the size of the window in pixels, whoever draws into it
+        // sets this once a frame
+        void setWindowSize(CCSize const& size) { m_windowSize = size; }
+
+        // cocos world space to window pixels, with y pointing down
+        CCPoint toWindow(CCPoint const& world);
+        // the rect's origin ends up in the top left
+        CCRect toWindow(CCRect const& world);
+        CCSize windowSize();
+
+        CCAffineTransform const& worldTransform(CCNode* node);
+        // same as node->convertToWorldSpace / convertToNodeSpace
+        CCPoint toWorld(CCNode* node, CCPoint const& local);
+        CCPoint toNode(CCNode* node, CCPoint const& world);
+        // the node's content rect centered on its position, in world space
+        CCRect worldRect(CCNode* node);
+
+        // the node's transform changed, drop it and everything below it
+        void invalidate(CCNode* node);
+        void invalidate();
+
+    protected:
+        struct cached_transform {
+            CCAffineTransform world;
+            CCAffineTransform inverse;
+            bool hasInverse;
+        };
+
+        void sync();
+        cached_transform& transformOf(CCNode* node);
+
+        unsigned int m_frame = static_cast<unsigned int>(-1);
+        CCSize m_winSize;
+        CCSize m_windowSize;
+        std::unordered_map<CCNode*, cached_transform> m_transforms;
+};
+
+extern FrameContext g_frame;
+
+#endif
@@ -0,0 +1,3 @@
+#include "generation.hpp"
+
+SceneGeneration g_generation;
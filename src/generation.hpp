@@ -0,0 +1,74 @@
+#ifndef __GENERATION_HPP__
+#define __GENERATION_HPP__
+
+#include <cstdint>
+#include <cocos2d.h>
+#include "scene_mirror.hpp"
+
+using namespace cocos2d;
+
+enum gen_source : unsigned int {
+    gsStructure     = 1 << 0,   // children added, removed or reordered
+    gsProperties    = 1 << 1,   // a node was modified through the explorer
+    gsMouse         = 1 << 2,   // the mouse moved
+    gsEdits         = 1 << 3,   // the saved edits of some scene changed
+};
+
+// counters the explorer's derived views (tree rows, the scene summary,
+// hover hit-testing) are cached against. a view keeps the stamp of the
+// sources it depends on and only redoes its work once that changes
+class SceneGeneration {
+    public:
+        void bump(unsigned int sources) {
+            if (sources & gsProperties) m_properties++;
+            if (sources & gsMouse)      m_mouse++;
+            if (sources & gsEdits)      m_edits++;
+        }
+
+        void trackMouse(CCPoint const& pos) {
+            if (!pos.equals(m_mousePos)) {
+                m_mousePos = pos;
+                m_mouse++;
+            }
+        }
+
+        // every counter only goes up, so the sum changes whenever any
+        // of them does
+        uint32_t stamp(unsigned int sources) const {
+            uint32_t res = 0;
+            if (sources & gsStructure)  res += g_mirror.generation();
+            if (sources & gsProperties) res += m_properties;
+            if (sources & gsMouse)      res += m_mouse;
+            if (sources & gsEdits)      res += m_edits;
+            return res;
+        }
+
+    protected:
+        uint32_t m_properties = 0;
+        uint32_t m_mouse = 0;
+        uint32_t m_edits = 0;
+        CCPoint m_mousePos;
+};
+
+// the stamp a cached view was last built against
+struct generation_watch {
+    uint32_t stamp = 0;
+    bool valid = false;
+
+    // true (and remembers the stamp) if the view needs rebuilding
+    bool changed(uint32_t now) {
+        if (valid && now == stamp)
+            return false;
+        stamp = now;
+        valid = true;
+        return true;
+    }
+
+    void invalidate() {
+        valid = false;
+    }
+};
+
+extern SceneGeneration g_generation;
+
+#endif
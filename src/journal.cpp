@@ -0,0 +1,384 @@
+#include "journal.hpp"
+#include "properties.hpp"
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+    struct delta {
+        CCNode* node;
+        unsigned int props;
+        node_edit before;
+        node_edit after;
+    };
+
+    double now() {
+        return std::chrono::duration<double>(
+            std::chrono::steady_clock::now().time_since_epoch()
+        ).count();
+    }
+
+    template <class T>
+    void put(std::vector<uint8_t>& out, T const& v) {
+        uint8_t bytes[sizeof(T)];
+        memcpy(bytes, &v, sizeof(T));
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    void put(std::vector<uint8_t>& out, CCPoint const& v) {
+        put(out, v.x);
+        put(out, v.y);
+    }
+
+    void put(std::vector<uint8_t>& out, CCSize const& v) {
+        put(out, v.width);
+        put(out, v.height);
+    }
+
+    void put(std::vector<uint8_t>& out, std::string const& v) {
+        put(out, static_cast<uint32_t>(v.size()));
+        out.insert(out.end(), v.begin(), v.end());
+    }
+
+    template <class T>
+    void get(uint8_t const*& cur, T& v) {
+        memcpy(&v, cur, sizeof(T));
+        cur += sizeof(T);
+    }
+
+    void get(uint8_t const*& cur, CCPoint& v) {
+        get(cur, v.x);
+        get(cur, v.y);
+    }
+
+    void get(uint8_t const*& cur, CCSize& v) {
+        get(cur, v.width);
+        get(cur, v.height);
+    }
+
+    void get(uint8_t const*& cur, std::string& v) {
+        uint32_t len;
+        get(cur, len);
+        v.assign(reinterpret_cast<char const*>(cur), len);
+        cur += len;
+    }
+
+    void putValues(std::vector<uint8_t>& out, node_edit const& e, unsigned int props) {
+        forEachProperty([&](auto const& prop) {
+            if (props & prop.bit)
+                put(out, e.*prop.field);
+        });
+    }
+
+    void getValues(uint8_t const*& cur, node_edit& e, unsigned int props) {
+        e.props = props;
+        forEachProperty([&](auto const& prop) {
+            if (props & prop.bit)
+                get(cur, e.*prop.field);
+        });
+    }
+
+    // fills in the entry's nodes and deltas, doesn't retain anything
+    void encodeDeltas(journal_entry& entry, std::vector<delta> const& deltas) {
+        entry.nodes.clear();
+        entry.deltas.clear();
+
+        for (auto const& d : deltas) {
+            put(entry.deltas, static_cast<uint32_t>(entry.nodes.size()));
+            put(entry.deltas, static_cast<uint32_t>(d.props));
+            putValues(entry.deltas, d.before, d.props);
+            putValues(entry.deltas, d.after, d.props);
+
+            entry.nodes.push_back(d.node);
+        }
+    }
+
+    std::vector<delta> decodeDeltas(journal_entry const& entry) {
+        std::vector<delta> res;
+        res.reserve(entry.nodes.size());
+
+        auto cur = entry.deltas.data();
+        auto end = cur + entry.deltas.size();
+        while (cur < end) {
+            delta d;
+            uint32_t index, props;
+            get(cur, index);
+            get(cur, props);
+            d.node = entry.nodes[index];
+            d.props = props;
+            getValues(cur, d.before, d.props);
+            getValues(cur, d.after, d.props);
+            res.push_back(std::move(d));
+        }
+
+        return res;
+    }
+
+    void putBack(journal_entry const& entry) {
+        auto node = entry.nodes.front();
+        auto parent = entry.parent;
+
+        parent->addChild(node, entry.z_order, entry.tag);
+        node->setOrderOfArrival(entry.order_of_arrival);
+
+        // back to the same index, or saved edits would end up on the
+        // wrong node
+        auto children = parent->getChildren();
+        if (entry.index < children->count()) {
+            children->removeObject(node);
+            children->insertObject(node, entry.index);
+        }
+    }
+}
+
+size_t journal_entry::bytes() const {
+    return sizeof(journal_entry) + deltas.size() + nodes.size() * sizeof(CCNode*);
+}
+
+Journal::Journal(size_t budget) : m_budget(budget) {}
+
+void Journal::begin(void const* key) {
+    if (!m_depth++)
+        m_key = key;
+}
+
+void Journal::touch(CCNode* node, unsigned int props) {
+    if (!m_depth)
+        return;
+
+    auto it = m_touchedIndex.find(node);
+    if (it != m_touchedIndex.end()) {
+        auto& p = m_touched[it->second];
+        auto missing = props & ~p.before.props;
+        if (missing)
+            mergeNodeEdit(p.before, captureNodeEdit(node, missing, *p.type));
+        return;
+    }
+
+    node->retain();
+
+    pending p;
+    p.node = node;
+    p.type = &getNodeType(node);
+    p.before = captureNodeEdit(node, props, *p.type);
+
+    m_touchedIndex[node] = m_touched.size();
+    m_touched.push_back(std::move(p));
+}
+
+void Journal::commit() {
+    if (!m_depth || --m_depth)
+        return;
+
+    std::vector<delta> changes;
+    for (auto& p : m_touched) {
+        auto after = captureNodeEdit(p.node, p.before.props, *p.type);
+        auto props = diffNodeEdit(p.before, after, p.before.props);
+        if (props)
+            changes.push_back({ p.node, props, p.before, std::move(after) });
+    }
+
+    if (!changes.empty()) {
+        auto time = now();
+
+        auto coalesce =
+            m_key && m_cursor && m_cursor == m_entries.size() &&
+            m_entries.back().kind == jkProps &&
+            m_entries.back().key == m_key &&
+            time - m_entries.back().time < coalesceWindow;
+
+        if (coalesce) {
+            auto& last = m_entries.back();
+            auto merged = decodeDeltas(last);
+
+            std::unordered_map<CCNode*, size_t> index;
+            for (size_t i = 0; i < merged.size(); i++)
+                index[merged[i].node] = i;
+
+            for (auto& c : changes) {
+                auto it = index.find(c.node);
+                if (it == index.end()) {
+                    index[c.node] = merged.size();
+                    merged.push_back(std::move(c));
+                    continue;
+                }
+
+                // keep the oldest value of everything, the newest after
+                auto& m = merged[it->second];
+                auto older = c.before;
+                older.props = c.props & ~m.props;
+                mergeNodeEdit(m.before, older);
+                mergeNodeEdit(m.after, c.after);
+                m.props |= c.props;
+            }
+
+            // dragging something back to where it was is no change at all
+            for (auto& m : merged)
+                m.props = diffNodeEdit(m.before, m.after, m.props);
+            merged.erase(
+                std::remove_if(merged.begin(), merged.end(), [](delta const& d) { return !d.props; }),
+                merged.end()
+            );
+
+            auto oldNodes = std::move(last.nodes);
+            m_bytes -= last.bytes();
+
+            encodeDeltas(last, merged);
+            last.time = time;
+            for (auto node : last.nodes)
+                node->retain();
+            for (auto node : oldNodes)
+                node->release();
+
+            if (merged.empty()) {
+                m_entries.pop_back();
+                m_cursor--;
+            } else {
+                m_bytes += last.bytes();
+            }
+        } else {
+            journal_entry entry {};
+            entry.kind = jkProps;
+            entry.key = m_key;
+            entry.time = time;
+            encodeDeltas(entry, changes);
+            for (auto node : entry.nodes)
+                node->retain();
+
+            this->push(std::move(entry));
+        }
+    }
+
+    for (auto& p : m_touched)
+        p.node->release();
+    m_touched.clear();
+    m_touchedIndex.clear();
+    m_key = nullptr;
+}
+
+void Journal::deleteNode(CCNode* node) {
+    auto parent = node->getParent();
+    if (!parent)
+        return;
+
+    journal_entry entry {};
+    entry.kind = jkDelete;
+    entry.time = now();
+    entry.nodes.push_back(node);
+    entry.parent = parent;
+    entry.index = parent->getChildren()->indexOfObject(node);
+    entry.z_order = node->getZOrder();
+    entry.tag = node->getTag();
+    entry.order_of_arrival = node->getOrderOfArrival();
+
+    node->retain();
+    parent->retain();
+
+    node->removeFromParentAndCleanup(false);
+
+    this->push(std::move(entry));
+}
+
+journal_step Journal::undo() {
+    if (!m_cursor || m_depth)
+        return { false, false };
+
+    auto& entry = m_entries[--m_cursor];
+
+    if (entry.kind == jkDelete) {
+        putBack(entry);
+        return { true, true };
+    }
+
+    auto deltas = decodeDeltas(entry);
+    for (auto it = deltas.rbegin(); it != deltas.rend(); ++it) {
+        applyNodeEdit(it->node, it->before);
+        if (m_onModified)
+            m_onModified(it->node, it->props);
+    }
+
+    return { true, false };
+}
+
+journal_step Journal::redo() {
+    if (m_cursor == m_entries.size() || m_depth)
+        return { false, false };
+
+    auto& entry = m_entries[m_cursor++];
+
+    if (entry.kind == jkDelete) {
+        entry.nodes.front()->removeFromParentAndCleanup(false);
+        return { true, true };
+    }
+
+    for (auto& d : decodeDeltas(entry)) {
+        applyNodeEdit(d.node, d.after);
+        if (m_onModified)
+            m_onModified(d.node, d.props);
+    }
+
+    return { true, false };
+}
+
+void Journal::clear() {
+    for (auto& entry : m_entries)
+        this->release(entry);
+    m_entries.clear();
+    m_cursor = 0;
+    m_bytes = 0;
+
+    for (auto& p : m_touched)
+        p.node->release();
+    m_touched.clear();
+    m_touchedIndex.clear();
+    m_depth = 0;
+    m_key = nullptr;
+}
+
+void Journal::setBudget(size_t bytes) {
+    m_budget = bytes;
+    this->evict();
+}
+
+void Journal::push(journal_entry&& entry) {
+    this->dropRedo();
+
+    m_bytes += entry.bytes();
+    m_entries.push_back(std::move(entry));
+    m_cursor = m_entries.size();
+
+    this->evict();
+}
+
+void Journal::dropRedo() {
+    while (m_entries.size() > m_cursor) {
+        m_bytes -= m_entries.back().bytes();
+        this->release(m_entries.back());
+        m_entries.pop_back();
+    }
+}
+
+void Journal::evict() {
+    // the newest entry is always kept, however big it is
+    while (m_bytes > m_budget && m_entries.size() > 1 && m_cursor) {
+        m_bytes -= m_entries.front().bytes();
+        this->release(m_entries.front());
+        m_entries.pop_front();
+        m_cursor--;
+    }
+}
+
+void Journal::release(journal_entry& entry) {
+    // a deleted node that was never put back still has its actions and
+    // timers, detaching it skipped the cleanup so undo could restore them
+    if (entry.kind == jkDelete) {
+        auto node = entry.nodes.front();
+        if (!node->getParent())
+            node->cleanup();
+    }
+
+    for (auto node : entry.nodes)
+        node->release();
+    if (entry.kind == jkDelete)
+        entry.parent->release();
+}
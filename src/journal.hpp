@@ -0,0 +1,102 @@
+#ifndef __JOURNAL_HPP__
+#define __JOURNAL_HPP__
+
+#include <deque>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include <cocos2d.h>
+#include "scene.hpp"
+#include "node_types.hpp"
+
+using namespace cocos2d;
+
+enum journal_kind {
+    jkProps,
+    jkDelete,
+};
+
+struct journal_entry {
+    journal_kind kind;
+    void const* key;            // commits with the same key close together are merged
+    double time;                // seconds, when last committed to
+    std::vector<CCNode*> nodes; // retained
+
+    // jkProps: { node index u32, props u32, before values, after values }...
+    // only the values of the set props are written, in node_prop bit order
+    std::vector<uint8_t> deltas;
+
+    // jkDelete: nodes[0] is the removed node
+    CCNode* parent;             // retained
+    unsigned int index;
+    int z_order;
+    int tag;
+    int order_of_arrival;
+
+    size_t bytes() const;
+};
+
+struct journal_step {
+    bool applied;
+    bool structural;            // nodes were added to or removed from the tree
+};
+
+// undo history of editor changes. property changes are collected in a
+// transaction: touch() every node before changing it and commit() once
+// done, which records only the values that actually changed. the oldest
+// entries are dropped once the history grows over its byte budget
+class Journal {
+    public:
+        static constexpr double coalesceWindow = 0.5;
+
+        // told about every node undo/redo changed the properties of
+        using modified_fn = void(*)(CCNode* node, unsigned int props);
+
+        Journal(size_t budget);
+
+        void setModifiedHandler(modified_fn onModified) { m_onModified = onModified; }
+
+        // transactions nest, only the outermost commit records anything
+        void begin(void const* key = nullptr);
+        void touch(CCNode* node, unsigned int props);
+        void commit();
+
+        // removes the node from its parent without cleaning it up, so it
+        // can be put back. it stays alive until its entry is dropped
+        void deleteNode(CCNode* node);
+
+        journal_step undo();
+        journal_step redo();
+        void clear();
+
+        void setBudget(size_t bytes);
+        size_t budget() const { return m_budget; }
+        size_t bytes() const { return m_bytes; }
+        size_t size() const { return m_entries.size(); }
+        size_t undoCount() const { return m_cursor; }
+
+    protected:
+        struct pending {
+            CCNode* node;
+            node_type const* type;
+            node_edit before;
+        };
+
+        void push(journal_entry&& entry);
+        void dropRedo();
+        void evict();
+        void release(journal_entry& entry);
+
+        std::deque<journal_entry> m_entries;
+        size_t m_cursor = 0;    // entries before this can be undone
+        size_t m_bytes = 0;
+        size_t m_budget;
+        modified_fn m_onModified = nullptr;
+
+        unsigned int m_depth = 0;
+        void const* m_key = nullptr;
+        std::vector<pending> m_touched;
+        std::unordered_map<CCNode*, size_t> m_touchedIndex;
+};
+
+#endif
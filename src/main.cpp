@@ -5,11 +5,36 @@
 #include <imgui.h>
 #include <imgui_hook.h>
 #include <MinHook.h>
-#include <queue>
-#include <mutex>
+#include <memory>
 #include <fstream>
 #include <sstream>
+#include <typeinfo>
+#include <algorithm>
 #include "scene.hpp"
+#include "spatial_index.hpp"
+#include "ui/tree_view.hpp"
+#include "snapping.hpp"
+#include "edit_store.hpp"
+#include "command_queue.hpp"
+#include "change_tracker.hpp"
+#include "journal.hpp"
+#include "node_types.hpp"
+#include "properties.hpp"
+#include "frame_context.hpp"
+#include "ui/overlay.hpp"
+#include "scene_mirror.hpp"
+#include "generation.hpp"
+#include "task_scheduler.hpp"
+#include "scene_snapshot.hpp"
+#include "analysis.hpp"
+#include "profiler.hpp"
+#include "scene_graph.hpp"
+#include "search_index.hpp"
+#include "selector.hpp"
+#include "draw_profiler.hpp"
+#include "sched_profiler.hpp"
+#include "ui/profiler_panel.hpp"
+#include "ui/sched_profiler_panel.hpp"
 
 // #define GD_CONSOLE
 
@@ -20,12 +45,6 @@ CCNode* getLastChild(CCNode* par) {
 using namespace cocos2d;
 using namespace cocos2d::extension;
 
-const char* getNodeName(CCNode* node) {
-    if (node == nullptr) return "nullptr";
-    const char* name = typeid(*node).name() + 6;
-    return name;
-}
-
 void clipboardText(const char* text) {
     if (!OpenClipboard(NULL)) return;
     if (!EmptyClipboard()) return;
@@ -37,14 +56,9 @@ void clipboardText(const char* text) {
     CloseClipboard();
 }
 
-bool operator!=(const CCSize& a, const CCSize& b) { return a.width != b.width || a.height != b.height; }
-
-bool operator!=(const ccColor3B& a, const ccColor3B& b) {
-    return a.r != b.r || a.b != b.b || a.g != b.g;
-}
-
-std::queue<std::function<void()>> threadFunctions;
-std::mutex threadFunctionsMutex;
+CommandQueue g_mainQueue;
+float g_taskBudgetMs = 1.0f;
+unsigned int editLoadTask = 0;
 enum edit_t { eNormal, eEdit, } editMode;
 CCNode* highlightedNode = nullptr;
 CCNode* selectedNode = nullptr;
@@ -63,8 +77,12 @@ bool saveChanges = false;
 bool onlyDeleteSelected = false;
 constexpr const float strokeSize = 3.0f;
 std::vector<int> openLocation;
-std::map<std::string, scene_edit> scenes;
-std::set<CCNode*> changedNodes;
+scene_map scenes;
+EditStore g_editStore("CocosExplorer.edits");
+ChangeTracker g_changes;
+Journal g_journal(4 << 20);
+int g_journalBudgetKb = 4096;
+bool journalingDrag = false;
 bool g_showWindow = true;
 bool selectionMoved = false;
 int mouseBtnDown = -1;
@@ -75,40 +93,45 @@ bool addPopupOpen = false;
 CCNode* addTarget = nullptr;
 std::string movedToScene = "";
 float g_snapThreshold = 10.0f;
+Overlay g_overlay;
+bool showBoundsEnabled = false;
+generation_watch hoverWatch;
+CCNode* hoveredNode = nullptr;
+bool hoverAdding = false;
+bool hoverIdle = false;
+generation_watch summaryWatch;
+std::string sceneSummary;
+AnalysisPool g_analysis;
+bool analysisEnabled = false;
+char analysisQuery[128] = "";
+uint64_t snapshotSequence = 0;
+generation_watch snapshotWatch;
+double lastSnapshotTime = 0.0;
+bool profilerEnabled = false;
+SearchIndex g_searchIndex;
+char searchText[128] = "";
+std::string searchRan;
+search_query searchQuery;
+generation_watch searchWatch;
+uint32_t searchVersion = 0;
+Selector g_selector;
+char selectorText[256] = "";
+std::vector<CCNode*> g_selection;
+float selectionOffset[2] = { 0.0f, 0.0f };
+float selectionScale = 1.0f;
+bool drawProfilerEnabled = false;
+bool drawHeatEnabled = true;
+std::vector<void*> drawHookTargets;
+bool schedProfilerEnabled = false;
+std::vector<void*> schedHookTargets;
+SpatialIndex g_nodeIndex;
+TreeView g_treeView;
+AlignmentIndex g_alignIndex;
+SiblingHash g_siblingHash;
+SpacingIndex g_spacingIndex;
 
 float temp_dist_left = 0.0f;
 
-std::vector<int> getNodeLocationInTree(CCNode* node) {
-    auto c = node;
-
-    std::vector<int> res;
-
-    while (c->getParent()) {
-        auto par = c->getParent();
-        res.push_back(par->getChildren()->indexOfObject(c));
-        c = par;
-    }
-
-    res.push_back(0);
-
-    std::reverse(res.begin(), res.end());
-
-    return res;
-}
-
-CCNode* getNodeByTreeLocation(CCNode* start, std::vector<int> const& loc) {
-    CCNode* res = start;
-
-    for (auto l : loc) {
-        if (static_cast<int>(res->getChildrenCount()) <= l)
-            return nullptr;
-
-        res = reinterpret_cast<CCNode*>(res->getChildren()->objectAtIndex(l));
-    }
-
-    return res;
-}
-
 class CCTransitionSceneGetter : public CCTransitionScene {
     public:
         CCScene* getInScene() {
@@ -119,6 +142,13 @@ class CCTransitionSceneGetter : public CCTransitionScene {
         }
 };
 
+class CCTimerGetter : public CCTimer {
+    public:
+        CCObject* getTarget() {
+            return m_pTarget;
+        }
+};
+
 void sortArray(CCArray* pArray) {
     std::qsort(
         pArray->data->arr,
@@ -133,161 +163,64 @@ void sortArray(CCArray* pArray) {
     );
 }
 
-void registerNodeAsModified(CCNode* node) {
-    changedNodes.insert(node);
+void registerNodeAsModified(CCNode* node, unsigned int props) {
+    g_changes.mark(node, props);
+    g_frame.invalidate(node);
+    g_nodeIndex.markDirty(node);
+    g_searchIndex.touch(node);
+    g_generation.bump(gsProperties);
 }
 
 void loadSceneChanges(CCScene* scene) {
-    if (dynamic_cast<CCTransitionScene*>(scene)) {
-        scene = dynamic_cast<CCTransitionSceneGetter*>(scene)->getInScene();
+    if (getNodeType(scene).is(ntTransition)) {
+        scene = reinterpret_cast<CCTransitionSceneGetter*>(scene)->getInScene();
     }
 
     auto name = getNodeName(reinterpret_cast<CCNode*>(scene->getChildren()->objectAtIndex(0)));
 
-    std::string trees = "";
+    movedToScene = name;
 
     if (scenes.count(name)) {
-        for (auto edit : scenes[name].nodes) {
-            auto tloc = std::vector<int>(edit.tree_location.begin() + 1, edit.tree_location.end());
-
-            auto node = getNodeByTreeLocation(scene, tloc);
-
-            for (auto loc : tloc)
-                trees += std::to_string(loc) + ".";
-            
-            trees += " -> " + std::string(node ? getNodeName(node) : "null") + " ";
-
-            if (!node)
-                continue;
-
-            node->setPosition(edit.position);
-            node->setRotation(edit.rotation.both);
-            node->setRotationX(edit.rotation.x);
-            node->setRotationY(edit.rotation.y);
-            node->setScale(edit.rotation.both);
-            node->setScaleX(edit.rotation.x);
-            node->setScaleY(edit.rotation.y);
-            node->setSkewX(edit.skew.x);
-            node->setSkewY(edit.skew.y);
-            node->setVisible(edit.visible);
-            node->setContentSize(edit.content_size);
-            node->setAnchorPoint(edit.anchorpoint);
-            node->setZOrder(edit.z_order);
-
-            auto dnode = dynamic_cast<CCNodeRGBA*>(node);
-            if (dnode) {
-                dnode->setColor(edit.color);
-                dnode->setOpacity(edit.opacity);
+        auto applier = std::make_shared<scene_edit_applier>(scene, scenes[name]);
+
+        // most scenes are done within the first slice, before they're drawn
+        editLoadTask = g_tasks.start(
+            std::string("Applying edits to ") + name, tpHigh,
+            [applier, name](task_context& ctx) {
+                // the game may free or reorder nodes between slices,
+                // but not between the steps of one
+                if (!ctx.steps)
+                    applier->beginSlice();
+                for (int i = 0; i < 64 && !applier->done(); i++)
+                    applier->step();
+
+                ctx.done = applier->visited;
+                ctx.total = applier->edits->nodes.size();
+                if (!applier->done())
+                    return true;
+
+                movedToScene = std::string(name) + " (" + std::to_string(applier->applied) + " / " +
+                    std::to_string(ctx.total) + " edits applied)";
+                return false;
             }
-
-            auto lnode = dynamic_cast<CCLabelBMFont*>(node);
-            if (lnode) {
-                lnode->setString(edit.text);
-            }
-        }
+        );
     }
-
-    movedToScene = name + std::string(" ") + trees;
 }
 
 void saveSceneChanges(CCScene* scene) {
-    if (dynamic_cast<CCTransitionScene*>(scene)) {
+    if (getNodeType(scene).is(ntTransition)) {
         scene = reinterpret_cast<CCTransitionSceneGetter*>(scene)->getOutScene();
     }
 
     auto name = getNodeName(reinterpret_cast<CCNode*>(scene->getChildren()->objectAtIndex(0)));
 
-    scene_edit edit;
+    auto& edit = scenes[name];
 
     edit.rtti_name = name;
 
-    if (scenes.count(name)) {
-        for (auto node : scenes[name].nodes)
-            edit.nodes.push_back(node);
-    }
-    
-    for (auto node : changedNodes) {
-        node_edit n;
-
-        n.tree_location = getNodeLocationInTree(node);
-        n.position = node->getPosition();
-        n.anchorpoint = node->getAnchorPoint();
-        n.skew.x = node->getSkewX();
-        n.skew.y = node->getSkewY();
-        n.content_size = node->getContentSize();
-        n.z_order = node->getZOrder();
-        n.scale.both = node->getScale();
-        n.scale.x = node->getScaleX();
-        n.scale.y = node->getScaleY();
-        n.rotation.both = node->getRotation();
-        n.rotation.x = node->getRotationX();
-        n.rotation.y = node->getRotationY();
-        n.visible = node->isVisible();
-
-        auto dnode = dynamic_cast<CCNodeRGBA*>(node);
-        if (dnode) {
-            n.color = dnode->getColor();
-            n.opacity = dnode->getOpacity();
-        }
-
-        auto lnode = dynamic_cast<CCLabelBMFont*>(node);
-        if (lnode) {
-            n.text = lnode->getString();
-        }
+    collectSceneChanges(g_changes, edit);
 
-        edit.nodes.push_back(n);
-    }
-
-    scenes[name] = edit;
-}
-
-bool filterNode(CCNode* node, bool isContainer) {
-    if (!node->isVisible())
-        return false;
-
-    if (dynamic_cast<CCLayer*>(node))
-        return isContainer;
-    if (dynamic_cast<CCMenu*>(node))
-        return isContainer;
-
-    return !isContainer;
-}
-
-bool stopCheckingChildren(CCNode* node) {
-    if (dynamic_cast<CCMenuItem*>(node))
-        return true;
-    if (dynamic_cast<CCScale9Sprite*>(node))
-        return true;
-    if (dynamic_cast<CCLabelBMFont*>(node))
-        return true;
-    if (!node->isVisible())
-        return true;
-
-    return false;
-}
-
-void getNodesUnderMouse(CCNode* parent, CCArray* res, CCPoint mpos, bool containers = false) {
-    CCObject* obj;
-    CCARRAY_FOREACH(parent->getChildren(), obj) {
-        auto node = reinterpret_cast<CCNode*>(obj);
-
-        if (!node) continue;
-        if (!node->getParent()) continue;
-
-        auto pos = node->getPosition();
-        auto size = node->getScaledContentSize();
-        auto rect = CCRect { pos.x, pos.y, size.width, size.height };
-
-        rect.origin = rect.origin - rect.size / 2;
-
-        auto mposn = node->getParent()->convertToNodeSpace(mpos);
-
-        if (rect.containsPoint(mposn) && filterNode(node, containers))
-            res->addObject(node);
-        
-        if (node->getChildrenCount() && !stopCheckingChildren(node))
-            getNodesUnderMouse(node, res, mpos, containers);
-    }
+    g_generation.bump(gsEdits);
 }
 
 const char* getRectText(CCRect const& rect) {
@@ -299,19 +232,6 @@ const char* getRectText(CCRect const& rect) {
     ).c_str();
 }
 
-CCNode* getTopMost(CCArray* nodes) {
-    CCObject* obj;
-    CCNode* res = nullptr;
-    CCARRAY_FOREACH(nodes, obj) {
-        auto node = reinterpret_cast<CCNode*>(obj);
-
-        if (!res || node->getZOrder() >= res->getZOrder())
-                res = node;
-    }
-
-    return res;
-}
-
 CCRect operator/=(CCRect & rect, CCSize const& size) {
     rect.origin.x /= size.width;
     rect.origin.y /= size.height;
@@ -328,16 +248,6 @@ CCPoint operator/=(CCPoint & point, CCSize const& size) {
     return point;
 }
 
-HWND glfwGetWin32Window(GLFWwindow* wnd) {
-    auto cocosBase = GetModuleHandleA("libcocos2d.dll");
-
-    auto pRet = reinterpret_cast<HWND(__cdecl*)(GLFWwindow*)>(
-        reinterpret_cast<uintptr_t>(cocosBase) + 0x112c10
-    )(wnd);
-
-    return pRet;
-}
-
 CCRect operator*=(CCRect & rect, CCSize const& size) {
     rect.origin.x *= size.width;
     rect.origin.y *= size.height;
@@ -351,46 +261,14 @@ ImVec2 ccpToImVec2(CCPoint const& p) {
     return { p.x, p.y };
 }
 
-ImVec2 convertGlobalPointToWindowSpace(CCPoint const& p) {
-    ImVec2 res;
-
-    auto winSize = CCDirector::sharedDirector()->getWinSize();
-    auto eg = CCDirector::sharedDirector()->getOpenGLView();
-    auto hWnd = glfwGetWin32Window(eg->getWindow());
-
-    RECT wRect;
-    GetClientRect(hWnd, &wRect);
-    
-    float winWidth = static_cast<float>(wRect.right);
-    float winHeight = static_cast<float>(wRect.bottom);
-
-    res.x = p.x / winSize.width * winWidth;
-    res.y = p.y / winSize.height * winHeight;
-
-    // flip
-    res.y = winHeight - res.y;
-
-    return res;
-}
-
 CCRect getNodeRectInWindowSpace(CCNode* node) {
-    auto winSize = CCDirector::sharedDirector()->getWinSize();
-
-    auto pos = node->getParent()->convertToWorldSpace(node->getPosition());
+    auto pos = g_frame.toWorld(node->getParent(), node->getPosition());
     auto size = node->getScaledContentSize();
     auto rect = CCRect { pos.x, pos.y, size.width, size.height };
 
     rect.origin = rect.origin - rect.size / 2;
 
-    const auto [winWidth, winHeight] = ImGui::GetMainViewport()->Size;
-
-    rect /= winSize;
-    rect *= CCSize { winWidth, winHeight };
-
-    rect.origin.y = winHeight - rect.origin.y;
-    rect.origin.y -= rect.size.height;
-
-    return rect;
+    return g_frame.toWindow(rect);
 }
 
 enum highlight {
@@ -399,75 +277,82 @@ enum highlight {
     hlAlt,
     hlAltOutline,
     hlAltOutline2,
+    hlHeat,
 };
 
-void highlightNode(CCNode* node, highlight sel = hlNormal) {
+// green at 0, red at 1
+ImU32 heatColor(float heat, unsigned int alpha) {
+    heat = std::min(std::max(heat, 0.0f), 1.0f);
+    auto r = static_cast<unsigned int>(255.0f * heat);
+    auto g = static_cast<unsigned int>(255.0f * (1.0f - heat));
+    return (alpha << 24) | (g << 8) | r;
+}
+
+void highlightNode(CCNode* node, highlight sel = hlNormal, float heat = 0.0f) {
     if (!node) return;
     if (!node->getParent()) return;
 
-    auto eg = CCDirector::sharedDirector()->getOpenGLView();
-    auto winSize = CCDirector::sharedDirector()->getWinSize();
-
-    ImDrawList& list = *ImGui::GetForegroundDrawList();
+    auto rect = getNodeRectInWindowSpace(node);
+    auto min = ccpToImVec2(rect.origin);
+    auto max = ccpToImVec2(rect.origin + rect.size);
 
-    auto pos = node->getParent()->convertToWorldSpace(node->getPosition());
-    auto size = node->getScaledContentSize();
-    auto rect = CCRect { pos.x, pos.y, size.width, size.height };
+    switch (sel) {
+        case hlSelected:    g_overlay.rect(min, max, 0xff00ff00, strokeSize); break;
+        case hlAlt:         g_overlay.fill(min, max, 0x3300ffff); break;
+        case hlAltOutline:  g_overlay.rect(min, max, 0xffff00ff, strokeSize); break;
+        case hlAltOutline2: g_overlay.rect(min, max, 0xfff0f0ff, strokeSize); break;
+        case hlHeat:        g_overlay.fill(min, max, heatColor(heat, 0x55)); break;
+        case hlNormal: default:
+            g_overlay.fill(min, max, 0x3300ff00);
+            break;
+    }
+}
 
-    rect.origin = rect.origin - rect.size / 2;
+// outlines of every visible node the hover logic knows about
+void showAllBounds(CCDirector* director) {
+    auto root = getLastChild(director->getRunningScene());
+    if (g_nodeIndex.needsRebuild(root))
+        g_nodeIndex.build(root);
+    else
+        g_nodeIndex.refresh();
 
-    const auto [winWidth, winHeight] = ImGui::GetMainViewport()->Size;
+    for (auto const& entry : g_nodeIndex.entries()) {
+        if (!entry.visible)
+            continue;
 
-    rect /= winSize;
-    rect *= CCSize { winWidth, winHeight };
+        auto rect = g_frame.toWindow(entry.rect);
+        g_overlay.rect(
+            ccpToImVec2(rect.origin), ccpToImVec2(rect.origin + rect.size),
+            entry.container ? 0x66ffff00 : 0x66ffffff, 1.0f
+        );
+    }
+}
 
-    rect.origin.y = winHeight - rect.origin.y;
-    rect.origin.y -= rect.size.height;
+// the nodes that cost the most to draw, by their own time
+void showDrawHeat() {
+    auto max = g_drawProfiler.stats().maxExclusive;
+    if (max <= 0.0f)
+        return;
 
-    switch (sel) {
-        case hlSelected:
-            list.AddRect(
-                ccpToImVec2(rect.origin),
-                ccpToImVec2(rect.origin + rect.size),
-                0xff00ff00,
-                0.0f, 15, strokeSize
-            );
-            break;
+    for (auto const& [node, cost] : g_drawProfiler.costs()) {
+        auto heat = cost.exclusive / max;
+        if (heat >= 0.05f)
+            highlightNode(node, hlHeat, heat);
+    }
+}
 
-        case hlAlt:
-            list.AddRectFilled(
-                ccpToImVec2(rect.origin),
-                ccpToImVec2(rect.origin + rect.size),
-                0x3300ffff
-            );
-            break;
-        
-        case hlAltOutline:
-            list.AddRect(
-                ccpToImVec2(rect.origin),
-                ccpToImVec2(rect.origin + rect.size),
-                0xffff00ff,
-                0.0f, 15, strokeSize
-            );
-            break;
-        
-        case hlAltOutline2:
-            list.AddRect(
-                ccpToImVec2(rect.origin),
-                ccpToImVec2(rect.origin + rect.size),
-                0xfff0f0ff,
-                0.0f, 15, strokeSize
-            );
-            break;
-        
-        case hlNormal: default:
-            list.AddRectFilled(
-                ccpToImVec2(rect.origin),
-                ccpToImVec2(rect.origin + rect.size),
-                0x3300ff00
-            );
-            break;
+void showDrawCost(CCNode* node) {
+    auto cost = g_drawProfiler.costOf(node);
+    if (!cost) {
+        ImGui::TextDisabled("-");
+        return;
     }
+
+    auto max = g_drawProfiler.stats().maxExclusive;
+    ImGui::TextColored(
+        ImGui::ColorConvertU32ToFloat4(heatColor(max > 0.0f ? cost->exclusive / max : 0.0f, 0xff)),
+        "%.3f / %.3f ms", cost->inclusive, cost->exclusive
+    );
 }
 
 CCPoint getRelativeMousePos() {
@@ -489,18 +374,13 @@ CCPoint getRelativeMousePos() {
 
 void snapNodeToWindowSides(CCNode* node) {
     if (snapWindowSidesEnabled) {
-        auto left = node->getParent()->convertToNodeSpace({
-            CCDirector::sharedDirector()->getScreenLeft(), 0
-        }).x;
-        auto right = node->getParent()->convertToNodeSpace({
-            CCDirector::sharedDirector()->getScreenRight(), 0
-        }).x;
-        auto top = node->getParent()->convertToNodeSpace({
-            0, CCDirector::sharedDirector()->getScreenTop()
-        }).y;
-        auto bottom = node->getParent()->convertToNodeSpace({
-            0, CCDirector::sharedDirector()->getScreenBottom()
-        }).y;
+        auto parent = node->getParent();
+        auto director = CCDirector::sharedDirector();
+
+        auto left = g_frame.toNode(parent, { director->getScreenLeft(), 0 }).x;
+        auto right = g_frame.toNode(parent, { director->getScreenRight(), 0 }).x;
+        auto top = g_frame.toNode(parent, { 0, director->getScreenTop() }).y;
+        auto bottom = g_frame.toNode(parent, { 0, director->getScreenBottom() }).y;
 
         auto csize = node->getScaledContentSize() / 2;
 
@@ -520,273 +400,144 @@ void snapNodeToWindowSides(CCNode* node) {
     }
 }
 
-float nodedisx(CCNode* p1, CCNode* p2) {
-    return fabsf(p1->getPositionX() - p2->getPositionX());
-}
-
-float nodedisy(CCNode* p1, CCNode* p2) {
-    return fabsf(p1->getPositionY() - p2->getPositionY());
+void drawSpacingGuide(CCNode* parent, CCPoint const& from, CCPoint const& to) {
+    g_overlay.line(
+        ccpToImVec2(g_frame.toWindow(g_frame.toWorld(parent, from))),
+        ccpToImVec2(g_frame.toWindow(g_frame.toWorld(parent, to))),
+        0x8800ffff, strokeSize
+    );
 }
 
-void snapNodeToGrid(CCNode* node, CCArray* closestXNodes, CCArray* closestYNodes) {
+void snapNodeToGrid(CCNode* node) {
     if (!snapGridEnabled)
         return;
 
-    CCObject* obj;
-
-    CCNode* closestXNode = nullptr;
-    CCNode* closestYNode = nullptr;
+    auto parent = node->getParent();
+    auto pos = node->getPosition();
 
-    std::set<float> xdiffs;
-    std::set<float> ydiffs;
+    for (auto axis : { saX, saY }) {
+        if (axis == saX ? !snapX : !snapY)
+            continue;
 
-    float last = 0.0f;
-    if (snapY)
-        CCARRAY_FOREACH(closestXNodes, obj) {
-            xdiffs.insert(reinterpret_cast<CCNode*>(obj)->getPositionY() - last);
-            last = reinterpret_cast<CCNode*>(obj)->getPositionY();
+        spacing_match match;
+        if (!g_spacingIndex.snap(axis, pos, g_snapThreshold, match))
+            continue;
 
-            if (!closestXNode)
-                closestXNode = reinterpret_cast<CCNode*>(obj);
-            else
-                if (nodedisy(node, reinterpret_cast<CCNode*>(obj)) < nodedisy(node, closestXNode))
-                    closestXNode = node;
-        }
+        if (axis == saX)
+            pos.x += match.delta;
+        else
+            pos.y += match.delta;
 
-    last = 0.0f;
-    if (snapX)
-        CCARRAY_FOREACH(closestYNodes, obj) {
-            ydiffs.insert(reinterpret_cast<CCNode*>(obj)->getPositionX() - last);
-            last = reinterpret_cast<CCNode*>(obj)->getPositionX();
+        drawSpacingGuide(parent, match.neighbour, pos);
+        if (match.between)
+            drawSpacingGuide(parent, pos, match.other);
 
-            if (!closestYNode)
-                closestYNode = reinterpret_cast<CCNode*>(obj);
-            else
-                if (nodedisx(node, reinterpret_cast<CCNode*>(obj)) < nodedisx(node, closestYNode))
-                    closestYNode = node;
-        }
+        auto [begin, end] = g_spacingIndex.gapsOf(axis, match.gap);
+        for (auto it = begin; it != end; it++)
+            drawSpacingGuide(parent, it->from, it->to);
+    }
 
+    node->setPosition(pos);
+}
 
-    // ImGui::Text("xdiffs");
-    // for (auto diff : xdiffs) {
-    //     auto ndiff = node->getPositionY() - closestXNode->getPositionY();
+void snapNodeToNear(CCNode* node) {
+    if (!snapNodeSidesEnabled)
+        return;
 
-    //     ImGui::Text("%.2f -> %.2f", fabsf(diff), fabsf(ndiff));
+    auto cc = node->getScaledContentSize() / 2;
+    auto pos = node->getPosition();
+    auto rect = CCRect { pos.x - cc.width, pos.y - cc.height, cc.width * 2, cc.height * 2 };
 
-    //     if (fabsf(fabsf(diff) - fabsf(ndiff)) < g_snapThreshold) {
-    //         node->setPositionY(closestXNode->getPositionY() + ndiff);
-    //         break;
-    //     }
-    // }
+    sibling_rect const* nearest[SiblingHash::maxNearest * SiblingHash::sideCount];
+    auto count = g_siblingHash.nearest(rect, SiblingHash::maxNearest, nearest);
 
-    // ImGui::Text("ydiffs");
-    // for (auto diff : ydiffs) {
-    //     auto ndiff = node->getPositionX() - closestYNode->getPositionX();
+    float bestX = g_snapThreshold, bestY = g_snapThreshold;
+    auto snappedPos = pos;
 
-    //     ImGui::Text("%.2f -> %.2f / %.2f", fabsf(diff), fabsf(ndiff), fabsf(fabsf(diff) - fabsf(ndiff)));
+    for (unsigned int i = 0; i < count; i++) {
+        auto const& nrect = nearest[i]->rect;
+        auto cc2 = nrect.size / 2;
+        auto pos2 = CCPoint { nrect.getMidX(), nrect.getMidY() };
 
-    //     if (fabsf(fabsf(diff) - fabsf(ndiff)) < g_snapThreshold) {
-    //         float r;
-    //         if (node->getPositionX() < closestYNode->getPositionX())
-    //             r = -diff;
-    //         else
-    //             r = diff;
-    //         node->setPositionX(closestYNode->getPositionX() + r);
-    //         break;
-    //     }
-    // }
-}
+        auto disx = fabsf(pos.x - pos2.x);
+        auto disy = fabsf(pos.y - pos2.y);
 
-void snapNodeToNear(CCNode* node) {
-    CCObject* obj;
-    CCNode* nearest;
-    float dis = -1.0f;
-    
-    CCARRAY_FOREACH(node->getParent()->getChildren(), obj) {
-        if (node == obj)
-            continue;
-        
-        auto nobj = reinterpret_cast<CCNode*>(obj);
-
-        auto d = ccpDistance(nobj->getPosition(), node->getPosition());
-        if (dis < 0.0f || d < dis) {
-            nearest = nobj;
-            dis = d;
+        auto gapx = fabsf(disx - cc.width - cc2.width);
+        if (snapX && gapx < bestX) {
+            bestX = gapx;
+            if (pos.x < pos2.x)
+                snappedPos.x = pos2.x - cc2.width - cc.width;
+            else
+                snappedPos.x = pos2.x + cc2.width + cc.width;
         }
-    }
-
-    auto cc = node->getScaledContentSize() / 2;
-    auto cc2 = nearest->getScaledContentSize() / 2;
-    auto pos = node->getPosition();
-    auto pos2 = nearest->getPosition();
 
-    auto disx = fabsf(pos.x - pos2.x);
-    auto disy = fabsf(pos.y - pos2.y);
-
-    if (snapX && fabsf(disx - cc.width - cc2.width) < g_snapThreshold) {
-        if (pos.x < pos2.x)
-            node->setPositionX(pos2.x - cc2.width - cc.width);
-        else
-            node->setPositionX(pos2.x + cc2.width + cc.width);
+        auto gapy = fabsf(disy - cc.height - cc2.height);
+        if (snapY && gapy < bestY) {
+            bestY = gapy;
+            if (pos.y < pos2.y)
+                snappedPos.y = pos2.y - cc2.height - cc.height;
+            else
+                snappedPos.y = pos2.y + cc2.height + cc.height;
+        }
     }
 
-    if (snapY && fabsf(disy - cc.height - cc2.height) < g_snapThreshold) {
-        if (pos.y < pos2.y)
-            node->setPositionY(pos2.y - cc2.height - cc.height);
-        else
-            node->setPositionY(pos2.y + cc2.height + cc.height);
-    }
+    node->setPosition(snappedPos);
 }
 
-void snapNodePosition(CCNode* node) {
-    if (!snapEnabled)
-        return;
-    if (node->getParent()->getChildrenCount() == 1)
-        return snapNodeToWindowSides(node);
+void snapNodeToLines(CCNode* node) {
+    auto parent = node->getParent();
+    auto rect = getNodeWorldRect(node);
+    auto wpos = g_frame.toWorld(parent, node->getPosition());
 
-    auto pos = node->getPosition();
+    const auto [winWidth, winHeight] = g_frame.windowSize();
 
-    CCArray* closestXNodes = CCArray::create();
-    CCArray* closestYNodes = CCArray::create();
-    closestXNodes->retain();
-    closestYNodes->retain();
+    snap_match match;
 
-    float closestX, closestY;
-    CCObject* obj;
-    CCARRAY_FOREACH(node->getParent()->getChildren(), obj) {
-        if (obj == node)
-            continue;
-        
-        auto nobj = reinterpret_cast<CCNode*>(obj);
-
-        if (nobj) {
-            if (!closestXNodes->count()) {
-                closestXNodes->addObject(nobj);
-                closestYNodes->addObject(nobj);
-                closestX = fabsf(nobj->getPositionX() - node->getPositionX());
-                closestY = fabsf(nobj->getPositionY() - node->getPositionY());
-                continue;
-            }
+    if (snapX) {
+        float xs[] = { rect.getMinX(), rect.getMidX(), rect.getMaxX() };
+        if (g_alignIndex.closest(saX, xs, 3, g_snapThreshold, snapLineEnabled, match)) {
+            wpos.x += match.delta;
 
-            auto disx = fabsf(nobj->getPositionX() - node->getPositionX());
-            if (disx <= closestX) {
-                if (disx < closestX)
-                    closestXNodes->removeAllObjects();
-                closestXNodes->addObject(nobj);
-                closestX = disx;
-            }
+            auto x = g_frame.toWindow(CCPoint { match.value, 0.0f }).x;
+            g_overlay.line({ x, 0 }, { x, winHeight }, match.window ? 0x44ff00ff : 0x44ffff00, strokeSize);
 
-            auto disy = fabsf(nobj->getPositionY() - node->getPositionY());
-            if (disy <= closestY) {
-                if (disy < closestY)
-                    closestYNodes->removeAllObjects();
-                closestYNodes->addObject(nobj);
-                closestY = disy;
-            }
+            auto [begin, end] = g_alignIndex.linesAt(saX, match.value);
+            for (auto it = begin; it != end; it++)
+                if (it->node)
+                    highlightNode(it->node, hlAltOutline);
         }
     }
 
-    CCPoint wx, wy;
-    CCPoint gwx, gwy;
-    bool mouseX = false, mouseY = false;
-
-    if (snapWindowEnabled) {
-        auto wposa = static_cast<CCPoint>(CCDirector::sharedDirector()->getWinSize() / 2);
-        auto wpos = node->getParent()->convertToNodeSpace(wposa);
-
-        auto disx = fabsf(wpos.x - node->getPositionX());
-        if (disx <= closestX) {
-            if (disx < closestX)
-                closestXNodes->removeAllObjects();
-            closestX = disx;
-            wx = wpos;
-            gwx = wposa;
-            mouseX = true;
-        }
+    if (snapY) {
+        float ys[] = { rect.getMinY(), rect.getMidY(), rect.getMaxY() };
+        if (g_alignIndex.closest(saY, ys, 3, g_snapThreshold, snapLineEnabled, match)) {
+            wpos.y += match.delta;
 
-        auto disy = fabsf(wpos.y - node->getPositionY());
-        if (disy <= closestY) {
-            if (disy < closestY)
-                closestYNodes->removeAllObjects();
-            closestY = disy;
-            wy = wpos;
-            gwy = wposa;
-            mouseY = true;
+            auto y = g_frame.toWindow(CCPoint { 0.0f, match.value }).y;
+            g_overlay.line({ 0, y }, { winWidth, y }, match.window ? 0x44ff00ff : 0x44ffff00, strokeSize);
+
+            auto [begin, end] = g_alignIndex.linesAt(saY, match.value);
+            for (auto it = begin; it != end; it++)
+                if (it->node)
+                    highlightNode(it->node, hlAltOutline2);
         }
     }
 
-    ImDrawList& list = *ImGui::GetForegroundDrawList();
-    const auto [winWidth, winHeight] = ImGui::GetMainViewport()->Size;
-
-    ImVec2 xpos, ypos;
-
-    CCNode* closestXNode = nullptr, *closestYNode = nullptr;
+    node->setPosition(g_frame.toNode(parent, wpos));
+}
 
-    if (closestXNodes->count()) {
-        closestXNode = reinterpret_cast<CCNode*>(
-            closestXNodes->objectAtIndex(0)
-        );
-    }
+void snapNodePosition(CCNode* node) {
+    if (!snapEnabled)
+        return;
 
-    if (closestYNodes->count()) {
-        closestYNode = reinterpret_cast<CCNode*>(
-            closestYNodes->objectAtIndex(0)
-        );
-    }
+    PROFILE_SCOPE(pzSnap);
 
-    if (closestXNode) {
-        xpos = convertGlobalPointToWindowSpace(
-            closestXNode->getParent()->convertToWorldSpace(closestXNode->getPosition())
-        );
-    } else {
-        xpos = convertGlobalPointToWindowSpace(gwx);
-    }
-    if (closestYNode) {
-        ypos = convertGlobalPointToWindowSpace(
-            closestYNode->getParent()->convertToWorldSpace(closestYNode->getPosition())
-        );
-    } else {
-        ypos = convertGlobalPointToWindowSpace(gwy);
-    }
-    
     snapNodeToWindowSides(node);
-    snapNodeToGrid(node, closestXNodes, closestYNodes);
+    snapNodeToGrid(node);
     snapNodeToNear(node);
+    snapNodeToLines(node);
 
-    if (snapX && closestX < g_snapThreshold) {
-        if (closestXNode && !mouseX) {
-            if (snapLineEnabled) {
-                node->setPositionX(closestXNode->getPositionX());
-                list.AddLine({ xpos.x, 0 }, { xpos.x, winHeight }, 0x44ffff00, strokeSize);
-            }
-        } else {
-            node->setPositionX(wx.x);
-            list.AddLine({ xpos.x, 0 }, { xpos.x, winHeight }, 0x44ff00ff, strokeSize);
-        }
-
-        CCObject* iobj;
-        CCARRAY_FOREACH(closestXNodes, iobj)
-            highlightNode(reinterpret_cast<CCNode*>(iobj), hlAltOutline);
-    }
-
-    if (snapY && closestY < g_snapThreshold) {
-        if (closestYNode && !mouseY) {
-            if (snapLineEnabled) {
-                node->setPositionY(closestYNode->getPositionY());
-                list.AddLine({ 0, ypos.y }, { winWidth, ypos.y }, 0x44ffff00, strokeSize);
-            }
-        } else {
-            node->setPositionY(wy.y);
-            list.AddLine({ 0, ypos.y }, { winWidth, ypos.y }, 0x44ff00ff, strokeSize);
-        }
-
-        CCObject* iobj;
-        CCARRAY_FOREACH(closestYNodes, iobj)
-            highlightNode(reinterpret_cast<CCNode*>(iobj), hlAltOutline2);
-    }
-
-    closestXNodes->release();
-    closestYNodes->release();
+    g_frame.invalidate(node);
 }
 
 void moveSelectedNode() {
@@ -797,17 +548,16 @@ void moveSelectedNode() {
     if (resizingNode || addPopupOpen)
         return;
     
-    auto eg = CCDirector::sharedDirector()->getOpenGLView();
-
     auto pos = getRelativeMousePos();
 
-    auto npos = selectedNode->getParent()->convertToNodeSpace(pos);
+    auto npos = g_frame.toNode(selectedNode->getParent(), pos);
 
     selectedNode->setPosition(npos + clickOffset);
+    g_frame.invalidate(selectedNode);
 
     if (ccpDistance(startPos, selectedNode->getPosition()) > 5.0f) {
         selectionMoved = true;
-        registerNodeAsModified(selectedNode);
+        registerNodeAsModified(selectedNode, npPosition);
     }
 
     snapNodePosition(selectedNode);
@@ -819,11 +569,21 @@ void onSelectNode() {
 
     auto pos = getRelativeMousePos();
 
-    auto mpos = selectedNode->getParent()->convertToNodeSpace(pos);
+    auto mpos = g_frame.toNode(selectedNode->getParent(), pos);
     auto npos = selectedNode->getPosition();
 
     clickOffset = npos - mpos;
     startPos = selectedNode->getPosition();
+
+    g_changes.track(selectedNode);
+
+    g_nodeIndex.refresh();
+    g_alignIndex.build(
+        g_nodeIndex, selectedNode,
+        CCDirector::sharedDirector()->getWinSize(), snapWindowEnabled
+    );
+    g_siblingHash.build(selectedNode);
+    g_spacingIndex.build(selectedNode, 1.0f);
 }
 
 void selectAddNode() {
@@ -858,8 +618,7 @@ void selectAddNode() {
         ImGui::Separator();
 
         if (ImGui::Button("Add")) {
-            threadFunctionsMutex.lock();
-            threadFunctions.push([] {
+            g_mainQueue.push([] {
                 CCNode* _child = nullptr;
                 switch (item) {
                 case 0:
@@ -899,9 +658,9 @@ void selectAddNode() {
                 if (_child != nullptr) {
                     _child->setTag(tag);
                     addTarget->addChild(_child);
+                    g_treeView.invalidate();
                 }
             });
-            threadFunctionsMutex.unlock();
             addPopupOpen = false;
             ImGui::CloseCurrentPopup();
         }
@@ -914,195 +673,209 @@ void selectAddNode() {
     }
 }
 
-void generateTree(CCNode* node, unsigned int i = 0, unsigned int hix = 0u) {
-    std::stringstream stream;
-    stream << "[" << i << "] " << getNodeName(node);
-    if (node->getTag() != -1)
-        stream << " (" << node->getTag() << ")";
-    const auto childrenCount = node->getChildrenCount();
-    if (childrenCount)
-        stream << " {" << childrenCount << "}";
-    if (openLocation.size()) {
-        ImGui::SetNextItemOpen(openLocation[hix] == i);
+// inspector widgets for each property type, true if the value changed
+bool editProperty(property<CCPoint> const& prop, CCPoint& value) {
+    float v[2] = { value.x, value.y };
+    ImGui::DragFloat2(prop.name, v, prop.speed, prop.min, prop.max);
+    CCPoint res { v[0], v[1] };
+    if (!sameValue(res, value)) {
+        value = res;
+        return true;
     }
-    if (ImGui::TreeNode(node, stream.str().c_str())) {
-        if (hix == openLocation.size() - 1) {
-            ImGui::SetNextItemOpen(true);
-            ImGui::SetScrollHere();
-        }
+    return false;
+}
 
-        if (ImGui::TreeNode(node + 1, "Attributes")) {
-            if (ImGui::Button("Delete")) {
-                node->removeFromParentAndCleanup(true);
-                ImGui::TreePop();
-                ImGui::TreePop();
-                return;
-            }
-            ImGui::SameLine();
-            if (ImGui::Button("Add Child")) {
-                addTarget = node;
-                ImGui::OpenPopup("Add Child");
-            }
-            selectAddNode();
-            ImGui::SameLine();
-            if (ImGui::Button("Highlight")) {
-                highlightNode(node);
-            }
+bool editProperty(property<CCSize> const& prop, CCSize& value) {
+    auto v = value;
+    ImGui::DragFloat2(prop.name, &v.width, prop.speed, prop.min, prop.max);
+    if (!sameValue(v, value)) {
+        value = v;
+        return true;
+    }
+    return false;
+}
 
-            ImGui::Text("Addr: 0x%p", node);
-            ImGui::SameLine();
-            if (ImGui::Button("Copy")) {
-                std::stringstream stream;
-                stream << std::uppercase << std::hex << reinterpret_cast<uintptr_t>(node);
-                clipboardText(stream.str().c_str());
-            }
-            if (node->getUserData()) {
-                ImGui::Text("User data: 0x%p", node->getUserData());
-            }
+bool editProperty(property<int> const& prop, int& value) {
+    auto v = value;
+    ImGui::InputInt(prop.name, &v);
+    if (v != value) {
+        value = v;
+        return true;
+    }
+    return false;
+}
 
-            if (ImGui::Button("Copy Pos")) {
-                auto pos = node->getPosition();
-                clipboardText(std::string(
-                    std::to_string(static_cast<int>(roundf(pos.x))) + ".0f, " +
-                    std::to_string(static_cast<int>(roundf(pos.y))) + ".0f"
-                ).c_str());
-            }
-            ImGui::SameLine();
-            if (ImGui::Button("Copy Pos WC")) {
-                auto winSize = CCDirector::sharedDirector()->getWinSize();
-                auto pos = node->getParent()->convertToWorldSpace(node->getPosition());
-                pos.x -= winSize.width / 2;
-                pos.y -= winSize.height / 2;
-                pos.x = roundf(pos.x);
-                pos.y = roundf(pos.y);
-                auto str =
-                std::string("winSize.width / 2 ") + (pos.x < 0.0f ? "- " : "+ ") +
-                    std::to_string(static_cast<int>(fabsf(pos.x))) + ".0f" +
-                    ", winSize.height / 2 " + (pos.y < 0.0f ? "- " : "+ ") +
-                    std::to_string(static_cast<int>(fabsf(pos.y))) + ".0f";
-                clipboardText(str.c_str());
-            }
-            ImGui::SameLine();
-            if (ImGui::Button("Copy Abs Pos")) {
-                auto pos = node->getParent()->convertToWorldSpace(node->getPosition());
-                clipboardText(std::string(
-                    std::to_string(static_cast<int>(roundf(pos.x))) + ".0f, " +
-                    std::to_string(static_cast<int>(roundf(pos.y))) + ".0f"
-                ).c_str());
-            }
+bool editProperty(property<vec3f_t> const& prop, vec3f_t& value) {
+    float v[3] = { value.both, value.x, value.y };
+    ImGui::DragFloat3(prop.name, v, prop.speed, prop.min, prop.max);
+    // amazing
+    if (v[0] != value.both)
+        value = { v[0], v[0], v[0] };
+    else if (v[1] != value.x || v[2] != value.y)
+        value = { v[1], v[2], value.both };
+    else
+        return false;
+    return true;
+}
 
-            auto pos = node->getPosition();
-            float _pos[2] = { pos.x, pos.y };
-            ImGui::DragFloat2("Position", _pos);
-            if (CCSize { _pos[0], _pos[1] } != pos) {
-                registerNodeAsModified(node);
-            }
-            node->setPosition({ _pos[0], _pos[1] });
-
-            float _scale[3] = { node->getScale(), node->getScaleX(), node->getScaleY() };
-            ImGui::DragFloat3("Scale", _scale, 0.025f);
-            // amazing
-            if (node->getScale() != _scale[0]) {
-                registerNodeAsModified(node);
-                node->setScale(_scale[0]);
-            } else {
-                if (CCSize { _scale[1], _scale[2] } != CCSize { node->getScaleX(), node->getScaleY() })
-                    registerNodeAsModified(node);
-
-                node->setScaleX(_scale[1]);
-                node->setScaleY(_scale[2]);
-            }
+bool editProperty(property<bool> const& prop, bool& value) {
+    auto v = value;
+    ImGui::Checkbox(prop.name, &v);
+    if (v != value) {
+        value = v;
+        return true;
+    }
+    return false;
+}
 
-            float _rot[3] = { node->getRotation(), node->getRotationX(), node->getRotationY() };
-            ImGui::DragFloat3("Rotation", _rot);
-            if (node->getRotation() != _rot[0]) {
-                registerNodeAsModified(node);
-                node->setRotation(_rot[0]);
-            } else {
-                if (CCSize { _rot[1], _rot[2] } != CCSize { node->getRotationX(), node->getRotationY() })
-                    registerNodeAsModified(node);
-
-                node->setRotationX(_rot[1]);
-                node->setRotationY(_rot[2]);
-            }
+bool editProperty(property<std::string> const& prop, std::string& value) {
+    char text[256];
+    strncpy_s(text, value.c_str(), _TRUNCATE);
+    // longer text than fits doesn't count as changed until it's typed in
+    if (!ImGui::InputText(prop.name, text, 256) || value == text)
+        return false;
+    value = text;
+    return true;
+}
 
-            float _skew[2] = { node->getSkewX(), node->getSkewY() };
-            ImGui::DragFloat2("Skew", _skew);
-            if (node->getSkewX() != _skew[0] || node->getSkewY() != _skew[1]) {
-                registerNodeAsModified(node);
-            }
-            node->setSkewX(_skew[0]);
-            node->setSkewY(_skew[1]);
+bool editProperty(property<ccColor3B> const& prop, ccColor3B& value) {
+    float v[3] = { value.r / 255.f, value.g / 255.f, value.b / 255.f };
+    ImGui::ColorEdit3(prop.name, v);
+    auto ncol = ccColor3B {
+        static_cast<GLubyte>(v[0] * 255),
+        static_cast<GLubyte>(v[1] * 255),
+        static_cast<GLubyte>(v[2] * 255)
+    };
+    if (!sameValue(ncol, value)) {
+        value = ncol;
+        return true;
+    }
+    return false;
+}
 
-            auto anchor = node->getAnchorPoint();
-            ImGui::DragFloat2("Anchor Point", &anchor.x, 0.05f, 0.f, 1.f);
-            if (node->getAnchorPoint() != anchor) {
-                registerNodeAsModified(node);
-            }
-            node->setAnchorPoint(anchor);
+bool editProperty(property<GLubyte> const& prop, GLubyte& value) {
+    int v = value;
+    ImGui::SliderInt(prop.name, &v, static_cast<int>(prop.min), static_cast<int>(prop.max));
+    if (v != value) {
+        value = static_cast<GLubyte>(v);
+        return true;
+    }
+    return false;
+}
 
-            auto contentSize = node->getContentSize();
-            ImGui::DragFloat2("Content Size", &contentSize.width);
-            if (contentSize != node->getContentSize()) {
-                node->setContentSize(contentSize);
-                registerNodeAsModified(node);
-            }
+bool showNodeAttributes(CCNode* node) {
+    if (ImGui::Button("Delete")) {
+        g_journal.deleteNode(node);
+        g_changes.prune();
+        return false;
+    }
 
-            int zOrder = node->getZOrder();
-            ImGui::InputInt("Z", &zOrder);
-            if (node->getZOrder() != zOrder) {
-                node->setZOrder(zOrder);
-                registerNodeAsModified(node);
-            }
-            
-            auto visible = node->isVisible();
-            ImGui::Checkbox("Visible", &visible);
-            if (visible != node->isVisible()) {
-                node->setVisible(visible);
-                registerNodeAsModified(node);
-            }
+    // anything edited below gets compared against the values from here
+    g_changes.track(node);
+    // deferred properties are journaled from the command queue
+    g_journal.begin(node);
+    g_journal.touch(node, npAll & ~npText);
+    ImGui::SameLine();
+    if (ImGui::Button("Add Child")) {
+        addTarget = node;
+        ImGui::OpenPopup("Add Child");
+    }
+    selectAddNode();
+    ImGui::SameLine();
+    if (ImGui::Button("Highlight")) {
+        highlightNode(node);
+    }
 
-            if (dynamic_cast<CCRGBAProtocol*>(node) != nullptr) {
-                auto rgbaNode = dynamic_cast<CCRGBAProtocol*>(node);
-                auto color = rgbaNode->getColor();
-                float _color[4] = { color.r / 255.f, color.g / 255.f, color.b / 255.f, rgbaNode->getOpacity() / 255.f };
-                ImGui::ColorEdit4("Color", _color);
-                auto ncol = ccColor3B {
-                    static_cast<GLubyte>(_color[0] * 255),
-                    static_cast<GLubyte>(_color[1] * 255),
-                    static_cast<GLubyte>(_color[2] * 255)
-                };
-                auto nopacity = static_cast<GLubyte>(_color[3] * 255);
-                if (rgbaNode->getColor() != ncol || rgbaNode->getOpacity() != nopacity)
-                    registerNodeAsModified(node);
-                rgbaNode->setColor(ncol);
-                rgbaNode->setOpacity(nopacity);
-            }
-            if (dynamic_cast<CCLabelProtocol*>(node) != nullptr) {
-                auto labelNode = dynamic_cast<CCLabelProtocol*>(node);
-                auto labelStr = labelNode->getString();
-                char text[256];
-                strcpy_s(text, labelStr);
-                ImGui::InputText("Text", text, 256);
-                if (strcmp(text, labelStr)) {
-                    threadFunctionsMutex.lock();
-                    threadFunctions.push([labelNode, text]() {
-                        labelNode->setString(text);
-                    });
-                    registerNodeAsModified(node);
-                    threadFunctionsMutex.unlock();
-                }
-            }
+    ImGui::Text("Addr: 0x%p", node);
+    ImGui::SameLine();
+    if (ImGui::Button("Copy")) {
+        std::stringstream stream;
+        stream << std::uppercase << std::hex << reinterpret_cast<uintptr_t>(node);
+        clipboardText(stream.str().c_str());
+    }
+    if (node->getUserData()) {
+        ImGui::Text("User data: 0x%p", node->getUserData());
+    }
 
-            ImGui::TreePop();
-        }
-        
-        auto children = node->getChildren();
-        for (unsigned int i = 0; i < node->getChildrenCount(); ++i) {
-            auto child = children->objectAtIndex(i);
-            generateTree(dynamic_cast<CCNode*>(child), i, hix + 1);
+    if (ImGui::Button("Copy Pos")) {
+        auto pos = node->getPosition();
+        clipboardText(std::string(
+            std::to_string(static_cast<int>(roundf(pos.x))) + ".0f, " +
+            std::to_string(static_cast<int>(roundf(pos.y))) + ".0f"
+        ).c_str());
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Copy Pos WC")) {
+        auto winSize = CCDirector::sharedDirector()->getWinSize();
+        auto pos = node->getParent()->convertToWorldSpace(node->getPosition());
+        pos.x -= winSize.width / 2;
+        pos.y -= winSize.height / 2;
+        pos.x = roundf(pos.x);
+        pos.y = roundf(pos.y);
+        auto str =
+        std::string("winSize.width / 2 ") + (pos.x < 0.0f ? "- " : "+ ") +
+            std::to_string(static_cast<int>(fabsf(pos.x))) + ".0f" +
+            ", winSize.height / 2 " + (pos.y < 0.0f ? "- " : "+ ") +
+            std::to_string(static_cast<int>(fabsf(pos.y))) + ".0f";
+        clipboardText(str.c_str());
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Copy Abs Pos")) {
+        auto pos = node->getParent()->convertToWorldSpace(node->getPosition());
+        clipboardText(std::string(
+            std::to_string(static_cast<int>(roundf(pos.x))) + ".0f, " +
+            std::to_string(static_cast<int>(roundf(pos.y))) + ".0f"
+        ).c_str());
+    }
+
+    auto& type = getNodeType(node);
+
+    forEachProperty([&](auto const& prop) {
+        if (!prop.appliesTo(type))
+            return;
+
+        auto value = prop.get(node, type);
+        if (!editProperty(prop, value))
+            return;
+
+        if (prop.flags & pfDeferred) {
+            // only the last value set before the next frame gets applied
+            g_mainQueue.push([node, &prop, value]() {
+                g_journal.begin(node);
+                g_journal.touch(node, prop.bit);
+                prop.set(node, getNodeType(node), value);
+                g_journal.commit();
+            }, node, prop.bit);
+        } else {
+            prop.set(node, type, value);
         }
-        ImGui::TreePop();
+        registerNodeAsModified(node, prop.bit);
+    });
+
+    g_journal.commit();
+
+    return true;
+}
+
+// a drag's transaction is opened on press, but the release can happen
+// where the mouse hook never sees it (over an imgui window, or after
+// leaving edit mode), so this is also called once the button is up
+void endDragJournal() {
+    if (!journalingDrag)
+        return;
+    g_journal.commit();
+    journalingDrag = false;
+}
+
+void stepJournal(bool undo) {
+    auto step = undo ? g_journal.undo() : g_journal.redo();
+
+    if (step.structural) {
+        highlightedNode = nullptr;
+        selectedNode = nullptr;
+        g_frame.invalidate();
+        g_treeView.invalidate();
+        g_changes.prune();
     }
 }
 
@@ -1113,20 +886,37 @@ void highlightNodeUnderMouse(CCDirector* director) {
         return;
     if (!CCDirector::sharedDirector()->getTouchDispatcher()->isDispatchEvents())
         return;
+
+    PROFILE_SCOPE(pzHover);
     
     auto scene = director->getRunningScene();
     
     auto mpos = getRelativeMousePos();
-    
-    auto array = CCArray::create();
-    getNodesUnderMouse(getLastChild(scene), array, mpos, addingNode);
-    auto node = getTopMost(array);
+
+    auto root = getLastChild(scene);
+    if (g_nodeIndex.needsRebuild(root)) {
+        g_nodeIndex.build(root);
+    } else {
+        // nodes the game moves by itself are only noticed here, so keep
+        // looking for them while idle, just at a slower pace
+        g_nodeIndex.validateSlice(hoverIdle ? 256 : 2048);
+        g_nodeIndex.refresh();
+    }
+
+    // the same mouse position over the same bounds hits the same node
+    auto stamp = g_generation.stamp(gsStructure | gsProperties | gsMouse) + g_nodeIndex.version();
+    hoverIdle = !hoverWatch.changed(stamp) && addingNode == hoverAdding;
+    if (!hoverIdle) {
+        hoveredNode = g_nodeIndex.nodeAt(mpos, addingNode);
+        hoverAdding = addingNode;
+    }
+    auto node = hoveredNode;
     
     highlightedNode = node;
 
     highlightNode(node, addingNode ? hlAlt : hlNormal);
 
-    if (addingNode) {
+    if (addingNode && node) {
         CCObject* child;
         CCARRAY_FOREACH(node->getChildren(), child)
             highlightNode(reinterpret_cast<CCNode*>(child));
@@ -1139,7 +929,7 @@ int intersectsModifyControls() {
 
     auto mpos = getRelativeMousePos();
 
-    auto pos = selectedNode->getParent()->convertToWorldSpace(selectedNode->getPosition());
+    auto pos = g_frame.toWorld(selectedNode->getParent(), selectedNode->getPosition());
     auto size = selectedNode->getScaledContentSize();
     pos = pos - size / 2;
 
@@ -1161,16 +951,14 @@ void showModifyControls() {
 
     auto size = getNodeRectInWindowSpace(selectedNode);
     auto pos = size.origin;
-    auto rectfw = convertGlobalPointToWindowSpace({ 15.0f, 0.0f }).x;
-
-    ImDrawList& list = *ImGui::GetForegroundDrawList();
+    auto rectfw = g_frame.toWindow(CCPoint { 15.0f, 0.0f }).x;
 
-    list.AddRectFilled(
+    g_overlay.fill(
         { pos.x - rectfw / 2, pos.y - rectfw / 2 },
         { pos.x + rectfw / 2, pos.y + rectfw / 2 },
         intersectsModifyControls() == 1 ? 0xffffff00 : 0xff0000ff
     );
-    list.AddRectFilled(
+    g_overlay.fill(
         { pos.x - rectfw / 2, pos.y + size.size.height - rectfw / 2 },
         { pos.x + rectfw / 2, pos.y + size.size.height + rectfw / 2 },
         intersectsModifyControls() == 2 ? 0xffffff00 : 0xff0ff0ff
@@ -1179,7 +967,7 @@ void showModifyControls() {
     if (resizingNode) {
         auto mpos = getRelativeMousePos();
 
-        auto mposn = selectedNode->getParent()->convertToNodeSpace(mpos);
+        auto mposn = g_frame.toNode(selectedNode->getParent(), mpos);
         auto npos = selectedNode->getPosition();
         auto clickOffset2 = npos - mposn;
 
@@ -1188,6 +976,7 @@ void showModifyControls() {
 
         if (resizingNode == 1) {
             selectedNode->setContentSize(clickOffset2 * 2 / selectedNode->getScale());
+            registerNodeAsModified(selectedNode, npContentSize);
         }
 
         if (resizingNode == 2) {
@@ -1196,20 +985,269 @@ void showModifyControls() {
 
             selectedNode->setScaleX(scaleX);
             selectedNode->setScaleY(scaleY);
+            registerNodeAsModified(selectedNode, npScale);
         }
+    }
+}
+
+// snapshots go out whenever the scene or the query changed, and every
+// half a second otherwise to catch what the game moved by itself. the
+// previous one has to be finished first, nothing ever waits on it
+void updateAnalysis() {
+    g_analysis.poll();
+
+    if (g_analysis.busy())
+        return;
+
+    auto stamp = g_generation.stamp(gsStructure | gsProperties) + static_cast<uint32_t>(std::hash<std::string>()(analysisQuery));
+    auto now = ImGui::GetTime();
+    if (!snapshotWatch.changed(stamp) && now - lastSnapshotTime < 0.5)
+        return;
 
-        registerNodeAsModified(selectedNode);
+    PROFILE_SCOPE(pzSnapshot);
+    auto snapshot = g_analysis.acquireSnapshot();
+    captureSnapshot(*snapshot, ++snapshotSequence);
+    g_analysis.submit(snapshot, analysisQuery);
+    lastSnapshotTime = now;
+}
+
+void showAnalysis() {
+    auto& stats = g_analysis.stats();
+    ImGui::Text(
+        "Nodes: %u, visible %u, offscreen %u, empty %u, labels %u, depth %u",
+        stats.nodes, stats.visible, stats.offscreen, stats.empty, stats.labels, stats.maxDepth
+    );
+    ImGui::Text("Snapshot %.3f ms, analysis %.3f ms", stats.captureMs, stats.analysisMs);
+
+    std::string types;
+    for (size_t i = 0; i < stats.types.size() && i < 8; i++)
+        types += std::string(stats.types[i].name) + " x" + std::to_string(stats.types[i].count) + "; ";
+    ImGui::TextUnformatted(types.c_str());
+
+    ImGui::PushItemWidth(200.0f);
+    ImGui::InputText("Find", analysisQuery, sizeof(analysisQuery));
+    ImGui::PopItemWidth();
+
+    auto& results = g_analysis.search();
+    if (results.query.empty())
+        return;
+
+    ImGui::SameLine();
+    ImGui::Text("%u found (%.3f ms)", results.total, results.analysisMs);
+
+    for (auto const& hit : results.hits) {
+        ImGui::PushID(hit.node);
+        auto label = std::string(hit.name) + " (" + std::to_string(hit.tag) + ") " + hit.text;
+        // the node may be gone since the snapshot was taken
+        if (ImGui::Selectable(label.c_str()) && g_mirror.find(hit.node) != SceneMirror::npos)
+            openLocation = getNodeLocationInTree(hit.node);
+        ImGui::PopID();
     }
 }
 
+// the visit/draw hooks are created disabled and only switched on while
+// profiling, so they cost nothing the rest of the time
+void setDrawProfiling(bool enable) {
+    for (auto target : drawHookTargets) {
+        if (enable)
+            MH_EnableHook(target);
+        else
+            MH_DisableHook(target);
+    }
+    g_drawProfiler.reset();
+}
+
+// same deal for the timer and action hooks
+void setSchedProfiling(bool enable) {
+    for (auto target : schedHookTargets) {
+        if (enable)
+            MH_EnableHook(target);
+        else
+            MH_DisableHook(target);
+    }
+    g_schedProfiler.reset();
+}
+
+void showSearch() {
+    ImGui::PushItemWidth(300.0f);
+    ImGui::InputText("Search", searchText, sizeof(searchText));
+    ImGui::PopItemWidth();
+
+    // predicates read the nodes live, so edits and index changes also
+    // make the results stale, not just a different query
+    auto stale = searchWatch.changed(g_generation.stamp(gsStructure | gsProperties));
+    if (searchVersion != g_searchIndex.version()) {
+        searchVersion = g_searchIndex.version();
+        stale = true;
+    }
+    if (searchRan != searchText) {
+        searchRan = searchText;
+        searchQuery = g_searchIndex.parse(searchRan);
+        stale = true;
+    }
+
+    if (searchRan.empty())
+        return;
+
+    if (!searchQuery.error.empty()) {
+        ImGui::SameLine();
+        ImGui::TextUnformatted(searchQuery.error.c_str());
+        return;
+    }
+
+    if (stale)
+        g_searchIndex.run(searchQuery);
+
+    auto& stats = g_searchIndex.stats();
+    ImGui::SameLine();
+    ImGui::Text("%u of %u nodes (%.3f ms)", stats.matched, stats.nodes, stats.queryMs);
+
+    ImGui::BeginChild("search results", ImVec2(0.0f, 150.0f), true);
+    for (auto node : g_searchIndex.results()) {
+        ImGui::PushID(node);
+        auto label = std::string(getNodeName(node)) + " (" + std::to_string(node->getTag()) + ")";
+        if (auto lbl = getNodeType(node).asLabel(node))
+            label += std::string(" ") + lbl->getString();
+        if (ImGui::Selectable(label.c_str()) && g_mirror.find(node) != SceneMirror::npos)
+            openLocation = getNodeLocationInTree(node);
+        ImGui::PopID();
+    }
+    ImGui::EndChild();
+}
+
+// selected nodes are retained, the game may remove and free them while
+// they're still selected
+void clearSelection() {
+    for (auto node : g_selection)
+        node->release();
+    g_selection.clear();
+}
+
+void selectMatches() {
+    clearSelection();
+    if (!g_selector.compile(selectorText))
+        return;
+
+    g_selector.match(g_mirror.nodes(), g_selection);
+    for (auto node : g_selection)
+        node->retain();
+}
+
+struct selection_edit {
+    CCPoint offset;
+    float scale;
+};
+
+// the whole selection is changed by a single command, so it's undone in
+// one go and no other command lands in between
+void editSelection(selection_edit edit) {
+    unsigned int props = 0;
+    if (edit.offset.x != 0.0f || edit.offset.y != 0.0f)
+        props |= npPosition;
+    if (edit.scale != 1.0f)
+        props |= npScale;
+    if (!props || g_selection.empty())
+        return;
+
+    // the command keeps its own references, the selection may be
+    // cleared before the queue is drained
+    for (auto node : g_selection)
+        node->retain();
+
+    auto pushed = g_mainQueue.push([nodes = g_selection, edit, props]() {
+        // every edit is its own step, a nullptr key never merges
+        g_journal.begin();
+        for (auto node : nodes) {
+            // removed since it was selected
+            if (g_mirror.find(node) == SceneMirror::npos)
+                continue;
+
+            g_changes.track(node);
+            g_journal.touch(node, props);
+            if (props & npPosition)
+                node->setPosition(node->getPosition() + edit.offset);
+            if (props & npScale) {
+                node->setScaleX(node->getScaleX() * edit.scale);
+                node->setScaleY(node->getScaleY() * edit.scale);
+            }
+            registerNodeAsModified(node, props);
+        }
+        g_journal.commit();
+
+        for (auto node : nodes)
+            node->release();
+    });
+    if (!pushed) {
+        for (auto node : g_selection)
+            node->release();
+    }
+}
+
+void showSelector() {
+    ImGui::PushItemWidth(300.0f);
+    auto enter = ImGui::InputText(
+        "Selector", selectorText, sizeof(selectorText), ImGuiInputTextFlags_EnterReturnsTrue
+    );
+    ImGui::PopItemWidth();
+    ImGui::SameLine();
+    if (ImGui::Button("Select") || enter)
+        selectMatches();
+    ImGui::SameLine();
+    if (ImGui::Button("Clear"))
+        clearSelection();
+    ImGui::SameLine();
+    if (g_selector.error().size())
+        ImGui::TextUnformatted(g_selector.error().c_str());
+    else
+        ImGui::Text("%u selected", static_cast<unsigned int>(g_selection.size()));
+
+    if (g_selection.empty())
+        return;
+
+    ImGui::PushItemWidth(150.0f);
+    ImGui::InputFloat2("##offset", selectionOffset);
+    ImGui::SameLine();
+    if (ImGui::Button("Move"))
+        editSelection({ ccp(selectionOffset[0], selectionOffset[1]), 1.0f });
+    ImGui::SameLine();
+    ImGui::InputFloat("##scale", &selectionScale, 0.05f);
+    ImGui::SameLine();
+    if (ImGui::Button("Scale"))
+        editSelection({ CCPointZero, selectionScale });
+    ImGui::PopItemWidth();
+}
+
 void RenderMain() {
+    PROFILE_SCOPE(pzRenderMain);
     auto director = CCDirector::sharedDirector();
+    auto const& display = ImGui::GetMainViewport()->Size;
+    g_frame.setWindowSize(CCSize { display.x, display.y });
+    g_mirror.sync(director->getRunningScene());
+    g_generation.trackMouse(getRelativeMousePos());
+    if (analysisEnabled)
+        updateAnalysis();
 
     if (!selectedNode)
         modifyingNode = false;
 
+    if (journalingDrag && (editMode != eEdit || !ImGui::GetIO().MouseDown[0])) {
+        endDragJournal();
+        if (mouseBtnDown == 0)
+            mouseBtnDown = -1;
+    }
+
     moveSelectedNode();
+    if (drawProfilerEnabled) {
+        g_drawProfiler.endFrame();
+        if (drawHeatEnabled)
+            showDrawHeat();
+    }
+    if (showBoundsEnabled)
+        showAllBounds(director);
     highlightNodeUnderMouse(director);
+    for (auto node : g_selection)
+        if (g_mirror.find(node) != SceneMirror::npos)
+            highlightNode(node, hlAltOutline);
     highlightNode(selectedNode, hlSelected);
     showModifyControls();
     
@@ -1223,6 +1261,7 @@ void RenderMain() {
         if (ImGui::Begin("CocosDesigner"), nullptr, ImGuiWindowFlags_HorizontalScrollbar | ImGuiWindowFlags_AlwaysHorizontalScrollbar) {
             if (ImGui::RadioButton("Edit Mode", editMode == eEdit)) {
                 editMode = editMode == eEdit ? eNormal : eEdit;
+                endDragJournal();
                 selectedNode = nullptr;
                 highlightedNode = nullptr;
             }
@@ -1245,20 +1284,120 @@ void RenderMain() {
                 ImGui::Checkbox("Node Edges", &snapNodeSidesEnabled);
             }
             ImGui::Checkbox("Only Delete Selected", &onlyDeleteSelected);
+            ImGui::SameLine();
+            ImGui::Checkbox("Show All Bounds", &showBoundsEnabled);
+            if (showBoundsEnabled) {
+                auto& overlayStats = g_overlay.stats();
+                ImGui::SameLine();
+                ImGui::Text(
+                    "%u drawn, %u culled, %u dropped, %u styles",
+                    overlayStats.drawn, overlayStats.culled,
+                    overlayStats.dropped, overlayStats.styles
+                );
+            }
+
+            if (ImGui::Button("Undo"))
+                stepJournal(true);
+            ImGui::SameLine();
+            if (ImGui::Button("Redo"))
+                stepJournal(false);
+            ImGui::SameLine();
+            ImGui::Text(
+                "%u / %u (%.1f KB)", g_journal.undoCount(), g_journal.size(),
+                g_journal.bytes() / 1024.0f
+            );
+            ImGui::SameLine();
+            ImGui::PushItemWidth(100.0f);
+            if (ImGui::InputInt("History KB", &g_journalBudgetKb, 256)) {
+                if (g_journalBudgetKb < 0)
+                    g_journalBudgetKb = 0;
+                g_journal.setBudget(static_cast<size_t>(g_journalBudgetKb) << 10);
+            }
+            ImGui::PopItemWidth();
             ImGui::NewLine();
 
             ImGui::Checkbox("Save Changes", &saveChanges);
             ImGui::SameLine();
-            ImGui::Text("Modified nodes: %d, scenes: %d", changedNodes.size(), scenes.size());
+            ImGui::Text("Modified nodes: %d, scenes: %d", g_changes.dirtyCount(), scenes.size());
 
-            std::string ss = "";
-            for (auto [key, val] : scenes)
-                ss += key + " -> " + std::to_string (val.nodes.size()) + "; ";
-            ImGui::Text(ss.c_str());
+            if (summaryWatch.changed(g_generation.stamp(gsEdits))) {
+                sceneSummary.clear();
+                for (auto const& [key, val] : scenes)
+                    sceneSummary += key + " -> " + std::to_string(val.nodes.size()) + "; ";
+            }
+            ImGui::TextUnformatted(sceneSummary.c_str());
             ImGui::Text(movedToScene.c_str());
 
             ImGui::Text("%.2f", temp_dist_left);
 
+            auto queueStats = g_mainQueue.stats();
+            ImGui::Text(
+                "Queue: %u (max %u), drain %.3f ms, ran %llu, coalesced %u, dropped %u",
+                queueStats.depth, queueStats.maxDepth, queueStats.drainMs,
+                queueStats.executed, queueStats.coalesced, queueStats.dropped
+            );
+
+            auto& taskStats = g_tasks.stats();
+            ImGui::PushItemWidth(100.0f);
+            if (ImGui::InputFloat("Task budget (ms)", &g_taskBudgetMs, 0.25f)) {
+                if (g_taskBudgetMs < 0.1f)
+                    g_taskBudgetMs = 0.1f;
+                g_tasks.setBudget(g_taskBudgetMs);
+            }
+            ImGui::PopItemWidth();
+            ImGui::SameLine();
+            ImGui::Text(
+                "last %.3f ms, %u over budget, %u done, %u cancelled",
+                taskStats.lastMs, taskStats.overruns, taskStats.completed, taskStats.cancelled
+            );
+            unsigned int cancelTask = 0;
+            for (auto const& t : g_tasks.tasks()) {
+                ImGui::PushID(t.id);
+                if (ImGui::SmallButton("Cancel"))
+                    cancelTask = t.id;
+                ImGui::PopID();
+                ImGui::SameLine();
+                ImGui::ProgressBar(
+                    t.total ? static_cast<float>(t.done) / t.total : 0.0f, ImVec2(150.0f, 0.0f)
+                );
+                ImGui::SameLine();
+                ImGui::Text("%s (%.1f ms over %u frames)", t.name.c_str(), t.ms, t.frames);
+            }
+            if (cancelTask)
+                g_tasks.cancel(cancelTask);
+
+            ImGui::Checkbox("Background Analysis", &analysisEnabled);
+            if (analysisEnabled)
+                showAnalysis();
+
+            if (ImGui::Checkbox("Scheduler Profiler", &schedProfilerEnabled))
+                setSchedProfiling(schedProfilerEnabled);
+            if (schedProfilerEnabled) {
+                // the node may be gone since it last ran
+                auto node = showSchedProfiler(g_schedProfiler);
+                if (node && g_mirror.find(node) != SceneMirror::npos)
+                    openLocation = getNodeLocationInTree(node);
+            }
+
+            if (ImGui::Checkbox("Draw Profiler", &drawProfilerEnabled))
+                setDrawProfiling(drawProfilerEnabled);
+            if (drawProfilerEnabled) {
+                auto& drawStats = g_drawProfiler.stats();
+                ImGui::SameLine();
+                ImGui::Checkbox("Heat", &drawHeatEnabled);
+                ImGui::SameLine();
+                ImGui::Text(
+                    "%u nodes, scene %.3f ms, slowest %.3f ms",
+                    drawStats.nodes, drawStats.frameMs, drawStats.maxExclusive
+                );
+            }
+
+#ifdef DESIGNER_PROFILE
+            ImGui::Checkbox("Profiler", &profilerEnabled);
+            if (profilerEnabled)
+                showProfiler();
+#endif
+
             ImGui::NewLine();
             ImGui::Separator();
             ImGui::NewLine();
@@ -1269,8 +1408,15 @@ void RenderMain() {
                 openAddPopup = false;
             }
             
+            g_searchIndex.update();
+            showSearch();
+            showSelector();
+
             auto curScene = director->getRunningScene();
-            generateTree(curScene);
+            if (openLocation.size())
+                g_treeView.openPath(curScene, openLocation);
+            g_treeView.setColumns(drawProfilerEnabled ? showDrawCost : nullptr, 400.0f);
+            g_treeView.render(curScene, showNodeAttributes, g_generation.stamp(gsStructure));
         }
         if (openLocation.size())
             openLocation.clear();
@@ -1288,19 +1434,35 @@ void RenderMain() {
         highlightedNode = nullptr;
         selectedNode = nullptr;
     }
+
+    g_overlay.flush(*ImGui::GetForegroundDrawList());
 }
 
 inline void(__thiscall* willSwitchToScene)(CCDirector*, CCScene*);
 void __fastcall willSwitchToSceneHook(CCDirector* self, void*, CCScene* nScene) {
-    if (saveChanges) {
-        saveSceneChanges(self->getRunningScene());
-    }
+    {
+        PROFILE_SCOPE(pzSceneHook);
+        g_tasks.cancel(editLoadTask);
+
+        if (saveChanges) {
+            saveSceneChanges(self->getRunningScene());
+            g_editStore.save(scenes);
+        }
 
-    changedNodes.clear();
+        g_changes.clear();
+        g_journal.clear();
+        // the index retains every node it holds, which would keep the
+        // outgoing scene alive until the next rebuild
+        g_nodeIndex.clear();
+        g_alignIndex.clear();
+        clearSelection();
+        journalingDrag = false;
+    }
 
     willSwitchToScene(self, nScene);
 
     if (saveChanges) {
+        PROFILE_SCOPE(pzSceneHook);
         loadSceneChanges(nScene);
     }
 }
@@ -1315,6 +1477,8 @@ void __fastcall onGLFWMouseCallBackHook(CCEGLView* self, void*, GLFWwindow* wnd,
     if (addPopupOpen)
         return;
 
+    PROFILE_SCOPE(pzMouseHook);
+
     if (pressed) {
         switch (btn) {
             case 0:
@@ -1332,7 +1496,16 @@ void __fastcall onGLFWMouseCallBackHook(CCEGLView* self, void*, GLFWwindow* wnd,
             } break;
         }
         mouseBtnDown = btn;
+
+        // a whole drag or resize is undone in one go
+        if (btn == 0 && selectedNode && !journalingDrag) {
+            g_journal.begin(selectedNode);
+            g_journal.touch(selectedNode, npPosition | npContentSize | npScale);
+            journalingDrag = true;
+        }
     } else {
+        endDragJournal();
+
         if (!resizingNode && btn == 0 && modifyingNode && selectedNode == highlightedNode && !selectionMoved) {
             selectedNode = nullptr;
             modifyingNode = false;
@@ -1365,28 +1538,39 @@ bool __fastcall dispatchScrollMSGHook(CCMouseDelegate* self, void*, float deltaY
     if (!CCDirector::sharedDirector()->getTouchDispatcher()->isDispatchEvents())
         return true;
 
+    PROFILE_SCOPE(pzScrollHook);
+
     auto target = selectedNode ? selectedNode : highlightedNode;
 
     if (!target) return true;
 
     auto otarget = target;
-    if (dynamic_cast<CCMenuItemSprite*>(target))
-        target = dynamic_cast<CCMenuItemSprite*>(target)->getNormalImage();
+    if (getNodeType(target).is(ntMenuItemSprite))
+        target = static_cast<CCMenuItemSprite*>(target)->getNormalImage();
 
     auto kb = CCDirector::sharedDirector()->getKeyboardDispatcher();
 
-    if (kb->getShiftKeyPressed())
+    g_changes.track(target);
+    g_journal.begin(target);
+    g_journal.touch(target, npRotation | npScale);
+
+    if (kb->getShiftKeyPressed()) {
         target->setRotation(target->getRotation() + (-deltaY / 3.0f));
-    else
+        registerNodeAsModified(target, npRotation);
+    } else {
         target->setScale(target->getScale() * (deltaY / 96.0f + 1.0f));
+        registerNodeAsModified(target, npScale);
+    }
 
-    registerNodeAsModified(otarget);
+    g_journal.commit();
+    g_nodeIndex.markDirty(otarget);
 
     return true;
 }
 
 inline void(__thiscall* dispatchKeyboardMSG)(void* self, int key, bool down);
 void __fastcall dispatchKeyboardMSGHook(void* self, void*, int key, bool down) {
+    PROFILE_SCOPE(pzKeyboardHook);
 
     if (ImGui::GetIO().WantCaptureKeyboard)
         return;
@@ -1400,6 +1584,15 @@ void __fastcall dispatchKeyboardMSGHook(void* self, void*, int key, bool down) {
             
             case 'J':
                 editMode = editMode == eEdit ? eNormal :  eEdit;
+                endDragJournal();
+                break;
+
+            case 'Z': case 'Y':
+                if (
+                    editMode == eEdit &&
+                    CCDirector::sharedDirector()->getKeyboardDispatcher()->getControlKeyPressed()
+                )
+                    stepJournal(key == 'Z');
                 break;
 
             case KEY_Delete:
@@ -1408,9 +1601,11 @@ void __fastcall dispatchKeyboardMSGHook(void* self, void*, int key, bool down) {
                         return;
                     
                     if (onlyDeleteSelected)
-                        selectedNode->removeFromParentAndCleanup(true);
-                    else
-                        highlightedNode->removeFromParentAndCleanup(true);
+                        g_journal.deleteNode(selectedNode);
+                    else if (highlightedNode)
+                        g_journal.deleteNode(highlightedNode);
+                    g_treeView.invalidate();
+                    g_changes.prune();
 
                     if (selectedNode == highlightedNode) {
                         highlightedNode = nullptr;
@@ -1426,15 +1621,134 @@ void __fastcall dispatchKeyboardMSGHook(void* self, void*, int key, bool down) {
     dispatchKeyboardMSG(self, key, down);
 }
 
+inline void(__thiscall* addChild)(CCNode* self, CCNode* child, int zOrder, int tag);
+void __fastcall addChildHook(CCNode* self, void*, CCNode* child, int zOrder, int tag) {
+    addChild(self, child, zOrder, tag);
+
+    PROFILE_SCOPE(pzChildHooks);
+    g_mirror.childrenChanged(self);
+}
+
+inline void(__thiscall* removeChild)(CCNode* self, CCNode* child, bool cleanup);
+void __fastcall removeChildHook(CCNode* self, void*, CCNode* child, bool cleanup) {
+    // beforehand, the child may not outlive its removal
+    {
+        PROFILE_SCOPE(pzChildHooks);
+        g_mirror.removing(self, child);
+    }
+    removeChild(self, child, cleanup);
+}
+
+inline void(__thiscall* removeAllChildren)(CCNode* self, bool cleanup);
+void __fastcall removeAllChildrenHook(CCNode* self, void*, bool cleanup) {
+    {
+        PROFILE_SCOPE(pzChildHooks);
+        g_mirror.removing(self, nullptr);
+    }
+    removeAllChildren(self, cleanup);
+}
+
+// the array itself is only sorted on the next visit, the mirror
+// catches up after that since it's synced from RenderMain
+inline void(__thiscall* reorderChild)(CCNode* self, CCNode* child, int zOrder);
+void __fastcall reorderChildHook(CCNode* self, void*, CCNode* child, int zOrder) {
+    reorderChild(self, child, zOrder);
+
+    PROFILE_SCOPE(pzChildHooks);
+    g_mirror.childrenChanged(self);
+}
+
+inline void(__thiscall* nodeCleanup)(CCNode* self);
+void __fastcall nodeCleanupHook(CCNode* self, void*) {
+    {
+        PROFILE_SCOPE(pzChildHooks);
+        g_mirror.cleanedUp(self);
+    }
+    nodeCleanup(self);
+}
+
 inline void(__thiscall* schUpdate)(CCScheduler* self, float dt);
 void __fastcall schUpdateHook(CCScheduler* self, void*, float dt) {
-    threadFunctionsMutex.lock();
-    while (!threadFunctions.empty()) {
-        threadFunctions.back()();
-        threadFunctions.pop();
+    {
+        PROFILE_SCOPE(pzQueueDrain);
+        g_mainQueue.drain();
+    }
+    {
+        PROFILE_SCOPE(pzTasks);
+        g_tasks.run();
+    }
+
+    if (!schedProfilerEnabled)
+        return schUpdate(self, dt);
+
+    auto start = __rdtsc();
+    schUpdate(self, dt);
+    g_schedProfiler.endFrame(__rdtsc() - start);
+}
+
+// update selectors are called straight from CCScheduler::update through
+// the target's vtable, so only schedule()d selectors get a row. the
+// rest of the scheduler's time shows up as a total
+inline void(__thiscall* timerUpdate)(CCTimer* self, float dt);
+void __fastcall timerUpdateHook(CCTimer* self, void*, float dt) {
+    auto target = static_cast<CCTimerGetter*>(self)->getTarget();
+    if (!target)
+        return timerUpdate(self, dt);
+
+    // looked up first, the callback may unschedule (and free) the timer
+    auto row = g_schedProfiler.row(target, self, skTimer, "schedule", self->getInterval());
+    auto start = __rdtsc();
+    timerUpdate(self, dt);
+    g_schedProfiler.add(row, __rdtsc() - start);
+}
+
+void stepAction(CCAction* self, float dt, void(__thiscall* step)(CCAction*, float)) {
+    auto target = self->getTarget();
+    if (!g_schedProfiler.enterAction() || !target) {
+        step(self, dt);
+        g_schedProfiler.leaveAction();
+        return;
     }
-    threadFunctionsMutex.unlock();
-    return schUpdate(self, dt);
+
+    // msvc names look like "class CCMoveTo"
+    auto row = g_schedProfiler.row(target, typeid(*self).name(), skAction, typeid(*self).name() + 6);
+    auto start = __rdtsc();
+    step(self, dt);
+    g_schedProfiler.add(row, __rdtsc() - start);
+    g_schedProfiler.leaveAction();
+}
+
+inline void(__thiscall* intervalStep)(CCAction* self, float dt);
+void __fastcall intervalStepHook(CCAction* self, void*, float dt) {
+    stepAction(self, dt, intervalStep);
+}
+
+inline void(__thiscall* instantStep)(CCAction* self, float dt);
+void __fastcall instantStepHook(CCAction* self, void*, float dt) {
+    stepAction(self, dt, instantStep);
+}
+
+inline void(__thiscall* nodeVisit)(CCNode* self);
+void __fastcall nodeVisitHook(CCNode* self, void*) {
+    g_drawProfiler.enter(self);
+    nodeVisit(self);
+    g_drawProfiler.leave();
+}
+
+// batch nodes draw their children themselves instead of visiting them,
+// so all of it is charged to the batch node
+inline void(__thiscall* batchNodeVisit)(CCSpriteBatchNode* self);
+void __fastcall batchNodeVisitHook(CCSpriteBatchNode* self, void*) {
+    g_drawProfiler.enter(self);
+    batchNodeVisit(self);
+    g_drawProfiler.leave();
+}
+
+inline void(__thiscall* spriteDraw)(CCSprite* self);
+void __fastcall spriteDrawHook(CCSprite* self, void*) {
+    auto start = __rdtsc();
+    spriteDraw(self);
+    g_drawProfiler.drawn(__rdtsc() - start);
 }
 
 DWORD WINAPI my_thread(void* hModule) {
@@ -1446,6 +1760,21 @@ DWORD WINAPI my_thread(void* hModule) {
     std::cin.rdbuf(conin.rdbuf());  
 #endif
     editMode = eNormal;
+    g_journal.setModifiedHandler(registerNodeAsModified);
+
+    // edits saved in earlier sessions, handed over to the main thread
+    // since that's where `scenes` lives
+    auto loaded = std::make_shared<scene_map>();
+    if (g_editStore.load(*loaded)) {
+        g_mainQueue.push([loaded] {
+            for (auto& [name, scene] : *loaded)
+                for (auto& [location, edit] : scene.nodes) {
+                    scenes[name].rtti_name = name;
+                    mergeNodeEdit(scenes[name].nodes[location], edit);
+                }
+            g_generation.bump(gsEdits);
+        });
+    }
 
     auto cocosBase = GetModuleHandleA("libcocos2d.dll");
     MH_CreateHook(
@@ -1473,12 +1802,83 @@ DWORD WINAPI my_thread(void* hModule) {
         &willSwitchToSceneHook,
         reinterpret_cast<void**>(&willSwitchToScene)
     );
+    MH_CreateHook(
+        GetProcAddress(cocosBase, "?addChild@CCNode@cocos2d@@UAEXPAV12@HH@Z"),
+        &addChildHook,
+        reinterpret_cast<void**>(&addChild)
+    );
+    MH_CreateHook(
+        GetProcAddress(cocosBase, "?removeChild@CCNode@cocos2d@@UAEXPAV12@_N@Z"),
+        &removeChildHook,
+        reinterpret_cast<void**>(&removeChild)
+    );
+    MH_CreateHook(
+        GetProcAddress(cocosBase, "?removeAllChildrenWithCleanup@CCNode@cocos2d@@UAEX_N@Z"),
+        &removeAllChildrenHook,
+        reinterpret_cast<void**>(&removeAllChildren)
+    );
+    MH_CreateHook(
+        GetProcAddress(cocosBase, "?reorderChild@CCNode@cocos2d@@UAEXPAV12@H@Z"),
+        &reorderChildHook,
+        reinterpret_cast<void**>(&reorderChild)
+    );
+    MH_CreateHook(
+        GetProcAddress(cocosBase, "?cleanup@CCNode@cocos2d@@UAEXXZ"),
+        &nodeCleanupHook,
+        reinterpret_cast<void**>(&nodeCleanup)
+    );
     MH_EnableHook(MH_ALL_HOOKS);
 
+    // created after enabling the rest, so they start out disabled
+    auto createDrawHook = [&](char const* name, void* hook, void** orig) {
+        auto target = reinterpret_cast<void*>(GetProcAddress(cocosBase, name));
+        if (target && MH_CreateHook(target, hook, orig) == MH_OK)
+            drawHookTargets.push_back(target);
+    };
+    createDrawHook(
+        "?visit@CCNode@cocos2d@@UAEXXZ",
+        reinterpret_cast<void*>(&nodeVisitHook),
+        reinterpret_cast<void**>(&nodeVisit)
+    );
+    createDrawHook(
+        "?visit@CCSpriteBatchNode@cocos2d@@UAEXXZ",
+        reinterpret_cast<void*>(&batchNodeVisitHook),
+        reinterpret_cast<void**>(&batchNodeVisit)
+    );
+    createDrawHook(
+        "?draw@CCSprite@cocos2d@@UAEXXZ",
+        reinterpret_cast<void*>(&spriteDrawHook),
+        reinterpret_cast<void**>(&spriteDraw)
+    );
+
+    auto createSchedHook = [&](char const* name, void* hook, void** orig) {
+        auto target = reinterpret_cast<void*>(GetProcAddress(cocosBase, name));
+        if (target && MH_CreateHook(target, hook, orig) == MH_OK)
+            schedHookTargets.push_back(target);
+    };
+    createSchedHook(
+        "?update@CCTimer@cocos2d@@UAEXM@Z",
+        reinterpret_cast<void*>(&timerUpdateHook),
+        reinterpret_cast<void**>(&timerUpdate)
+    );
+    createSchedHook(
+        "?step@CCActionInterval@cocos2d@@UAEXM@Z",
+        reinterpret_cast<void*>(&intervalStepHook),
+        reinterpret_cast<void**>(&intervalStep)
+    );
+    createSchedHook(
+        "?step@CCActionInstant@cocos2d@@UAEXM@Z",
+        reinterpret_cast<void*>(&instantStepHook),
+        reinterpret_cast<void**>(&instantStep)
+    );
+
 #ifdef GD_CONSOLE
     std::getline(std::cin, std::string());
 
+    g_analysis.shutdown();
     MH_Uninitialize();
+    // no hook can start another save now
+    g_editStore.flush();
     conout.close();
     conin.close();
     FreeConsole();
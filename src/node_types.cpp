@@ -0,0 +1,73 @@
+#include "node_types.hpp"
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#ifndef _MSC_VER
+#include <cxxabi.h>
+#include <cstdlib>
+#endif
+#include <CCScale9Sprite.h>
+
+namespace {
+    std::unordered_map<void const*, node_type> g_types;
+
+    template <class T>
+    std::ptrdiff_t baseOffset(CCNode* node) {
+        auto base = dynamic_cast<T*>(node);
+        if (!base)
+            return 0;
+        return reinterpret_cast<char*>(base) - reinterpret_cast<char*>(node);
+    }
+
+    node_type classify(CCNode* node) {
+        node_type res {};
+
+        if (dynamic_cast<CCLayer*>(node))           res.traits |= ntLayer;
+        if (dynamic_cast<CCMenu*>(node))            res.traits |= ntMenu;
+        if (dynamic_cast<CCMenuItem*>(node))        res.traits |= ntMenuItem;
+        if (dynamic_cast<CCMenuItemSprite*>(node))  res.traits |= ntMenuItemSprite;
+        if (dynamic_cast<CCRGBAProtocol*>(node))    res.traits |= ntRGBA;
+        if (dynamic_cast<CCLabelProtocol*>(node))   res.traits |= ntLabel;
+        if (dynamic_cast<CCScale9Sprite*>(node))    res.traits |= ntScale9;
+        if (dynamic_cast<CCLabelBMFont*>(node))     res.traits |= ntLabelBMFont;
+        if (dynamic_cast<CCScene*>(node))           res.traits |= ntScene;
+        if (dynamic_cast<CCTransitionScene*>(node)) res.traits |= ntTransition;
+
+        res.rgba = baseOffset<CCRGBAProtocol>(node);
+        res.label = baseOffset<CCLabelProtocol>(node);
+
+        res.name = className(typeid(*node));
+
+        return res;
+    }
+}
+
+char const* className(std::type_info const& type) {
+#ifdef _MSC_VER
+    // msvc names look like "class CCSprite"
+    return type.name() + 6;
+#else
+    static std::unordered_map<std::type_index, std::string> names;
+
+    auto it = names.find(type);
+    if (it != names.end())
+        return it->second.c_str();
+
+    int status;
+    auto demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+    auto& res = names[type];
+    res = status == 0 ? demangled : type.name();
+    std::free(demangled);
+    return res.c_str();
+#endif
+}
+
+node_type const& getNodeType(CCNode* node) {
+    auto vtable = *reinterpret_cast<void const* const*>(node);
+
+    auto it = g_types.find(vtable);
+    if (it != g_types.end())
+        return it->second;
+
+    return g_types.emplace(vtable, classify(node)).first->second;
+}
@@ -0,0 +1,64 @@
+#ifndef __NODE_TYPES_HPP__
+#define __NODE_TYPES_HPP__
+
+#include <cstddef>
+#include <typeinfo>
+#include <cocos2d.h>
+
+using namespace cocos2d;
+
+enum node_trait : unsigned int {
+    ntLayer         = 1 << 0,
+    ntMenu          = 1 << 1,
+    ntMenuItem      = 1 << 2,
+    ntMenuItemSprite = 1 << 3,
+    ntRGBA          = 1 << 4,
+    ntLabel         = 1 << 5,
+    ntScale9        = 1 << 6,
+    ntLabelBMFont   = 1 << 7,
+    ntScene         = 1 << 8,
+    ntTransition    = 1 << 9,
+};
+
+// what we need to know about a concrete node class. every object of the
+// same class shares a vtable, so this is worked out with dynamic_cast
+// once per class and looked up by vtable pointer afterwards
+struct node_type {
+    unsigned int traits;
+    char const* name;           // class name without the "class " prefix
+    std::ptrdiff_t rgba;        // offset of the CCRGBAProtocol base, if ntRGBA
+    std::ptrdiff_t label;       // offset of the CCLabelProtocol base, if ntLabel
+
+    // without any namespace, "CCSprite" for "cocos2d::CCSprite"
+    char const* shortName() const {
+        auto res = name;
+        for (auto c = name; *c; c++)
+            if (*c == ':')
+                res = c + 1;
+        return res;
+    }
+
+    bool is(unsigned int trait) const {
+        return (traits & trait) != 0;
+    }
+
+    CCRGBAProtocol* asRGBA(CCNode* node) const {
+        if (!(traits & ntRGBA))
+            return nullptr;
+        return reinterpret_cast<CCRGBAProtocol*>(reinterpret_cast<char*>(node) + rgba);
+    }
+
+    CCLabelProtocol* asLabel(CCNode* node) const {
+        if (!(traits & ntLabel))
+            return nullptr;
+        return reinterpret_cast<CCLabelProtocol*>(reinterpret_cast<char*>(node) + label);
+    }
+};
+
+node_type const& getNodeType(CCNode* node);
+
+// the class name as msvc spells it, without the "class " prefix.
+// other compilers' names are demangled (once per type)
+char const* className(std::type_info const& type);
+
+#endif
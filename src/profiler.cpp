@@ -0,0 +1,46 @@
+#include "profiler.hpp"
+
+#ifdef DESIGNER_PROFILE
+
+#include <mutex>
+#include <memory>
+#include <algorithm>
+
+namespace {
+    std::mutex s_ringsMutex;
+    std::vector<std::unique_ptr<ProfileRing>> s_rings;
+}
+
+uint64_t ProfileRing::read(uint64_t cursor, std::vector<profile_sample>& out) const {
+    auto head = m_head.load(std::memory_order_acquire);
+    if (head - cursor > capacity)
+        cursor = head - capacity;
+
+    auto first = out.size();
+    for (auto i = cursor; i < head; i++)
+        out.push_back(m_samples[i & (capacity - 1)]);
+
+    // whatever the writer got to in the meantime may have overwritten
+    // the oldest of what was just copied
+    auto after = m_head.load(std::memory_order_acquire);
+    if (after - cursor > capacity) {
+        auto torn = static_cast<size_t>(after - capacity - cursor);
+        out.erase(out.begin() + first, out.begin() + first + std::min(torn, out.size() - first));
+    }
+
+    return head;
+}
+
+ProfileRing* registerProfileRing() {
+    std::lock_guard<std::mutex> lock(s_ringsMutex);
+    s_rings.push_back(std::make_unique<ProfileRing>());
+    return s_rings.back().get();
+}
+
+void profileRings(size_t from, std::vector<ProfileRing*>& out) {
+    std::lock_guard<std::mutex> lock(s_ringsMutex);
+    for (auto i = from; i < s_rings.size(); i++)
+        out.push_back(s_rings[i].get());
+}
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef __PROFILER_HPP__
+#define __PROFILER_HPP__
+
+#include <cstdint>
+
+// scoped timers for the explorer's own hot paths. everything below
+// only exists with DESIGNER_PROFILE defined (see CMakeLists.txt),
+// otherwise PROFILE_SCOPE expands to nothing
+enum profile_zone : uint16_t {
+    pzRenderMain,
+    pzTreeView,
+    pzHover,
+    pzSnap,
+    pzQueueDrain,
+    pzTasks,
+    pzSnapshot,
+    pzMouseHook,
+    pzKeyboardHook,
+    pzScrollHook,
+    pzSceneHook,
+    pzChildHooks,
+
+    pzCount,
+};
+
+#ifdef DESIGNER_PROFILE
+
+#include <atomic>
+#include <vector>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+struct profile_sample {
+    uint64_t start;             // tsc ticks
+    uint32_t ticks;
+    profile_zone zone;
+};
+
+// samples of one thread. only that thread writes, the panel reads
+// whatever hasn't been overwritten yet, so neither side ever waits
+class ProfileRing {
+    public:
+        static constexpr size_t capacity = 1 << 14;
+
+        void push(profile_sample const& sample) {
+            auto head = m_head.load(std::memory_order_relaxed);
+            m_samples[head & (capacity - 1)] = sample;
+            m_head.store(head + 1, std::memory_order_release);
+        }
+
+        // appends the samples pushed since `cursor` and returns the new cursor
+        uint64_t read(uint64_t cursor, std::vector<profile_sample>& out) const;
+
+    protected:
+        profile_sample m_samples[capacity];
+        std::atomic<uint64_t> m_head { 0 };
+};
+
+ProfileRing* registerProfileRing();
+
+inline thread_local ProfileRing* t_profileRing = nullptr;
+
+class profile_scope {
+    public:
+        explicit profile_scope(profile_zone zone) : m_zone(zone), m_start(__rdtsc()) {}
+
+        ~profile_scope() {
+            auto end = __rdtsc();
+            if (!t_profileRing)
+                t_profileRing = registerProfileRing();
+            t_profileRing->push({ m_start, static_cast<uint32_t>(end - m_start), m_zone });
+        }
+
+        profile_scope(profile_scope const&) = delete;
+        profile_scope& operator=(profile_scope const&) = delete;
+
+    protected:
+        profile_zone m_zone;
+        uint64_t m_start;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(zone) profile_scope PROFILE_CONCAT(profileScope_, __LINE__)(zone)
+
+// appends the rings registered after the first `from` of them
+void profileRings(size_t from, std::vector<ProfileRing*>& out);
+
+#else
+
+#define PROFILE_SCOPE(zone)
+
+#endif
+
+#endif
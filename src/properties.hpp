@@ -0,0 +1,179 @@
+#ifndef __PROPERTIES_HPP__
+#define __PROPERTIES_HPP__
+
+#include <tuple>
+#include <string>
+#include <utility>
+#include "scene.hpp"
+#include "node_types.hpp"
+
+enum prop_flag : unsigned int {
+    pfDeferred      = 1 << 0,   // set from the command queue, not mid-frame
+};
+
+// one editable node property. `field` is where node_edit keeps its value
+template <class T>
+struct property {
+    using value_type = T;
+
+    node_prop bit;
+    char const* name;
+    unsigned int traits;        // node_trait bits the node needs, 0 for any node
+    unsigned int flags;
+    T node_edit::* field;
+    T (*get)(CCNode* node, node_type const& type);
+    void (*set)(CCNode* node, node_type const& type, T const& value);
+    float speed;                // inspector drag speed and range, no range if equal
+    float min;
+    float max;
+
+    bool appliesTo(node_type const& type) const {
+        return !traits || type.is(traits);
+    }
+};
+
+// every property the editor knows about, in node_prop bit order. this is
+// also the order values are saved in, so new ones go at the end
+inline constexpr auto nodeProperties = std::make_tuple(
+    property<CCPoint> {
+        npPosition, "Position", 0, 0, &node_edit::position,
+        [](CCNode* node, node_type const&) { return node->getPosition(); },
+        [](CCNode* node, node_type const&, CCPoint const& v) { node->setPosition(v); },
+        1.0f, 0.0f, 0.0f
+    },
+    property<CCPoint> {
+        npAnchorPoint, "Anchor Point", 0, 0, &node_edit::anchorpoint,
+        [](CCNode* node, node_type const&) { return node->getAnchorPoint(); },
+        [](CCNode* node, node_type const&, CCPoint const& v) { node->setAnchorPoint(v); },
+        0.05f, 0.0f, 1.0f
+    },
+    property<CCPoint> {
+        npSkew, "Skew", 0, 0, &node_edit::skew,
+        [](CCNode* node, node_type const&) { return CCPoint { node->getSkewX(), node->getSkewY() }; },
+        [](CCNode* node, node_type const&, CCPoint const& v) {
+            node->setSkewX(v.x);
+            node->setSkewY(v.y);
+        },
+        1.0f, 0.0f, 0.0f
+    },
+    property<CCSize> {
+        npContentSize, "Content Size", 0, 0, &node_edit::content_size,
+        [](CCNode* node, node_type const&) { return node->getContentSize(); },
+        [](CCNode* node, node_type const&, CCSize const& v) { node->setContentSize(v); },
+        1.0f, 0.0f, 0.0f
+    },
+    property<int> {
+        npZOrder, "Z", 0, 0, &node_edit::z_order,
+        [](CCNode* node, node_type const&) { return node->getZOrder(); },
+        [](CCNode* node, node_type const&, int const& v) { node->setZOrder(v); },
+        1.0f, 0.0f, 0.0f
+    },
+    // both x and y go last, so setting the uniform value doesn't win
+    property<vec3f_t> {
+        npScale, "Scale", 0, 0, &node_edit::scale,
+        [](CCNode* node, node_type const&) {
+            return vec3f_t { node->getScaleX(), node->getScaleY(), node->getScale() };
+        },
+        [](CCNode* node, node_type const&, vec3f_t const& v) {
+            node->setScale(v.both);
+            node->setScaleX(v.x);
+            node->setScaleY(v.y);
+        },
+        0.025f, 0.0f, 0.0f
+    },
+    property<vec3f_t> {
+        npRotation, "Rotation", 0, 0, &node_edit::rotation,
+        [](CCNode* node, node_type const&) {
+            return vec3f_t { node->getRotationX(), node->getRotationY(), node->getRotation() };
+        },
+        [](CCNode* node, node_type const&, vec3f_t const& v) {
+            node->setRotation(v.both);
+            node->setRotationX(v.x);
+            node->setRotationY(v.y);
+        },
+        1.0f, 0.0f, 0.0f
+    },
+    property<bool> {
+        npVisible, "Visible", 0, 0, &node_edit::visible,
+        [](CCNode* node, node_type const&) { return node->isVisible(); },
+        [](CCNode* node, node_type const&, bool const& v) { node->setVisible(v); },
+        0.0f, 0.0f, 0.0f
+    },
+    // label children get rebuilt, so not while the tree is being walked
+    property<std::string> {
+        npText, "Text", ntLabel, pfDeferred, &node_edit::text,
+        [](CCNode* node, node_type const& type) { return std::string(type.asLabel(node)->getString()); },
+        [](CCNode* node, node_type const& type, std::string const& v) { type.asLabel(node)->setString(v.c_str()); },
+        0.0f, 0.0f, 0.0f
+    },
+    property<ccColor3B> {
+        npColor, "Color", ntRGBA, 0, &node_edit::color,
+        [](CCNode* node, node_type const& type) { return type.asRGBA(node)->getColor(); },
+        [](CCNode* node, node_type const& type, ccColor3B const& v) { type.asRGBA(node)->setColor(v); },
+        0.0f, 0.0f, 0.0f
+    },
+    property<GLubyte> {
+        npOpacity, "Opacity", ntRGBA, 0, &node_edit::opacity,
+        [](CCNode* node, node_type const& type) { return type.asRGBA(node)->getOpacity(); },
+        [](CCNode* node, node_type const& type, GLubyte const& v) { type.asRGBA(node)->setOpacity(v); },
+        1.0f, 0.0f, 255.0f
+    }
+);
+
+template <class F>
+void forEachProperty(F&& fn) {
+    std::apply([&](auto const&... props) { (fn(props), ...); }, nodeProperties);
+}
+
+// the properties this kind of node has
+inline unsigned int supportedProps(node_type const& type) {
+    unsigned int res = 0;
+    forEachProperty([&](auto const& prop) {
+        if (prop.appliesTo(type))
+            res |= prop.bit;
+    });
+    return res;
+}
+
+// apply the properties `from` has onto `into`
+inline void mergeNodeEdit(node_edit& into, node_edit const& from) {
+    forEachProperty([&](auto const& prop) {
+        if (from.props & prop.bit)
+            into.*prop.field = from.*prop.field;
+    });
+    into.props |= from.props;
+}
+
+// which of `props` hold different values in `a` and `b`
+inline unsigned int diffNodeEdit(node_edit const& a, node_edit const& b, unsigned int props) {
+    unsigned int res = 0;
+    forEachProperty([&](auto const& prop) {
+        if ((props & prop.bit) && !sameValue(a.*prop.field, b.*prop.field))
+            res |= prop.bit;
+    });
+    return res;
+}
+
+// read the properties in `props` that the node has
+inline node_edit captureNodeEdit(CCNode* node, unsigned int props, node_type const& type) {
+    node_edit res;
+    res.props = props & supportedProps(type);
+
+    forEachProperty([&](auto const& prop) {
+        if (res.props & prop.bit)
+            res.*prop.field = prop.get(node, type);
+    });
+
+    return res;
+}
+
+inline void applyNodeEdit(CCNode* node, node_edit const& edit) {
+    auto& type = getNodeType(node);
+
+    forEachProperty([&](auto const& prop) {
+        if ((edit.props & prop.bit) && prop.appliesTo(type))
+            prop.set(node, type, edit.*prop.field);
+    });
+}
+
+#endif
@@ -2,16 +2,59 @@
 #define __SCENE_HPP__
 
 #include <vector>
+#include <map>
+#include <string>
 #include <cocos2d.h>
 
 using namespace cocos2d;
 
 struct vec3f_t {
     float x, y, both;
+
+    bool operator!=(vec3f_t const& other) const {
+        return x != other.x || y != other.y || both != other.both;
+    }
+};
+
+// cocos has no comparison operators for its value types, and ones
+// declared out here wouldn't be found from inside templates anyway
+inline bool sameValue(CCPoint const& a, CCPoint const& b) {
+    return a.x == b.x && a.y == b.y;
+}
+
+inline bool sameValue(CCSize const& a, CCSize const& b) {
+    return a.width == b.width && a.height == b.height;
+}
+
+inline bool sameValue(ccColor3B const& a, ccColor3B const& b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
+template <class T>
+bool sameValue(T const& a, T const& b) {
+    return !(a != b);
+}
+
+enum node_prop : unsigned int {
+    npPosition      = 1 << 0,
+    npAnchorPoint   = 1 << 1,
+    npSkew          = 1 << 2,
+    npContentSize   = 1 << 3,
+    npZOrder        = 1 << 4,
+    npScale         = 1 << 5,
+    npRotation      = 1 << 6,
+    npVisible       = 1 << 7,
+    npText          = 1 << 8,
+    npColor         = 1 << 9,
+    npOpacity       = 1 << 10,
+
+    npAll           = (1 << 11) - 1,
 };
 
+// only the properties set in `props` are meaningful. every field here
+// has an entry in nodeProperties (properties.hpp)
 struct node_edit {
-    std::vector<int> tree_location;
+    unsigned int props = 0;
     CCPoint position;
     CCPoint anchorpoint;
     CCPoint skew;
@@ -20,14 +63,16 @@ struct node_edit {
     vec3f_t scale;
     vec3f_t rotation;
     bool visible;
-    const char* text;
+    std::string text;
     ccColor3B color;
     GLubyte opacity;
 };
 
 struct scene_edit {
-    const char* rtti_name;
-    std::vector<node_edit> nodes;
+    std::string rtti_name;
+    // keyed by location in the tree, so editing the same
+    // node again updates its entry instead of adding one
+    std::map<std::vector<int>, node_edit> nodes;
 };
 
 #endif
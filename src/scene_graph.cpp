@@ -0,0 +1,114 @@
+#include "scene_graph.hpp"
+#include "scene_mirror.hpp"
+#include "properties.hpp"
+#include <algorithm>
+
+const char* getNodeName(CCNode* node) {
+    if (node == nullptr) return "nullptr";
+    return getNodeType(node).name;
+}
+
+bool isContainerNode(CCNode* node) {
+    return getNodeType(node).is(ntLayer | ntMenu);
+}
+
+bool stopCheckingChildren(CCNode* node) {
+    if (getNodeType(node).is(ntMenuItem | ntScale9 | ntLabelBMFont))
+        return true;
+    if (!node->isVisible())
+        return true;
+
+    return false;
+}
+
+std::vector<int> getNodeLocationInTree(CCNode* node) {
+    std::vector<int> res;
+    if (g_mirror.locationOf(node, res))
+        return res;
+
+    // not part of the running scene, e.g. the outgoing one mid transition
+    res.clear();
+    auto c = node;
+
+    while (c->getParent()) {
+        auto par = c->getParent();
+        res.push_back(par->getChildren()->indexOfObject(c));
+        c = par;
+    }
+
+    res.push_back(0);
+
+    std::reverse(res.begin(), res.end());
+
+    return res;
+}
+
+CCNode* getNodeByTreeLocation(CCNode* start, std::vector<int> const& loc) {
+    CCNode* res = start;
+
+    for (auto l : loc) {
+        if (static_cast<int>(res->getChildrenCount()) <= l)
+            return nullptr;
+
+        res = reinterpret_cast<CCNode*>(res->getChildren()->objectAtIndex(l));
+    }
+
+    return res;
+}
+
+scene_edit_applier::scene_edit_applier(CCNode* scene, scene_edit const& edits)
+  : scene(scene), edits(&edits), next(edits.nodes.begin()) {
+    scene->retain();
+}
+
+scene_edit_applier::~scene_edit_applier() {
+    scene->release();
+}
+
+void scene_edit_applier::step() {
+    auto const& [location, edit] = *next++;
+    visited++;
+
+    // the first entry is the scene itself
+    size_t common = 0;
+    if (prev) {
+        while (
+            common < path.size() &&
+            common + 1 < location.size() && common + 1 < prev->size() &&
+            location[common + 1] == (*prev)[common + 1]
+        )
+            common++;
+    }
+    path.resize(common);
+    prev = &location;
+
+    CCNode* node = path.empty() ? scene : path.back();
+    for (auto i = common + 1; node && i < location.size(); i++) {
+        auto ix = location[i];
+        if (ix < 0 || static_cast<int>(node->getChildrenCount()) <= ix)
+            node = nullptr;
+        else
+            node = reinterpret_cast<CCNode*>(node->getChildren()->objectAtIndex(ix));
+        path.push_back(node);
+    }
+
+    if (!node)
+        return;
+
+    applyNodeEdit(node, edit);
+    applied++;
+}
+
+void collectSceneChanges(ChangeTracker& changes, scene_edit& into) {
+    // nodes deleted since they were modified have no location anymore
+    changes.prune();
+
+    for (auto const& entry : changes.entries()) {
+        if (!entry.dirty)
+            continue;
+
+        auto edit = changes.changesOf(entry);
+        if (edit.props)
+            mergeNodeEdit(into.nodes[getNodeLocationInTree(entry.node)], edit);
+    }
+}
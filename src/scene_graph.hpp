@@ -0,0 +1,63 @@
+#ifndef __SCENE_GRAPH_HPP__
+#define __SCENE_GRAPH_HPP__
+
+#include <map>
+#include <vector>
+#include <cocos2d.h>
+#include "scene.hpp"
+#include "change_tracker.hpp"
+
+using namespace cocos2d;
+
+// the explorer's view of the scene graph: names, which nodes the hover
+// logic descends into, tree locations and saved edits. nothing in here
+// touches the window, the hooks or the overlay
+
+const char* getNodeName(CCNode* node);
+
+bool isContainerNode(CCNode* node);
+bool stopCheckingChildren(CCNode* node);
+
+// child indices from the scene down, starting with a 0 for the scene itself
+std::vector<int> getNodeLocationInTree(CCNode* node);
+CCNode* getNodeByTreeLocation(CCNode* start, std::vector<int> const& loc);
+
+// edits are ordered by tree location, so neighbouring entries share
+// their path prefix. the nodes resolved for the previous location are
+// kept around and only the part of the path that differs is walked,
+// making this a single depth-first pass over the edited part of the
+// scene. it goes one edit per step, so a scene with a huge number of
+// edits can be spread over a few frames. the game runs in between
+// those and may free or reorder nodes, so the cached path is dropped
+// at the start of every slice
+struct scene_edit_applier {
+    CCNode* scene;
+    scene_edit const* edits;
+    std::map<std::vector<int>, node_edit>::const_iterator next;
+    std::vector<CCNode*> path;
+    std::vector<int> const* prev = nullptr;
+    unsigned int visited = 0;
+    unsigned int applied = 0;
+
+    scene_edit_applier(CCNode* scene, scene_edit const& edits);
+    scene_edit_applier(scene_edit_applier const&) = delete;
+    scene_edit_applier& operator=(scene_edit_applier const&) = delete;
+    ~scene_edit_applier();
+
+    bool done() const {
+        return next == edits->nodes.end();
+    }
+
+    // before each batch of steps that run without the game in between
+    void beginSlice() {
+        path.clear();
+        prev = nullptr;
+    }
+
+    void step();
+};
+
+// merge what the tracked nodes changed into the scene's saved edits
+void collectSceneChanges(ChangeTracker& changes, scene_edit& into);
+
+#endif
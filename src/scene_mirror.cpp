@@ -0,0 +1,394 @@
+#include "scene_mirror.hpp"
+#include <algorithm>
+
+SceneMirror g_mirror;
+
+void SceneMirror::childrenChanged(CCNode* parent) {
+    m_generation++;
+
+    // nodes outside the running scene (a scene being built before it's
+    // switched to, detached subtrees) are picked up when they get added
+    if (parent && m_lookup.count(parent))
+        m_stale.push_back(parent);
+}
+
+void SceneMirror::removing(CCNode* parent, CCNode* child) {
+    auto p = this->indexOf(parent);
+    if (p == npos)
+        return;
+
+    if (!child) {
+        for (auto j = p + 1; j < m_nodes[p].end; j = m_nodes[j].end)
+            this->detach(j);
+    } else {
+        // removeChild does nothing for a node that isn't a child
+        auto c = this->indexOf(child);
+        if (c != npos && m_nodes[c].parent == p)
+            this->detach(c);
+    }
+
+    this->childrenChanged(parent);
+}
+
+void SceneMirror::cleanedUp(CCNode* node) {
+    if (node == m_root) {
+        m_root = nullptr;
+        m_generation++;
+        this->rebuild();
+        return;
+    }
+
+    // removeAllChildrenWithCleanup goes straight to its children. if
+    // the node does stay where it is, its parent's collect finds it again
+    auto i = this->indexOf(node);
+    if (i != npos) {
+        auto parent = m_nodes[i].parent;
+        this->detach(i);
+        if (parent != npos)
+            this->childrenChanged(m_nodes[parent].node);
+    }
+}
+
+// the subtree leaves the lookup and its entries lose their node. they
+// stay in place until the parent's children are collected again
+void SceneMirror::detach(uint32_t i) {
+    for (auto j = i; j < m_nodes[i].end; j++) {
+        auto& e = m_nodes[j];
+        if (!e.node)
+            continue;
+        this->forget(e);
+        e.node = nullptr;
+    }
+}
+
+uint32_t SceneMirror::indexOf(CCNode* node) const {
+    auto it = m_lookup.find(node);
+    return it != m_lookup.end() ? m_positions[it->second] : npos;
+}
+
+// a slot for a newly collected node, its position is filled in once
+// the entry has its final place
+uint32_t SceneMirror::assign(CCNode* node) {
+    uint32_t slot;
+    if (m_freeSlots.empty()) {
+        slot = static_cast<uint32_t>(m_positions.size());
+        m_positions.push_back(npos);
+    } else {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    m_lookup[node] = slot;
+    return slot;
+}
+
+void SceneMirror::forget(mirror_node& e) {
+    // the node may have been collected again elsewhere already
+    auto it = m_lookup.find(e.node);
+    if (it != m_lookup.end() && it->second == e.slot)
+        m_lookup.erase(it);
+    m_freeSlots.push_back(e.slot);
+    this->log(true, e.node);
+}
+
+void SceneMirror::log(bool removed, CCNode* node) {
+    for (auto& log : m_logs)
+        if (!log.reset)
+            (removed ? log.removed : log.added).push_back(node);
+}
+
+void SceneMirror::resetLog(mirror_changes& log) {
+    log.reset = true;
+    log.removed.clear();
+    log.added.clear();
+    log.parents.clear();
+}
+
+void SceneMirror::sync(CCNode* root) {
+    if (root != m_root) {
+        m_root = root;
+        m_generation++;
+        this->rebuild();
+        return;
+    }
+
+    this->update();
+}
+
+uint32_t SceneMirror::remap(uint32_t old) const {
+    // ranges are disjoint and sorted, so are their ends. everything at
+    // or past a range's old end moves by what the ranges up to it grew
+    auto after = std::upper_bound(
+        m_ranges.begin(), m_ranges.end(), old,
+        [](uint32_t v, stale_range const& r) { return v < r.end; }
+    ) - m_ranges.begin();
+    return after ? static_cast<uint32_t>(old + m_shifts[after - 1]) : old;
+}
+
+void SceneMirror::update() {
+    if (m_stale.empty())
+        return;
+
+    // ancestors first. anything inside a range that's being collected
+    // again comes along with it. stale nodes that were since removed
+    // aren't in the lookup anymore, so nothing here touches freed ones
+    m_staleRoots.clear();
+    for (auto node : m_stale) {
+        auto i = this->indexOf(node);
+        if (i != npos)
+            m_staleRoots.push_back(i);
+    }
+    m_stale.clear();
+
+    std::sort(m_staleRoots.begin(), m_staleRoots.end());
+    m_staleRoots.erase(std::unique(m_staleRoots.begin(), m_staleRoots.end()), m_staleRoots.end());
+
+    m_ranges.clear();
+    uint32_t covered = 0;
+    for (auto i : m_staleRoots) {
+        if (i < covered)
+            continue;
+        m_ranges.push_back({ i, i + 1, m_nodes[i].end, 0, 0 });
+        covered = m_nodes[i].end;
+    }
+
+    if (m_ranges.empty())
+        return;
+
+    // every range's new children go into m_scratch back to back,
+    // already numbered for where they'll end up
+    m_scratch.clear();
+    m_shifts.clear();
+    int64_t shift = 0;
+    auto resized = false;
+    for (auto& r : m_ranges) {
+        r.begin = static_cast<uint32_t>(m_scratch.size());
+        auto base = static_cast<uint32_t>(r.first + shift) - r.begin;
+        this->restamp(m_nodes[r.root]);
+        this->recollect(r.root, static_cast<uint32_t>(r.root + shift), base);
+        r.count = static_cast<uint32_t>(m_scratch.size()) - r.begin;
+
+        // whatever recollect didn't take over is gone
+        for (auto j = r.first; j < r.end; j++)
+            if (m_nodes[j].node)
+                this->forget(m_nodes[j]);
+
+        resized |= r.count != r.end - r.first;
+        shift += static_cast<int64_t>(r.count) - (r.end - r.first);
+        m_shifts.push_back(shift);
+    }
+
+    if (!resized) {
+        // same sizes (reorders mostly), everything else stays put
+        for (auto const& r : m_ranges) {
+            std::copy(m_scratch.begin() + r.begin, m_scratch.begin() + r.begin + r.count, m_nodes.begin() + r.first);
+            for (auto j = r.first; j < r.end; j++)
+                m_positions[m_nodes[j].slot] = j;
+        }
+    } else {
+        // before the first range only its ancestors' ends change. from
+        // there on the array is laid out again once, however many
+        // parents changed
+        auto from = m_ranges.front().first;
+        for (auto j = m_ranges.front().root; j != npos; j = m_nodes[j].parent)
+            m_nodes[j].end = this->remap(m_nodes[j].end);
+
+        m_tail.clear();
+        auto next = m_ranges.begin();
+        // a range can end right at the end of the array
+        for (auto j = from; j < m_nodes.size() || next != m_ranges.end();) {
+            if (next != m_ranges.end() && j == next->first) {
+                m_tail.insert(m_tail.end(), m_scratch.begin() + next->begin, m_scratch.begin() + next->begin + next->count);
+                j = next->end;
+                next++;
+                continue;
+            }
+
+            auto e = m_nodes[j++];
+            if (e.parent != npos)
+                e.parent = this->remap(e.parent);
+            e.end = this->remap(e.end);
+            m_tail.push_back(e);
+        }
+
+        m_nodes.resize(from);
+        m_nodes.insert(m_nodes.end(), m_tail.begin(), m_tail.end());
+        for (auto j = from; j < m_nodes.size(); j++)
+            if (m_nodes[j].node)
+                m_positions[m_nodes[j].slot] = j;
+    }
+
+    // nobody's catching up with these, starting over is cheaper
+    for (auto& log : m_logs)
+        if (!log.reset && log.removed.size() + log.added.size() > 2 * m_nodes.size() + 1024)
+            this->resetLog(log);
+}
+
+// a node whose children are collected again
+void SceneMirror::restamp(mirror_node& e) {
+    e.generation = m_generation;
+    for (auto& log : m_logs)
+        if (!log.reset)
+            log.parents.push_back(e.node);
+}
+
+// appends the children of the node at `old` to m_scratch, where the
+// node itself now sits at `self`. children that were already mirrored
+// under it keep their entries: subtrees with nothing stale inside are
+// moved over whole, only what's new is collected from cocos. entries
+// taken over lose their node in m_nodes, so what's left there after
+// is what was removed
+void SceneMirror::recollect(uint32_t old, uint32_t self, uint32_t base) {
+    auto node = m_nodes[old].node;
+    auto depth = m_nodes[old].depth;
+
+    auto children = node->getChildren();
+    if (!children)
+        return;
+
+    for (uint32_t k = 0; k < children->count(); k++) {
+        auto child = reinterpret_cast<CCNode*>(children->objectAtIndex(k));
+        auto at = static_cast<uint32_t>(m_scratch.size());
+
+        auto q = this->indexOf(child);
+        if (q == npos || m_nodes[q].node != child || m_nodes[q].parent != old) {
+            this->collect(child, self, k, depth + 1, base, m_scratch);
+            for (auto j = at; j < m_scratch.size(); j++)
+                this->log(false, m_scratch[j].node);
+            continue;
+        }
+
+        auto end = m_nodes[q].end;
+        auto stale = std::lower_bound(m_staleRoots.begin(), m_staleRoots.end(), q);
+        if (stale != m_staleRoots.end() && *stale < end) {
+            auto e = m_nodes[q];
+            e.parent = self;
+            e.index = k;
+            if (*stale == q)
+                this->restamp(e);
+            m_scratch.push_back(e);
+            this->recollect(q, base + at, base);
+            m_scratch[at].end = base + static_cast<uint32_t>(m_scratch.size());
+            m_nodes[q].node = nullptr;
+            continue;
+        }
+
+        auto offset = static_cast<int64_t>(base + at) - q;
+        for (auto j = q; j < end; j++) {
+            auto e = m_nodes[j];
+            e.parent = j == q ? self : static_cast<uint32_t>(e.parent + offset);
+            e.end = static_cast<uint32_t>(e.end + offset);
+            m_scratch.push_back(e);
+            m_nodes[j].node = nullptr;
+        }
+        m_scratch[at].index = k;
+    }
+}
+
+void SceneMirror::rebuild() {
+    m_nodes.clear();
+    m_lookup.clear();
+    m_positions.clear();
+    m_freeSlots.clear();
+    m_stale.clear();
+
+    for (auto& log : m_logs)
+        this->resetLog(log);
+
+    if (!m_root)
+        return;
+
+    this->collect(m_root, npos, 0, 0, 0, m_nodes);
+
+    for (uint32_t i = 0; i < m_nodes.size(); i++)
+        m_positions[m_nodes[i].slot] = i;
+}
+
+void SceneMirror::collect(CCNode* node, uint32_t parent, uint32_t index, uint32_t depth, uint32_t base, std::vector<mirror_node>& out) {
+    auto self = static_cast<uint32_t>(out.size());
+    out.push_back({ node, parent, 0, index, depth, m_generation, &getNodeType(node), this->assign(node) });
+
+    auto children = node->getChildren();
+    if (children) {
+        for (uint32_t i = 0; i < children->count(); i++) {
+            auto child = reinterpret_cast<CCNode*>(children->objectAtIndex(i));
+            this->collect(child, base + self, i, depth + 1, base, out);
+        }
+    }
+
+    out[self].end = base + static_cast<uint32_t>(out.size());
+}
+
+uint32_t SceneMirror::find(CCNode* node) {
+    this->update();
+    return this->indexOf(node);
+}
+
+bool SceneMirror::locationOf(CCNode* node, std::vector<int>& out) {
+    // batch nodes sort their own children without going through any of
+    // the hooks, so every step is checked against the real array. a
+    // mismatch marks that parent stale and the walk is done once more
+    for (int attempt = 0; attempt < 2; attempt++) {
+        auto i = this->find(node);
+        if (i == npos)
+            return false;
+
+        out.clear();
+
+        auto valid = true;
+        for (auto j = i; m_nodes[j].parent != npos; j = m_nodes[j].parent) {
+            auto& e = m_nodes[j];
+            auto children = m_nodes[e.parent].node->getChildren();
+
+            if (!children || e.index >= children->count() || children->objectAtIndex(e.index) != e.node) {
+                this->childrenChanged(m_nodes[e.parent].node);
+                valid = false;
+                break;
+            }
+
+            out.push_back(e.index);
+        }
+
+        if (valid) {
+            out.push_back(0);
+            std::reverse(out.begin(), out.end());
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool SceneMirror::isAncestor(CCNode* ancestor, CCNode* node) {
+    auto a = this->find(ancestor);
+    auto n = this->find(node);
+    if (a == npos || n == npos)
+        return false;
+
+    return a < n && n < m_nodes[a].end;
+}
+
+uint32_t SceneMirror::openLog() {
+    m_logs.push_back({});
+    this->resetLog(m_logs.back());
+    return static_cast<uint32_t>(m_logs.size() - 1);
+}
+
+void SceneMirror::takeChanges(uint32_t log, mirror_changes& out) {
+    this->update();
+
+    auto& changes = m_logs[log];
+    out.reset = changes.reset;
+    std::swap(out.removed, changes.removed);
+    std::swap(out.added, changes.added);
+    std::swap(out.parents, changes.parents);
+
+    changes.reset = false;
+    changes.removed.clear();
+    changes.added.clear();
+    changes.parents.clear();
+}
+
+std::vector<mirror_node> const& SceneMirror::nodes() {
+    this->update();
+    return m_nodes;
+}
@@ -0,0 +1,113 @@
+#ifndef __SCENE_MIRROR_HPP__
+#define __SCENE_MIRROR_HPP__
+
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include <cocos2d.h>
+#include "node_types.hpp"
+
+using namespace cocos2d;
+
+struct mirror_node {
+    CCNode* node;
+    uint32_t parent;            // entry index, npos for the root
+    uint32_t end;               // one past the last entry of the subtree
+    uint32_t index;             // position in the parent's children array
+    uint32_t depth;
+    uint32_t generation;        // when this node's children were last collected
+    node_type const* type;
+    uint32_t slot;              // where the lookup keeps its index
+};
+
+// what changed in the mirror since an index built on top of it last
+// looked. with `reset` set the index has to start over from nodes()
+struct mirror_changes {
+    bool reset;
+    std::vector<CCNode*> removed;
+    std::vector<CCNode*> added;
+    std::vector<CCNode*> parents;   // whose children changed
+};
+
+// the running scene laid out depth first in one array, so a node's
+// subtree is the range [i, end) and its path is a walk up the parent
+// indices. the addChild/removeChild/reorderChild/cleanup hooks only
+// note which parents changed; their child ranges get collected again
+// and spliced in the next time the mirror is asked something. nodes
+// on their way out are dropped from the lookup right away, before the
+// game gets to free them, so nothing stale is ever dereferenced
+class SceneMirror {
+    public:
+        static constexpr uint32_t npos = static_cast<uint32_t>(-1);
+
+        // called from the hooks. removing() goes before the child is
+        // taken out (nullptr for all of them), the others after
+        void childrenChanged(CCNode* parent);
+        void removing(CCNode* parent, CCNode* child);
+        void cleanedUp(CCNode* node);
+
+        // follow the running scene, rebuilt from scratch when it changes
+        void sync(CCNode* root);
+
+        uint32_t find(CCNode* node);
+        // same as getNodeLocationInTree, false if the node isn't mirrored
+        bool locationOf(CCNode* node, std::vector<int>& out);
+        bool isAncestor(CCNode* ancestor, CCNode* node);
+
+        std::vector<mirror_node> const& nodes();
+        // bumped on every structural change the hooks see
+        uint32_t generation() const { return m_generation; }
+
+        // every index following the mirror reads its own log, which
+        // starts out reset. a node that moved shows up as both removed
+        // and added. removed nodes may have been freed since, they're
+        // only good as keys
+        uint32_t openLog();
+        void takeChanges(uint32_t log, mirror_changes& out);
+
+    protected:
+        // a parent whose children get collected again. `first` and
+        // `end` are its old child range, `begin` where its new one
+        // starts in m_scratch
+        struct stale_range {
+            uint32_t root;
+            uint32_t first;
+            uint32_t end;
+            uint32_t begin;
+            uint32_t count;
+        };
+
+        void update();
+        void rebuild();
+        void recollect(uint32_t old, uint32_t self, uint32_t base);
+        void restamp(mirror_node& e);
+        void detach(uint32_t i);
+        uint32_t indexOf(CCNode* node) const;
+        uint32_t assign(CCNode* node);
+        void forget(mirror_node& e);
+        void log(bool removed, CCNode* node);
+        void resetLog(mirror_changes& log);
+        uint32_t remap(uint32_t old) const;
+        void collect(CCNode* node, uint32_t parent, uint32_t index, uint32_t depth, uint32_t base, std::vector<mirror_node>& out);
+
+        CCNode* m_root = nullptr;
+        std::vector<mirror_node> m_nodes;
+        // node to slot to index. moving entries around only has to
+        // rewrite the flat slot array, never the hash map
+        std::unordered_map<CCNode*, uint32_t> m_lookup;
+        std::vector<uint32_t> m_positions;
+        std::vector<uint32_t> m_freeSlots;
+        std::vector<CCNode*> m_stale;
+        std::vector<uint32_t> m_staleRoots;
+        std::vector<stale_range> m_ranges;
+        std::vector<int64_t> m_shifts;
+        std::vector<mirror_node> m_scratch;
+        std::vector<mirror_node> m_tail;
+        uint32_t m_generation = 0;
+
+        std::vector<mirror_changes> m_logs;
+};
+
+extern SceneMirror g_mirror;
+
+#endif
@@ -0,0 +1,67 @@
+#include "scene_snapshot.hpp"
+#include "scene_mirror.hpp"
+#include <chrono>
+#include <cstring>
+
+void captureSnapshot(scene_snapshot& out, uint64_t sequence) {
+    auto start = std::chrono::steady_clock::now();
+
+    auto const& nodes = g_mirror.nodes();
+    auto count = nodes.size();
+
+    out.sequence = sequence;
+    out.generation = g_mirror.generation();
+    out.winSize = CCDirector::sharedDirector()->getWinSize();
+
+    out.node.resize(count);
+    out.type.resize(count);
+    out.parent.resize(count);
+    out.end.resize(count);
+    out.depth.resize(count);
+    out.tag.resize(count);
+    out.zOrder.resize(count);
+    out.visible.resize(count);
+    out.x.resize(count);
+    out.y.resize(count);
+    out.width.resize(count);
+    out.height.resize(count);
+    out.transform.resize(count);
+    out.text.resize(count);
+    out.strings.clear();
+
+    for (size_t i = 0; i < count; i++) {
+        auto const& m = nodes[i];
+        auto node = m.node;
+
+        out.node[i] = node;
+        out.type[i] = m.type;
+        out.parent[i] = m.parent;
+        out.end[i] = m.end;
+        out.depth[i] = m.depth;
+        out.tag[i] = node->getTag();
+        out.zOrder[i] = node->getZOrder();
+        out.visible[i] = node->isVisible();
+
+        auto pos = node->getPosition();
+        auto size = node->getContentSize();
+        out.x[i] = pos.x;
+        out.y[i] = pos.y;
+        out.width[i] = size.width;
+        out.height[i] = size.height;
+        out.transform[i] = node->nodeToParentTransform();
+
+        out.text[i] = scene_snapshot::npos;
+        if (auto label = m.type->asLabel(node)) {
+            auto str = label->getString();
+            if (str) {
+                auto len = std::strlen(str);
+                out.text[i] = static_cast<uint32_t>(out.strings.size());
+                out.strings.insert(out.strings.end(), str, str + len + 1);
+            }
+        }
+    }
+
+    out.captureMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start
+    ).count();
+}
@@ -0,0 +1,50 @@
+#ifndef __SCENE_SNAPSHOT_HPP__
+#define __SCENE_SNAPSHOT_HPP__
+
+#include <vector>
+#include <cstdint>
+#include <cocos2d.h>
+#include "node_types.hpp"
+
+using namespace cocos2d;
+
+// a copy of the running scene that other threads can read. laid out
+// like the mirror it's taken from (depth first, subtree of i is
+// [i, end[i])) with one array per field, so a pass over a field only
+// touches that field. nothing in here is ever dereferenced off the
+// main thread, `node` is only there to find the node again afterwards
+struct scene_snapshot {
+    static constexpr uint32_t npos = static_cast<uint32_t>(-1);
+
+    uint64_t sequence;
+    uint32_t generation;            // structure stamp it was taken at
+    double captureMs;
+    CCSize winSize;
+
+    std::vector<CCNode*> node;
+    std::vector<node_type const*> type;
+    std::vector<uint32_t> parent;
+    std::vector<uint32_t> end;
+    std::vector<uint32_t> depth;
+    std::vector<int> tag;
+    std::vector<int> zOrder;
+    std::vector<uint8_t> visible;
+    std::vector<float> x;           // position in the parent
+    std::vector<float> y;
+    std::vector<float> width;       // content size, `transform` places it
+    std::vector<float> height;
+    std::vector<CCAffineTransform> transform;   // node to parent
+    std::vector<uint32_t> text;     // offset into `strings`, npos if not a label
+    std::vector<char> strings;      // label text, nul terminated
+
+    size_t size() const { return node.size(); }
+    char const* textOf(uint32_t i) const {
+        return text[i] == npos ? nullptr : strings.data() + text[i];
+    }
+};
+
+// copy the running scene in one pass over g_mirror. main thread only;
+// `out` keeps its allocations, so reusing an old snapshot is cheaper
+void captureSnapshot(scene_snapshot& out, uint64_t sequence);
+
+#endif
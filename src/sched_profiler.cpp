@@ -0,0 +1,94 @@
+#include "sched_profiler.hpp"
+#include "node_types.hpp"
+#include <typeinfo>
+#include <algorithm>
+
+SchedProfiler g_schedProfiler;
+
+namespace {
+    // rows of targets that haven't run for this many frames are dropped
+    constexpr uint32_t s_maxIdleFrames = 300;
+}
+
+uint32_t SchedProfiler::row(CCObject* target, void const* what, sched_kind kind, char const* name, float interval) {
+    row_key key { target, what };
+    auto it = m_lookup.find(key);
+    if (it != m_lookup.end())
+        return it->second;
+
+    sched_row res {};
+    res.target = target;
+    res.what = what;
+    res.kind = kind;
+    res.name = name;
+    res.interval = interval;
+    res.node = dynamic_cast<CCNode*>(target);
+    res.targetName = res.node ? getNodeType(res.node).name : className(typeid(*target));
+    res.lastFrame = m_frame;
+
+    auto ix = static_cast<uint32_t>(m_rows.size());
+    m_rows.push_back(res);
+    m_lookup[key] = ix;
+    return ix;
+}
+
+void SchedProfiler::add(uint32_t row, uint64_t ticks) {
+    auto& r = m_rows[row];
+
+    r.history[r.next] = static_cast<uint32_t>(std::min<uint64_t>(ticks, UINT32_MAX));
+    r.next = (r.next + 1) % sched_row::historySize;
+    r.count = std::min(r.count + 1, sched_row::historySize);
+
+    r.calls++;
+    r.ticks += ticks;
+    r.frameTicks += ticks;
+    r.lastFrame = m_frame;
+
+    if (r.kind == skTimer)
+        m_timerTicks += ticks;
+    else
+        m_actionTicks += ticks;
+}
+
+void SchedProfiler::endFrame(uint64_t schedulerTicks) {
+    m_clock.update();
+
+    if (m_clock.ready()) {
+        m_stats.schedulerMs = m_clock.toMs(schedulerTicks);
+        m_stats.timersMs = m_clock.toMs(m_timerTicks);
+        m_stats.actionsMs = m_clock.toMs(m_actionTicks);
+    }
+    m_timerTicks = 0;
+    m_actionTicks = 0;
+    m_actionDepth = 0;
+
+    auto stale = false;
+    for (auto& r : m_rows) {
+        r.lastFrameTicks = r.frameTicks;
+        r.frameTicks = 0;
+        if (m_frame - r.lastFrame > s_maxIdleFrames)
+            stale = true;
+    }
+    m_frame++;
+
+    if (stale) {
+        m_rows.erase(std::remove_if(m_rows.begin(), m_rows.end(), [&](sched_row const& r) {
+            return m_frame - r.lastFrame > s_maxIdleFrames;
+        }), m_rows.end());
+
+        m_lookup.clear();
+        for (uint32_t i = 0; i < m_rows.size(); i++)
+            m_lookup[{ m_rows[i].target, m_rows[i].what }] = i;
+    }
+
+    m_stats.rows = static_cast<unsigned int>(m_rows.size());
+}
+
+void SchedProfiler::reset() {
+    m_rows.clear();
+    m_lookup.clear();
+    m_actionDepth = 0;
+    m_timerTicks = 0;
+    m_actionTicks = 0;
+    m_stats = {};
+}
@@ -0,0 +1,101 @@
+#ifndef __SCHED_PROFILER_HPP__
+#define __SCHED_PROFILER_HPP__
+
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include <cocos2d.h>
+#include "tsc_clock.hpp"
+
+using namespace cocos2d;
+
+enum sched_kind {
+    skTimer,                    // a schedule()d selector
+    skAction,
+};
+
+// one scheduled selector or one kind of action on one target
+struct sched_row {
+    void const* target;
+    void const* what;           // the CCTimer, or the action's class name
+    CCNode* node;               // nullptr if the target isn't a node
+    sched_kind kind;
+    char const* targetName;
+    char const* name;
+    float interval;             // timers only
+
+    static constexpr unsigned int historySize = 128;
+    uint32_t history[historySize];  // ticks per call, a ring
+    unsigned int next;
+    unsigned int count;
+
+    unsigned long long calls;
+    uint64_t ticks;             // since the profiler was switched on
+    uint64_t frameTicks;        // the frame in progress
+    uint64_t lastFrameTicks;
+    uint32_t lastFrame;
+};
+
+struct sched_stats {
+    float schedulerMs;          // all of CCScheduler::update, last frame
+    float timersMs;
+    float actionsMs;
+    unsigned int rows;
+};
+
+// times scheduled selectors (CCTimer::update) and running actions
+// (CCActionInterval/CCActionInstant::step) per target, from hooks in
+// main.cpp that are only enabled while it's switched on. an action
+// stepping an inner action (CCRepeatForever and the like) is one call,
+// the inner step isn't counted again. rows of targets that haven't run
+// for a while are dropped, so a freed target's address being reused
+// only ever shows up briefly. rows are never dereferenced, the tree
+// view link goes through the mirror first
+class SchedProfiler {
+    public:
+        // row for the call about to happen. row indices stay valid until
+        // the next endFrame()
+        uint32_t row(CCObject* target, void const* what, sched_kind kind, char const* name, float interval = 0.0f);
+        void add(uint32_t row, uint64_t ticks);
+
+        // actions can step other actions, only the outermost is timed
+        bool enterAction() { return m_actionDepth++ == 0; }
+        void leaveAction() { m_actionDepth--; }
+
+        // after every CCScheduler::update, with how long it took
+        void endFrame(uint64_t schedulerTicks);
+        void reset();
+
+        std::vector<sched_row> const& rows() const { return m_rows; }
+        sched_stats const& stats() const { return m_stats; }
+        tsc_clock const& clock() const { return m_clock; }
+
+    protected:
+        struct row_key {
+            void const* target;
+            void const* what;
+
+            bool operator==(row_key const& other) const {
+                return target == other.target && what == other.what;
+            }
+        };
+
+        struct row_key_hash {
+            size_t operator()(row_key const& key) const {
+                return std::hash<void const*>()(key.target) ^ (std::hash<void const*>()(key.what) * 31);
+            }
+        };
+
+        std::vector<sched_row> m_rows;
+        std::unordered_map<row_key, uint32_t, row_key_hash> m_lookup;
+        uint32_t m_frame = 0;
+        int m_actionDepth = 0;
+        uint64_t m_timerTicks = 0;
+        uint64_t m_actionTicks = 0;
+        sched_stats m_stats {};
+        tsc_clock m_clock;
+};
+
+extern SchedProfiler g_schedProfiler;
+
+#endif
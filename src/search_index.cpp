@@ -0,0 +1,451 @@
+#include "search_index.hpp"
+#include <chrono>
+#include <cctype>
+#include <cstdlib>
+#include <algorithm>
+
+namespace {
+    std::string lowercase(std::string str) {
+        for (auto& c : str)
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        return str;
+    }
+
+    // lowercase runs of letters and digits
+    template <class F>
+    void forEachWord(std::string const& text, F&& fn) {
+        std::string word;
+        for (auto c : text) {
+            if (std::isalnum(static_cast<unsigned char>(c))) {
+                word += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+            } else if (!word.empty()) {
+                fn(word);
+                word.clear();
+            }
+        }
+        if (!word.empty())
+            fn(word);
+    }
+
+    std::string labelText(CCNode* node, node_type const* type) {
+        auto label = type->asLabel(node);
+        if (!label)
+            return std::string();
+
+        auto str = label->getString();
+        return str ? std::string(str) : std::string();
+    }
+
+    bool compare(float a, search_op op, float b) {
+        switch (op) {
+            case soLess:            return a < b;
+            case soLessEqual:       return a <= b;
+            case soGreater:         return a > b;
+            case soGreaterEqual:    return a >= b;
+            case soEqual:           return a == b;
+            case soNotEqual:        return a != b;
+        }
+        return false;
+    }
+
+    struct field_name {
+        char const* name;
+        search_field field;
+    };
+
+    constexpr field_name s_fields[] = {
+        { "opacity",    sfOpacity },
+        { "visible",    sfVisible },
+        { "x",          sfX },
+        { "y",          sfY },
+        { "z",          sfZ },
+        { "scale",      sfScale },
+        { "rotation",   sfRotation },
+        { "width",      sfWidth },
+        { "height",     sfHeight },
+        { "children",   sfChildren },
+        { "tag",        sfTag },
+    };
+}
+
+bool parsePredicate(std::string const& text, search_predicate& out, std::string& error) {
+    auto low = lowercase(text);
+
+    auto opPos = low.find_first_of("<>=!");
+    if (opPos == std::string::npos || opPos == 0) {
+        error = "no property in '" + low + "'";
+        return false;
+    }
+
+    auto name = low.substr(0, opPos);
+    auto rest = low.substr(opPos);
+
+    size_t opLen = 2;
+    if (!rest.compare(0, 2, "<="))      out.op = soLessEqual;
+    else if (!rest.compare(0, 2, ">=")) out.op = soGreaterEqual;
+    else if (!rest.compare(0, 2, "!=")) out.op = soNotEqual;
+    else if (!rest.compare(0, 2, "==")) out.op = soEqual;
+    else {
+        opLen = 1;
+        switch (rest[0]) {
+            case '<': out.op = soLess; break;
+            case '>': out.op = soGreater; break;
+            case '=': out.op = soEqual; break;
+            default:
+                error = "bad operator in '" + low + "'";
+                return false;
+        }
+    }
+
+    auto valueText = rest.substr(opLen);
+    char* end;
+    out.value = std::strtof(valueText.c_str(), &end);
+    if (valueText.empty() || *end) {
+        error = "bad value in '" + low + "'";
+        return false;
+    }
+
+    auto field = std::find_if(std::begin(s_fields), std::end(s_fields), [&](field_name const& f) {
+        return name == f.name;
+    });
+    if (field == std::end(s_fields)) {
+        error = "unknown property '" + name + "'";
+        return false;
+    }
+
+    out.field = field->field;
+    return true;
+}
+
+bool testPredicate(CCNode* node, node_type const* type, search_predicate const& p) {
+    float value;
+    switch (p.field) {
+        case sfOpacity: {
+            auto rgba = type->asRGBA(node);
+            if (!rgba)
+                return false;
+            value = rgba->getOpacity();
+        } break;
+
+        case sfVisible:     value = node->isVisible() ? 1.0f : 0.0f; break;
+        case sfX:           value = node->getPositionX(); break;
+        case sfY:           value = node->getPositionY(); break;
+        case sfZ:           value = static_cast<float>(node->getZOrder()); break;
+        case sfScale:       value = node->getScale(); break;
+        case sfRotation:    value = node->getRotation(); break;
+        case sfWidth:       value = node->getContentSize().width; break;
+        case sfHeight:      value = node->getContentSize().height; break;
+        case sfChildren:    value = static_cast<float>(node->getChildrenCount()); break;
+        case sfTag:         value = static_cast<float>(node->getTag()); break;
+        default:            return false;
+    }
+
+    return compare(value, p.op, p.value);
+}
+
+void SearchIndex::reset() {
+    m_entries.clear();
+    m_lookup.clear();
+    m_classes.clear();
+    m_tags.clear();
+    m_words.clear();
+    m_dead = 0;
+    m_validateCursor = 0;
+
+    for (auto const& m : g_mirror.nodes())
+        this->add(m.node, m.type);
+}
+
+void SearchIndex::index(uint32_t slot) {
+    auto const& e = m_entries[slot];
+
+    m_classes[e.type].push_back(slot);
+    m_tags[e.tag].push_back(slot);
+    m_classNames.emplace(lowercase(e.type->shortName()), e.type);
+
+    // a word that shows up twice in the same label is listed once
+    std::vector<std::string> words;
+    forEachWord(e.text, [&](std::string const& word) {
+        if (std::find(words.begin(), words.end(), word) == words.end())
+            words.push_back(word);
+    });
+    for (auto& word : words)
+        m_words[word].push_back(slot);
+}
+
+void SearchIndex::add(CCNode* node, node_type const* type) {
+    if (m_lookup.count(node))
+        return;
+
+    auto slot = static_cast<uint32_t>(m_entries.size());
+    m_entries.push_back({ node, type, node->getTag(), labelText(node, type), true });
+    m_lookup[node] = slot;
+    m_version++;
+
+    this->index(slot);
+}
+
+void SearchIndex::remove(CCNode* node) {
+    auto it = m_lookup.find(node);
+    if (it == m_lookup.end())
+        return;
+
+    m_entries[it->second].alive = false;
+    m_lookup.erase(it);
+    m_dead++;
+    m_version++;
+}
+
+void SearchIndex::compact() {
+    std::vector<entry> alive;
+    alive.reserve(m_entries.size() - m_dead);
+    for (auto& e : m_entries)
+        if (e.alive)
+            alive.push_back(std::move(e));
+
+    m_entries = std::move(alive);
+    m_lookup.clear();
+    m_classes.clear();
+    m_tags.clear();
+    m_words.clear();
+    m_dead = 0;
+    m_validateCursor = 0;
+
+    for (uint32_t i = 0; i < m_entries.size(); i++) {
+        m_lookup[m_entries[i].node] = i;
+        this->index(i);
+    }
+}
+
+void SearchIndex::touch(CCNode* node) {
+    auto it = m_lookup.find(node);
+    if (it == m_lookup.end())
+        return;
+
+    auto& e = m_entries[it->second];
+    if (e.tag == node->getTag() && e.text == labelText(node, e.type))
+        return;
+
+    auto type = e.type;
+    this->remove(node);
+    this->add(node, type);
+}
+
+void SearchIndex::validateSlice(unsigned int count) {
+    auto size = static_cast<uint32_t>(m_entries.size());
+    count = std::min<uint32_t>(count, size);
+
+    for (unsigned int i = 0; i < count; i++) {
+        if (m_validateCursor >= m_entries.size())
+            m_validateCursor = 0;
+
+        // touch() may append, so no references across it
+        auto ix = m_validateCursor++;
+        if (m_entries[ix].alive)
+            this->touch(m_entries[ix].node);
+    }
+}
+
+void SearchIndex::update() {
+    if (m_log == SceneMirror::npos)
+        m_log = g_mirror.openLog();
+    g_mirror.takeChanges(m_log, m_changes);
+
+    if (m_changes.reset) {
+        this->reset();
+    } else {
+        for (auto node : m_changes.removed)
+            this->remove(node);
+
+        // the log isn't in order, so whatever was added and then removed
+        // again is filtered out by asking the mirror
+        for (auto node : m_changes.added) {
+            auto ix = g_mirror.find(node);
+            if (ix != SceneMirror::npos)
+                this->add(node, g_mirror.nodes()[ix].type);
+        }
+
+        // labels rebuild their letters when their text changes
+        for (auto node : m_changes.parents)
+            this->touch(node);
+    }
+
+    this->validateSlice(512);
+
+    if (m_dead > 1024 && m_dead > m_entries.size() / 2)
+        this->compact();
+}
+
+search_query SearchIndex::parse(std::string const& text) const {
+    search_query res;
+
+    std::string token;
+    auto flush = [&] {
+        if (token.empty())
+            return;
+
+        auto low = lowercase(token);
+        token.clear();
+
+        if (low[0] == '#') {
+            char* end;
+            auto tag = static_cast<int>(std::strtol(low.c_str() + 1, &end, 10));
+            if (*end || low.size() == 1)
+                res.error = "bad tag '" + low + "'";
+            else
+                res.tags.push_back(tag);
+            return;
+        }
+
+        if (low.find_first_of("<>=!", 1) != std::string::npos) {
+            search_predicate p;
+            if (!parsePredicate(low, p, res.error))
+                return;
+
+            // an exact tag goes through the tag lists
+            if (p.field == sfTag && p.op == soEqual)
+                res.tags.push_back(static_cast<int>(p.value));
+            else
+                res.predicates.push_back(p);
+            return;
+        }
+
+        if (low == "visible") {
+            res.predicates.push_back({ sfVisible, soEqual, 1.0f });
+            return;
+        }
+        if (low == "hidden") {
+            res.predicates.push_back({ sfVisible, soEqual, 0.0f });
+            return;
+        }
+
+        auto cls = m_classNames.find(low);
+        if (cls != m_classNames.end()) {
+            res.classes.push_back(cls->second);
+            return;
+        }
+
+        forEachWord(low, [&](std::string const& word) {
+            res.words.push_back(word);
+        });
+    };
+
+    for (auto c : text) {
+        if (std::isspace(static_cast<unsigned char>(c)))
+            flush();
+        else
+            token += c;
+    }
+    flush();
+
+    return res;
+}
+
+std::vector<CCNode*> const& SearchIndex::run(search_query const& query) {
+    auto start = std::chrono::steady_clock::now();
+
+    m_results.clear();
+    m_candidates.clear();
+    m_stats.nodes = static_cast<unsigned int>(m_lookup.size());
+    m_stats.matched = 0;
+
+    // every term is the union of a few posting lists, and the terms
+    // are intersected smallest first
+    using group = std::vector<std::vector<uint32_t> const*>;
+    std::vector<group> groups;
+    auto empty = false;
+
+    if (!query.classes.empty()) {
+        group g;
+        for (auto type : query.classes) {
+            auto it = m_classes.find(type);
+            if (it != m_classes.end())
+                g.push_back(&it->second);
+        }
+        groups.push_back(std::move(g));
+    }
+
+    for (auto tag : query.tags) {
+        group g;
+        auto it = m_tags.find(tag);
+        if (it != m_tags.end())
+            g.push_back(&it->second);
+        groups.push_back(std::move(g));
+    }
+
+    for (auto const& word : query.words) {
+        group g;
+        for (auto it = m_words.lower_bound(word); it != m_words.end() && !it->first.compare(0, word.size(), word); it++)
+            g.push_back(&it->second);
+        groups.push_back(std::move(g));
+    }
+
+    auto sizeOf = [](group const& g) {
+        size_t res = 0;
+        for (auto list : g)
+            res += list->size();
+        return res;
+    };
+
+    for (auto const& g : groups)
+        if (g.empty())
+            empty = true;
+
+    if (!empty) {
+        if (groups.empty()) {
+            for (uint32_t i = 0; i < m_entries.size(); i++)
+                if (m_entries[i].alive)
+                    m_candidates.push_back(i);
+        } else {
+            std::sort(groups.begin(), groups.end(), [&](group const& a, group const& b) {
+                return sizeOf(a) < sizeOf(b);
+            });
+
+            m_mark.resize(m_entries.size());
+
+            m_stamp++;
+            for (auto list : groups[0])
+                for (auto slot : *list)
+                    if (m_mark[slot] != m_stamp) {
+                        m_mark[slot] = m_stamp;
+                        m_candidates.push_back(slot);
+                    }
+
+            for (size_t i = 1; i < groups.size() && !m_candidates.empty(); i++) {
+                m_stamp++;
+                for (auto list : groups[i])
+                    for (auto slot : *list)
+                        m_mark[slot] = m_stamp;
+
+                m_candidates.erase(std::remove_if(m_candidates.begin(), m_candidates.end(), [&](uint32_t slot) {
+                    return m_mark[slot] != m_stamp;
+                }), m_candidates.end());
+            }
+        }
+
+        for (auto slot : m_candidates) {
+            auto const& e = m_entries[slot];
+            if (!e.alive)
+                continue;
+
+            auto ok = true;
+            for (auto const& p : query.predicates) {
+                if (!testPredicate(e.node, e.type, p)) {
+                    ok = false;
+                    break;
+                }
+            }
+            if (!ok)
+                continue;
+
+            if (m_stats.matched++ < maxResults)
+                m_results.push_back(e.node);
+        }
+    }
+
+    m_stats.queryMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start
+    ).count();
+
+    return m_results;
+}
@@ -0,0 +1,131 @@
+#ifndef __SEARCH_INDEX_HPP__
+#define __SEARCH_INDEX_HPP__
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include <cocos2d.h>
+#include "node_types.hpp"
+#include "scene_mirror.hpp"
+
+using namespace cocos2d;
+
+enum search_field {
+    sfOpacity,
+    sfVisible,
+    sfX,
+    sfY,
+    sfZ,
+    sfScale,
+    sfRotation,
+    sfWidth,
+    sfHeight,
+    sfChildren,
+    sfTag,
+};
+
+enum search_op {
+    soLess,
+    soLessEqual,
+    soGreater,
+    soGreaterEqual,
+    soEqual,
+    soNotEqual,
+};
+
+struct search_predicate {
+    search_field field;
+    search_op op;
+    float value;
+};
+
+// "opacity<10", "x>=0" and such, false with `error` set if it isn't one
+bool parsePredicate(std::string const& text, search_predicate& out, std::string& error);
+// reads the property off the live node
+bool testPredicate(CCNode* node, node_type const* type, search_predicate const& p);
+
+// a parsed query. every term has to match, except that several class
+// names mean any of them. bare words that aren't a class name match
+// the start of any word in a label's text
+struct search_query {
+    std::vector<node_type const*> classes;
+    std::vector<int> tags;
+    std::vector<std::string> words;
+    std::vector<search_predicate> predicates;
+    std::string error;
+};
+
+struct search_stats {
+    unsigned int nodes;
+    unsigned int matched;
+    double queryMs;
+};
+
+// inverted index over the mirrored scene: class, tag and label words
+// each map to the entries that have them, so a query only intersects
+// the lists its terms point at and checks properties on what's left.
+// kept up to date from the mirror's change log; removed nodes are only
+// marked dead and the lists are compacted once half of it is garbage.
+// tags and label text change without any hook seeing it, so a slice
+// of entries is checked again every update
+//
+//     CCSprite opacity<10 visible
+//     #5 CCLabelBMFont
+//     play tag=3
+class SearchIndex {
+    public:
+        static constexpr unsigned int maxResults = 500;
+
+        void update();
+        // reindex a node the explorer itself changed
+        void touch(CCNode* node);
+
+        search_query parse(std::string const& text) const;
+        // matches, at most maxResults of them
+        std::vector<CCNode*> const& run(search_query const& query);
+        // what the last run() found
+        std::vector<CCNode*> const& results() const { return m_results; }
+
+        search_stats const& stats() const { return m_stats; }
+        // bumped whenever an entry is added or dropped
+        uint32_t version() const { return m_version; }
+
+    protected:
+        struct entry {
+            CCNode* node;
+            node_type const* type;
+            int tag;
+            std::string text;
+            bool alive;
+        };
+
+        void add(CCNode* node, node_type const* type);
+        void remove(CCNode* node);
+        void reset();
+        void compact();
+        void index(uint32_t slot);
+        void validateSlice(unsigned int count);
+
+        std::vector<entry> m_entries;
+        std::unordered_map<CCNode*, uint32_t> m_lookup;
+        unsigned int m_dead = 0;
+        uint32_t m_validateCursor = 0;
+        uint32_t m_version = 0;
+
+        std::unordered_map<node_type const*, std::vector<uint32_t>> m_classes;
+        std::unordered_map<int, std::vector<uint32_t>> m_tags;
+        std::map<std::string, std::vector<uint32_t>> m_words;
+        std::unordered_map<std::string, node_type const*> m_classNames;    // lowercase
+
+        uint32_t m_log = SceneMirror::npos;
+        mirror_changes m_changes {};
+        std::vector<uint32_t> m_mark;
+        uint32_t m_stamp = 0;
+        std::vector<uint32_t> m_candidates;
+        std::vector<CCNode*> m_results;
+        search_stats m_stats {};
+};
+
+#endif
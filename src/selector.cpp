@@ -0,0 +1,206 @@
+#include "selector.hpp"
+#include <cctype>
+#include <cstdlib>
+
+namespace {
+    std::string lowercase(std::string str) {
+        for (auto& c : str)
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        return str;
+    }
+
+    bool isNameChar(char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == ':';
+    }
+}
+
+bool Selector::compile(std::string const& text) {
+    m_steps.clear();
+    m_classMasks.clear();
+    m_childSteps = 0;
+    m_descendantSteps = 0;
+    m_error.clear();
+
+    auto fail = [&](std::string const& error) {
+        m_steps.clear();
+        m_error = error;
+        return false;
+    };
+
+    auto combinator = scDescendant;
+    auto explicitCombinator = false;
+    auto afterStep = false;
+    size_t i = 0;
+
+    while (i < text.size()) {
+        auto c = text[i];
+
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            afterStep = false;
+            i++;
+            continue;
+        }
+
+        if (!text.compare(i, 2, "**")) {
+            if (explicitCombinator)
+                return fail("two combinators in a row");
+            combinator = scDescendant;
+            explicitCombinator = true;
+            afterStep = false;
+            i += 2;
+            if (i < text.size() && text[i] == '/')
+                i++;
+            continue;
+        }
+
+        if (c == '>' || c == '/') {
+            if (explicitCombinator)
+                return fail("two combinators in a row");
+            combinator = scChild;
+            explicitCombinator = true;
+            afterStep = false;
+            i++;
+            continue;
+        }
+
+        if (c == '[') {
+            if (!afterStep)
+                return fail("[ has to follow a class name or *");
+
+            auto close = text.find(']', i);
+            if (close == std::string::npos)
+                return fail("missing ]");
+
+            auto filter = lowercase(text.substr(i + 1, close - i - 1));
+            auto& step = m_steps.back();
+            i = close + 1;
+
+            if (filter == "visible") {
+                step.filters.push_back({ sfVisible, soEqual, 1.0f });
+            } else if (filter == "hidden") {
+                step.filters.push_back({ sfVisible, soEqual, 0.0f });
+            } else if (!filter.compare(0, 6, "index=")) {
+                char* end;
+                step.index = static_cast<int>(std::strtol(filter.c_str() + 6, &end, 10));
+                if (*end || filter.size() == 6 || step.index < 0)
+                    return fail("bad index in [" + filter + "]");
+            } else {
+                search_predicate p;
+                std::string error;
+                if (!parsePredicate(filter, p, error))
+                    return fail(error);
+                step.filters.push_back(p);
+            }
+            continue;
+        }
+
+        if (c == '*' || isNameChar(c)) {
+            if (m_steps.size() == maxSteps)
+                return fail("too many steps");
+
+            selector_step step;
+            step.combinator = combinator;
+            if (c != '*') {
+                auto end = i;
+                while (end < text.size() && isNameChar(text[end]))
+                    end++;
+                step.name = lowercase(text.substr(i, end - i));
+                i = end;
+            } else {
+                i++;
+            }
+
+            auto bit = uint64_t(1) << m_steps.size();
+            if (combinator == scChild)
+                m_childSteps |= bit;
+            else
+                m_descendantSteps |= bit;
+
+            m_steps.push_back(std::move(step));
+            combinator = scDescendant;
+            explicitCombinator = false;
+            afterStep = true;
+            continue;
+        }
+
+        return fail(std::string("unexpected '") + c + "'");
+    }
+
+    if (explicitCombinator)
+        return fail("nothing after the last combinator");
+
+    return true;
+}
+
+uint64_t Selector::classMask(node_type const* type) {
+    auto it = m_classMasks.find(type);
+    if (it != m_classMasks.end())
+        return it->second;
+
+    auto full = lowercase(type->name);
+    auto name = lowercase(type->shortName());
+
+    uint64_t res = 0;
+    for (size_t i = 0; i < m_steps.size(); i++) {
+        auto const& step = m_steps[i];
+        if (step.name.empty() || step.name == name || step.name == full)
+            res |= uint64_t(1) << i;
+    }
+
+    m_classMasks[type] = res;
+    return res;
+}
+
+bool Selector::filtersMatch(selector_step const& step, mirror_node const& node) const {
+    if (step.index >= 0 && node.index != static_cast<uint32_t>(step.index))
+        return false;
+
+    for (auto const& p : step.filters)
+        if (!testPredicate(node.node, node.type, p))
+            return false;
+
+    return true;
+}
+
+void Selector::match(std::vector<mirror_node> const& nodes, std::vector<CCNode*>& out) {
+    out.clear();
+    if (m_steps.empty())
+        return;
+
+    m_here.resize(nodes.size());
+    m_below.resize(nodes.size());
+    auto last = uint64_t(1) << (m_steps.size() - 1);
+
+    for (size_t i = 0; i < nodes.size(); i++) {
+        auto const& m = nodes[i];
+
+        uint64_t parentHere = 0;
+        uint64_t parentBelow = 0;
+        auto rootChild = false;
+        if (m.parent != SceneMirror::npos) {
+            parentHere = m_here[m.parent];
+            parentBelow = m_below[m.parent];
+            rootChild = nodes[m.parent].parent == SceneMirror::npos;
+        }
+
+        // step 0 is reachable from anywhere unless it's pinned to the
+        // scene's children, any other step needs the one before it
+        auto reachable =
+            (((parentHere << 1) | (rootChild ? 1 : 0)) & m_childSteps) |
+            (((parentBelow << 1) | 1) & m_descendantSteps);
+
+        auto candidates = reachable & this->classMask(m.type);
+        uint64_t bits = 0;
+        for (size_t j = 0; candidates && j < m_steps.size(); j++) {
+            auto bit = uint64_t(1) << j;
+            if ((candidates & bit) && this->filtersMatch(m_steps[j], m))
+                bits |= bit;
+        }
+
+        m_here[i] = bits;
+        m_below[i] = bits | parentBelow;
+
+        if (bits & last)
+            out.push_back(m.node);
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef __SELECTOR_HPP__
+#define __SELECTOR_HPP__
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include <cocos2d.h>
+#include "node_types.hpp"
+#include "scene_mirror.hpp"
+#include "search_index.hpp"
+
+using namespace cocos2d;
+
+enum selector_combinator {
+    scDescendant,               // "a b", "a **/b"
+    scChild,                    // "a > b", "a/b"
+};
+
+struct selector_step {
+    selector_combinator combinator;
+    std::string name;           // lowercase class name, empty for *
+    std::vector<search_predicate> filters;
+    int index = -1;             // [index=N], position among the siblings
+};
+
+// a selector over class names and tree structure, matched in a single
+// pass over the mirror:
+//
+//     MenuLayer > CCMenu > *
+//     **/CCLabelBMFont[tag=5]
+//     /MenuLayer CCSprite[opacity<128][visible]
+//
+// a leading / or > pins the first step to the scene's children,
+// otherwise it may match anywhere. the mirror is laid out depth first,
+// so a node's parent always comes before it and each node only needs
+// the steps its parent matched and the steps any ancestor matched, one
+// bit per step
+class Selector {
+    public:
+        static constexpr size_t maxSteps = 64;
+
+        bool compile(std::string const& text);
+        bool empty() const { return m_steps.empty(); }
+        std::string const& error() const { return m_error; }
+
+        void match(std::vector<mirror_node> const& nodes, std::vector<CCNode*>& out);
+
+    protected:
+        uint64_t classMask(node_type const* type);
+        bool filtersMatch(selector_step const& step, mirror_node const& node) const;
+
+        std::vector<selector_step> m_steps;
+        uint64_t m_childSteps = 0;
+        uint64_t m_descendantSteps = 0;
+        std::string m_error;
+
+        // steps whose class fits, per node class
+        std::unordered_map<node_type const*, uint64_t> m_classMasks;
+        std::vector<uint64_t> m_here;
+        std::vector<uint64_t> m_below;
+};
+
+#endif
@@ -0,0 +1,523 @@
+#include "snapping.hpp"
+#include <algorithm>
+#include <cmath>
+#include <climits>
+
+static constexpr float s_lineEpsilon = 0.5f;
+
+static bool lineLess(snap_line const& a, snap_line const& b) {
+    return a.value < b.value;
+}
+
+AlignmentIndex::~AlignmentIndex() {
+    this->clear();
+}
+
+void AlignmentIndex::clear() {
+    m_lines[saX].clear();
+    m_lines[saY].clear();
+
+    for (auto node : m_nodes)
+        node->release();
+    m_nodes.clear();
+}
+
+void AlignmentIndex::build(
+    SpatialIndex const& index, CCNode* dragged,
+    CCSize const& winSize, bool windowCenter
+) {
+    this->clear();
+
+    auto const& entries = index.entries();
+
+    // skip the dragged node and everything it carries along
+    auto excludeBegin = index.entryOf(dragged);
+    auto excludeEnd = excludeBegin;
+    if (excludeBegin != SpatialIndex::npos)
+        excludeEnd = entries[excludeBegin].end;
+
+    auto screen = CCRect { 0.0f, 0.0f, winSize.width, winSize.height };
+
+    m_lines[saX].reserve(entries.size() * 3 + 1);
+    m_lines[saY].reserve(entries.size() * 3 + 1);
+
+    for (unsigned int i = 0; i < entries.size(); i++) {
+        if (i == excludeBegin) {
+            i = excludeEnd - 1;
+            continue;
+        }
+
+        auto const& entry = entries[i];
+
+        if (entry.container || !entry.visible)
+            continue;
+        if (!entry.rect.intersectsRect(screen))
+            continue;
+
+        entry.node->retain();
+        m_nodes.push_back(entry.node);
+
+        auto const& rect = entry.rect;
+        m_lines[saX].push_back({ rect.getMinX(), entry.node });
+        m_lines[saX].push_back({ rect.getMidX(), entry.node });
+        m_lines[saX].push_back({ rect.getMaxX(), entry.node });
+        m_lines[saY].push_back({ rect.getMinY(), entry.node });
+        m_lines[saY].push_back({ rect.getMidY(), entry.node });
+        m_lines[saY].push_back({ rect.getMaxY(), entry.node });
+    }
+
+    if (windowCenter) {
+        m_lines[saX].push_back({ winSize.width / 2, nullptr });
+        m_lines[saY].push_back({ winSize.height / 2, nullptr });
+    }
+
+    std::sort(m_lines[saX].begin(), m_lines[saX].end(), lineLess);
+    std::sort(m_lines[saY].begin(), m_lines[saY].end(), lineLess);
+}
+
+bool AlignmentIndex::closest(
+    snap_axis axis, float const* values, unsigned int count,
+    float threshold, bool nodes, snap_match& out
+) const {
+    auto const& lines = m_lines[axis];
+    auto best = threshold;
+    bool found = false;
+
+    for (unsigned int i = 0; i < count; i++) {
+        auto value = values[i];
+
+        auto it = std::lower_bound(
+            lines.begin(), lines.end(), snap_line { value - best, nullptr }, lineLess
+        );
+        for (; it != lines.end() && it->value <= value + best; it++) {
+            if (!nodes && it->node)
+                continue;
+
+            auto delta = it->value - value;
+            // prefer the window center on ties, same as before
+            if (fabsf(delta) < best || (found && !out.window && !it->node && fabsf(delta) <= best)) {
+                best = fabsf(delta);
+                out = { delta, it->value, it->node == nullptr };
+                found = true;
+            }
+        }
+    }
+
+    return found;
+}
+
+AlignmentIndex::line_range AlignmentIndex::linesAt(snap_axis axis, float value) const {
+    auto const& lines = m_lines[axis];
+
+    return {
+        std::lower_bound(lines.begin(), lines.end(), snap_line { value - s_lineEpsilon, nullptr }, lineLess),
+        std::upper_bound(lines.begin(), lines.end(), snap_line { value + s_lineEpsilon, nullptr }, lineLess),
+    };
+}
+
+static constexpr unsigned int s_maxCellsPerRect = 64;
+
+static float rectGap(CCRect const& a, CCRect const& b) {
+    auto dx = std::max(0.0f, std::max(a.getMinX() - b.getMaxX(), b.getMinX() - a.getMaxX()));
+    auto dy = std::max(0.0f, std::max(a.getMinY() - b.getMaxY(), b.getMinY() - a.getMaxY()));
+    return sqrtf(dx * dx + dy * dy);
+}
+
+void SiblingHash::clear() {
+    m_rects.clear();
+    m_cellItems.clear();
+    m_cells.clear();
+    m_oversized.clear();
+    m_stamps.clear();
+    m_minCellX = m_minCellY = 0;
+    m_maxCellX = m_maxCellY = -1;
+}
+
+long long SiblingHash::cellKey(int x, int y) const {
+    return (static_cast<long long>(x) << 32) ^ static_cast<unsigned int>(y);
+}
+
+int SiblingHash::cellOf(float v) const {
+    return static_cast<int>(floorf(v / m_cellSize));
+}
+
+void SiblingHash::build(CCNode* dragged) {
+    this->clear();
+
+    auto parent = dragged->getParent();
+    if (!parent) return;
+
+    float extent = 0.0f;
+
+    CCObject* obj;
+    CCARRAY_FOREACH(parent->getChildren(), obj) {
+        auto node = reinterpret_cast<CCNode*>(obj);
+
+        if (!node || node == dragged) continue;
+
+        auto pos = node->getPosition();
+        auto size = node->getScaledContentSize();
+        auto rect = CCRect { pos.x, pos.y, size.width, size.height };
+
+        rect.origin = rect.origin - rect.size / 2;
+
+        m_rects.push_back({ rect, node });
+        extent += fabsf(size.width) + fabsf(size.height);
+    }
+
+    if (m_rects.empty())
+        return;
+
+    // cells about the size of an average sibling
+    m_cellSize = std::max(4.0f, extent / (m_rects.size() * 2));
+    m_stamps.resize(m_rects.size(), 0);
+
+    std::vector<std::pair<long long, unsigned int>> bucketed;
+    bucketed.reserve(m_rects.size());
+
+    m_minCellX = m_minCellY = INT_MAX;
+    m_maxCellX = m_maxCellY = INT_MIN;
+
+    for (unsigned int i = 0; i < m_rects.size(); i++) {
+        auto const& rect = m_rects[i].rect;
+        auto x0 = this->cellOf(std::min(rect.getMinX(), rect.getMaxX()));
+        auto x1 = this->cellOf(std::max(rect.getMinX(), rect.getMaxX()));
+        auto y0 = this->cellOf(std::min(rect.getMinY(), rect.getMaxY()));
+        auto y1 = this->cellOf(std::max(rect.getMinY(), rect.getMaxY()));
+
+        m_minCellX = std::min(m_minCellX, x0);
+        m_maxCellX = std::max(m_maxCellX, x1);
+        m_minCellY = std::min(m_minCellY, y0);
+        m_maxCellY = std::max(m_maxCellY, y1);
+
+        if (static_cast<long long>(x1 - x0 + 1) * (y1 - y0 + 1) > s_maxCellsPerRect) {
+            m_oversized.push_back(i);
+            continue;
+        }
+
+        for (auto x = x0; x <= x1; x++)
+            for (auto y = y0; y <= y1; y++)
+                bucketed.push_back({ this->cellKey(x, y), i });
+    }
+
+    std::sort(bucketed.begin(), bucketed.end());
+
+    m_cellItems.reserve(bucketed.size());
+    for (unsigned int i = 0; i < bucketed.size(); i++) {
+        if (!i || bucketed[i].first != bucketed[i - 1].first)
+            m_cells[bucketed[i].first] = { i, 0 };
+        m_cells[bucketed[i].first].second++;
+        m_cellItems.push_back(bucketed[i].second);
+    }
+}
+
+unsigned int SiblingHash::nearest(CCRect const& rect, unsigned int k, sibling_rect const** out) const {
+    if (m_rects.empty() || !k)
+        return 0;
+
+    k = std::min(k, maxNearest);
+
+    // a k-best list per side, so a crowded side can't push the
+    // neighbours on the other ones out
+    sibling_rect const* best[sideCount][maxNearest];
+    float dists[sideCount][maxNearest];
+    unsigned int found[sideCount] = {};
+
+    if (!++m_stamp) {
+        std::fill(m_stamps.begin(), m_stamps.end(), 0);
+        m_stamp = 1;
+    }
+
+    auto consider = [&](unsigned int item) {
+        if (m_stamps[item] == m_stamp)
+            return;
+        m_stamps[item] = m_stamp;
+
+        auto const& other = m_rects[item].rect;
+        auto dx = other.getMidX() - rect.getMidX();
+        auto dy = other.getMidY() - rect.getMidY();
+        auto side = fabsf(dx) >= fabsf(dy) ?
+            (dx < 0.0f ? ssLeft : ssRight) :
+            (dy < 0.0f ? ssBelow : ssAbove);
+
+        auto dist = rectGap(rect, other);
+        auto& n = found[side];
+        if (n == k && dist >= dists[side][k - 1])
+            return;
+
+        // insertion into the sorted k-best list
+        auto ix = n < k ? n++ : k - 1;
+        while (ix > 0 && dists[side][ix - 1] > dist) {
+            dists[side][ix] = dists[side][ix - 1];
+            best[side][ix] = best[side][ix - 1];
+            ix--;
+        }
+        dists[side][ix] = dist;
+        best[side][ix] = &m_rects[item];
+    };
+
+    for (auto item : m_oversized)
+        consider(item);
+
+    auto qx0 = this->cellOf(std::min(rect.getMinX(), rect.getMaxX()));
+    auto qx1 = this->cellOf(std::max(rect.getMinX(), rect.getMaxX()));
+    auto qy0 = this->cellOf(std::min(rect.getMinY(), rect.getMaxY()));
+    auto qy1 = this->cellOf(std::max(rect.getMinY(), rect.getMaxY()));
+
+    auto visit = [&](int x, int y) {
+        if (x < m_minCellX || x > m_maxCellX || y < m_minCellY || y > m_maxCellY)
+            return;
+        auto it = m_cells.find(this->cellKey(x, y));
+        if (it == m_cells.end())
+            return;
+        for (auto i = it->second.first; i < it->second.first + it->second.second; i++)
+            consider(m_cellItems[i]);
+    };
+
+    // clamp the query to the grid so a node dragged far away doesn't
+    // walk thousands of empty cells
+    qx0 = std::max(qx0, m_minCellX - 1);
+    qx1 = std::min(qx1, m_maxCellX + 1);
+    qy0 = std::max(qy0, m_minCellY - 1);
+    qy1 = std::min(qy1, m_maxCellY + 1);
+    if (qx0 > qx1) qx0 = qx1 = qx0 > m_maxCellX ? m_maxCellX + 1 : m_minCellX - 1;
+    if (qy0 > qy1) qy0 = qy1 = qy0 > m_maxCellY ? m_maxCellY + 1 : m_minCellY - 1;
+
+    for (int r = 0;; r++) {
+        if (!r) {
+            for (auto x = qx0; x <= qx1; x++)
+                for (auto y = qy0; y <= qy1; y++)
+                    visit(x, y);
+        } else {
+            for (auto x = qx0 - r; x <= qx1 + r; x++) {
+                visit(x, qy0 - r);
+                visit(x, qy1 + r);
+            }
+            for (auto y = qy0 - r + 1; y <= qy1 + r - 1; y++) {
+                visit(qx0 - r, y);
+                visit(qx1 + r, y);
+            }
+        }
+
+        // a side is done once its list is full of things closer than
+        // anything not seen yet (at least r cells away), or once the
+        // rings are past the grid's edge on that side. sides go by
+        // centers, so that edge gets one ring of slack
+        bool pastEdge[sideCount] = {
+            qx0 - r + 1 <= m_minCellX,
+            qx1 + r - 1 >= m_maxCellX,
+            qy0 - r + 1 <= m_minCellY,
+            qy1 + r - 1 >= m_maxCellY,
+        };
+        auto done = true;
+        for (unsigned int side = 0; side < sideCount; side++) {
+            if (pastEdge[side])
+                continue;
+            if (found[side] < k || dists[side][k - 1] > r * m_cellSize)
+                done = false;
+        }
+        if (done)
+            break;
+    }
+
+    unsigned int count = 0;
+    for (unsigned int side = 0; side < sideCount; side++)
+        for (unsigned int i = 0; i < found[side]; i++)
+            out[count++] = best[side][i];
+
+    return count;
+}
+
+static constexpr float s_minGap = 0.5f;
+
+static bool gapLess(spacing_gap const& a, spacing_gap const& b) {
+    return a.gap < b.gap;
+}
+
+// what the gap lookups search for, only the gap itself matters
+static spacing_gap gapKey(float gap) {
+    return { gap, CCPoint {}, CCPoint {} };
+}
+
+void SpacingIndex::clear() {
+    for (auto axis : { saX, saY }) {
+        m_lanes[axis].clear();
+        m_items[axis].clear();
+        m_gaps[axis].clear();
+    }
+}
+
+void SpacingIndex::build(CCNode* dragged, float tolerance) {
+    this->clear();
+    m_tolerance = tolerance;
+
+    auto parent = dragged->getParent();
+    if (!parent) return;
+
+    std::vector<CCPoint> centers;
+    centers.reserve(parent->getChildrenCount());
+
+    CCObject* obj;
+    CCARRAY_FOREACH(parent->getChildren(), obj) {
+        auto node = reinterpret_cast<CCNode*>(obj);
+
+        if (!node || node == dragged) continue;
+
+        centers.push_back(node->getPosition());
+    }
+
+    this->buildAxis(saX, centers);
+    this->buildAxis(saY, centers);
+}
+
+void SpacingIndex::buildAxis(snap_axis axis, std::vector<CCPoint> const& centers) {
+    auto& items = m_items[axis];
+    auto& lanes = m_lanes[axis];
+    auto& gaps = m_gaps[axis];
+
+    items.reserve(centers.size());
+    for (auto const& c : centers) {
+        if (axis == saX)
+            items.push_back({ c.x, c.y });
+        else
+            items.push_back({ c.y, c.x });
+    }
+
+    // cluster into lanes by the cross coordinate, then sort each lane
+    // along the axis
+    std::sort(items.begin(), items.end(), [](lane_item const& a, lane_item const& b) {
+        return a.cross < b.cross;
+    });
+
+    for (unsigned int i = 0; i < items.size();) {
+        auto begin = i;
+        while (++i < items.size() && items[i].cross - items[i - 1].cross <= m_tolerance);
+
+        std::sort(items.begin() + begin, items.begin() + i, [](lane_item const& a, lane_item const& b) {
+            return a.value < b.value;
+        });
+        lanes.push_back({ items[begin].cross, begin, i });
+
+        for (auto j = begin + 1; j < i; j++) {
+            auto gap = items[j].value - items[j - 1].value;
+            if (gap < s_minGap)
+                continue;
+
+            if (axis == saX)
+                gaps.push_back({ gap, { items[j - 1].value, items[j - 1].cross }, { items[j].value, items[j].cross } });
+            else
+                gaps.push_back({ gap, { items[j - 1].cross, items[j - 1].value }, { items[j].cross, items[j].value } });
+        }
+    }
+
+    std::sort(gaps.begin(), gaps.end(), gapLess);
+}
+
+SpacingIndex::gap_range SpacingIndex::gapsOf(snap_axis axis, float gap) const {
+    auto const& gaps = m_gaps[axis];
+
+    return {
+        std::lower_bound(gaps.begin(), gaps.end(), gapKey(gap - s_lineEpsilon), gapLess),
+        std::upper_bound(gaps.begin(), gaps.end(), gapKey(gap + s_lineEpsilon), gapLess),
+    };
+}
+
+bool SpacingIndex::snap(snap_axis axis, CCPoint const& pos, float threshold, spacing_match& out) const {
+    auto const& lanes = m_lanes[axis];
+    auto const& items = m_items[axis];
+    auto const& gaps = m_gaps[axis];
+
+    if (gaps.empty())
+        return false;
+
+    auto value = axis == saX ? pos.x : pos.y;
+    auto cross = axis == saX ? pos.y : pos.x;
+
+    // the lane the dragged node sits in. the node follows the mouse, so
+    // it's only ever near a lane, not on it: anything within the snap
+    // threshold counts, the lanes themselves stay clustered tightly
+    auto reach = std::max(m_tolerance, threshold);
+    lane const* current = nullptr;
+    auto it = std::lower_bound(lanes.begin(), lanes.end(), cross - reach, [](lane const& l, float v) {
+        return l.key < v;
+    });
+    for (; it != lanes.end() && it->key <= cross + reach; it++) {
+        if (!current || fabsf(it->key - cross) < fabsf(current->key - cross))
+            current = &*it;
+    }
+    if (!current)
+        return false;
+
+    auto first = items.begin() + current->begin;
+    auto last = items.begin() + current->end;
+    auto right = std::lower_bound(first, last, value, [](lane_item const& i, float v) {
+        return i.value < v;
+    });
+
+    auto toPoint = [axis](lane_item const& item) -> CCPoint {
+        return axis == saX ? CCPoint { item.value, item.cross } : CCPoint { item.cross, item.value };
+    };
+
+    // the gap between the neighbours on either side is the one the
+    // node is splitting right now, matching it would only ever put the
+    // node on top of one of them
+    auto split = right != first && right != last;
+    auto splitFrom = split ? toPoint(*(right - 1)) : CCPoint {};
+    auto splitTo = split ? toPoint(*right) : CCPoint {};
+    auto isSplit = [&](spacing_gap const& g) {
+        return
+            split &&
+            g.from.x == splitFrom.x && g.from.y == splitFrom.y &&
+            g.to.x == splitTo.x && g.to.y == splitTo.y;
+    };
+
+    // the existing gap closest to `gap`, if any is within the threshold
+    auto closestGap = [&](float gap, float& res) -> bool {
+        auto git = std::lower_bound(gaps.begin(), gaps.end(), gapKey(gap - threshold), gapLess);
+        bool found = false;
+        for (; git != gaps.end() && git->gap <= gap + threshold; git++) {
+            if (isSplit(*git))
+                continue;
+            if (!found || fabsf(git->gap - gap) < fabsf(res - gap)) {
+                res = git->gap;
+                found = true;
+            }
+        }
+        return found;
+    };
+
+    auto best = threshold;
+    bool found = false;
+    float gap;
+
+    if (right != first) {
+        auto const& l = *(right - 1);
+        if (closestGap(value - l.value, gap) && fabsf(l.value + gap - value) < best) {
+            best = fabsf(l.value + gap - value);
+            out = { l.value + gap - value, gap, toPoint(l), toPoint(l), false };
+            found = true;
+        }
+    }
+
+    if (right != last) {
+        auto const& r = *right;
+        if (closestGap(r.value - value, gap) && fabsf(r.value - gap - value) < best) {
+            best = fabsf(r.value - gap - value);
+            out = { r.value - gap - value, gap, toPoint(r), toPoint(r), false };
+            found = true;
+        }
+    }
+
+    // evenly between both neighbours
+    if (right != first && right != last) {
+        auto const& l = *(right - 1);
+        auto const& r = *right;
+        auto mid = (l.value + r.value) / 2;
+        if (mid - l.value >= s_minGap && fabsf(mid - value) < best) {
+            out = { mid - value, mid - l.value, toPoint(l), toPoint(r), true };
+            found = true;
+        }
+    }
+
+    return found;
+}
@@ -0,0 +1,157 @@
+#ifndef __SNAPPING_HPP__
+#define __SNAPPING_HPP__
+
+#include <vector>
+#include <utility>
+#include <unordered_map>
+#include <cocos2d.h>
+#include "spatial_index.hpp"
+
+using namespace cocos2d;
+
+enum snap_axis {
+    saX,
+    saY,
+};
+
+struct snap_line {
+    float value;
+    CCNode* node;   // nullptr for the window's center
+};
+
+struct snap_match {
+    float delta;    // how far the dragged node has to move
+    float value;    // the line it snaps to
+    bool window;
+};
+
+// every alignment line (left/center/right and bottom/center/top in
+// world space) of the nodes on screen, sorted per axis. built once
+// when a drag starts, so a frame only costs a couple binary searches.
+// the nodes are retained until the next build, the spatial index they
+// come from may be rebuilt mid drag
+class AlignmentIndex {
+    public:
+        ~AlignmentIndex();
+
+        void build(
+            SpatialIndex const& index, CCNode* dragged,
+            CCSize const& winSize, bool windowCenter
+        );
+        void clear();
+
+        // the line closest to any of `values` within `threshold`
+        bool closest(
+            snap_axis axis, float const* values, unsigned int count,
+            float threshold, bool nodes, snap_match& out
+        ) const;
+
+        using line_range = std::pair<
+            std::vector<snap_line>::const_iterator,
+            std::vector<snap_line>::const_iterator
+        >;
+        line_range linesAt(snap_axis axis, float value) const;
+
+    protected:
+        std::vector<snap_line> m_lines[2];
+        std::vector<CCNode*> m_nodes;
+};
+
+struct sibling_rect {
+    CCRect rect;    // parent space
+    CCNode* node;
+};
+
+// uniform grid over the dragged node's siblings, built when a drag
+// starts. rects are bucketed into every cell they overlap, except
+// huge ones which are just always checked
+class SiblingHash {
+    public:
+        enum sibling_side {
+            ssLeft,
+            ssRight,
+            ssBelow,
+            ssAbove,
+        };
+
+        static constexpr unsigned int maxNearest = 8;
+        static constexpr unsigned int sideCount = 4;
+
+        void build(CCNode* dragged);
+        void clear();
+
+        // up to `k` siblings closest to `rect` (by the gap between
+        // them) on each side of it, going by their centers. `out` holds
+        // up to `sideCount * k`, side by side and nearest first within
+        // each. returns how many were found
+        unsigned int nearest(CCRect const& rect, unsigned int k, sibling_rect const** out) const;
+
+    protected:
+        long long cellKey(int x, int y) const;
+        int cellOf(float v) const;
+
+        float m_cellSize = 1.0f;
+        int m_minCellX = 0, m_maxCellX = -1;
+        int m_minCellY = 0, m_maxCellY = -1;
+
+        std::vector<sibling_rect> m_rects;
+        std::vector<unsigned int> m_cellItems;
+        std::unordered_map<long long, std::pair<unsigned int, unsigned int>> m_cells;
+        std::vector<unsigned int> m_oversized;
+
+        mutable std::vector<unsigned int> m_stamps;
+        mutable unsigned int m_stamp = 0;
+};
+
+struct spacing_gap {
+    float gap;
+    CCPoint from;   // parent space centers of the two nodes
+    CCPoint to;
+};
+
+struct spacing_match {
+    float delta;
+    float gap;
+    CCPoint neighbour;
+    CCPoint other;      // second neighbour when centered between two
+    bool between;
+};
+
+// siblings grouped into rows (for X) and columns (for Y), each sorted
+// along the axis, plus every gap between consecutive nodes of a lane
+// in one sorted array. built when a drag starts; each frame then finds
+// the dragged node's lane and neighbours and looks for an existing gap
+// matching the one it would leave with a couple binary searches
+class SpacingIndex {
+    public:
+        void build(CCNode* dragged, float tolerance);
+        void clear();
+
+        bool snap(snap_axis axis, CCPoint const& pos, float threshold, spacing_match& out) const;
+
+        using gap_range = std::pair<
+            std::vector<spacing_gap>::const_iterator,
+            std::vector<spacing_gap>::const_iterator
+        >;
+        gap_range gapsOf(snap_axis axis, float gap) const;
+
+    protected:
+        struct lane_item {
+            float value;    // along the axis
+            float cross;    // across it
+        };
+        struct lane {
+            float key;
+            unsigned int begin;
+            unsigned int end;
+        };
+
+        void buildAxis(snap_axis axis, std::vector<CCPoint> const& centers);
+
+        float m_tolerance = 0.0f;
+        std::vector<lane> m_lanes[2];
+        std::vector<lane_item> m_items[2];
+        std::vector<spacing_gap> m_gaps[2];
+};
+
+#endif
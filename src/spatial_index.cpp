@@ -0,0 +1,687 @@
+#include "spatial_index.hpp"
+#include "frame_context.hpp"
+#include <algorithm>
+#include <cfloat>
+
+static constexpr unsigned int s_leafSize = 4;
+static constexpr unsigned int s_maxDepth = 64;
+// how many entries outside the tree and dead items inside it are put
+// up with, on top of a sixteenth of the index, before the tree is
+// built again over the bounds the entries already have
+static constexpr unsigned int s_patchSlack = 64;
+
+static CCRect mergeRects(CCRect const& a, CCRect const& b) {
+    auto minX = std::min(a.getMinX(), b.getMinX());
+    auto minY = std::min(a.getMinY(), b.getMinY());
+    auto maxX = std::max(a.getMaxX(), b.getMaxX());
+    auto maxY = std::max(a.getMaxY(), b.getMaxY());
+
+    return CCRect { minX, minY, maxX - minX, maxY - minY };
+}
+
+static bool rectEquals(CCRect const& a, CCRect const& b) {
+    return
+        a.origin.x == b.origin.x && a.origin.y == b.origin.y &&
+        a.size.width == b.size.width && a.size.height == b.size.height;
+}
+
+static bool transformEquals(CCAffineTransform const& a, CCAffineTransform const& b) {
+    return
+        a.a == b.a && a.b == b.b && a.c == b.c && a.d == b.d &&
+        a.tx == b.tx && a.ty == b.ty;
+}
+
+// child count if the node's children are indexed, npos otherwise
+static unsigned int indexedChildren(CCNode* node) {
+    if (!node->getChildrenCount() || stopCheckingChildren(node))
+        return SpatialIndex::npos;
+    return node->getChildrenCount();
+}
+
+CCRect getNodeWorldRect(CCNode* node) {
+    return g_frame.worldRect(node);
+}
+
+SpatialIndex::~SpatialIndex() {
+    this->clear();
+}
+
+void SpatialIndex::clear() {
+    for (auto& entry : m_entries)
+        entry.node->release();
+    if (m_root)
+        m_root->release();
+
+    m_root = nullptr;
+    m_entries.clear();
+    m_items.clear();
+    m_leafOf.clear();
+    m_pending.clear();
+    m_deadItems = 0;
+    m_parents.clear();
+    m_nodes.clear();
+    m_dirtyEntries.clear();
+    m_dirtyLeaves.clear();
+    m_lookup.clear();
+    m_positions.clear();
+    m_freeSlots.clear();
+    m_validateCursor = 0;
+    m_invalid = true;
+}
+
+void SpatialIndex::invalidate() {
+    m_invalid = true;
+}
+
+bool SpatialIndex::needsRebuild(CCNode* root) {
+    if (!m_invalid && root == m_root)
+        this->patch();
+    return m_invalid || root != m_root;
+}
+
+unsigned int SpatialIndex::assign(CCNode* node, unsigned int ix) {
+    unsigned int slot;
+    if (m_freeSlots.empty()) {
+        slot = static_cast<unsigned int>(m_positions.size());
+        m_positions.push_back(ix);
+    } else {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+        m_positions[slot] = ix;
+    }
+    m_lookup[node] = slot;
+    return slot;
+}
+
+void SpatialIndex::forget(node_bounds const& entry) {
+    // the node may have been indexed again elsewhere already
+    auto it = m_lookup.find(entry.node);
+    if (it != m_lookup.end() && it->second == entry.slot)
+        m_lookup.erase(it);
+    m_freeSlots.push_back(entry.slot);
+    entry.node->release();
+}
+
+// appends the node and its indexed subtree to `out`, whose first
+// entry ends up at index `base`
+void SpatialIndex::collect(CCNode* node, unsigned int parent, unsigned int base, std::vector<node_bounds>& out) {
+    auto ix = static_cast<unsigned int>(out.size());
+
+    node_bounds entry;
+    entry.rect = getNodeWorldRect(node);
+    entry.node = node;
+    entry.parent = parent;
+    entry.end = base + ix + 1;
+    entry.children = indexedChildren(node);
+    entry.slot = this->assign(node, base + ix);
+    entry.transform = entry.children != npos ? node->nodeToParentTransform() : CCAffineTransformMakeIdentity();
+    entry.container = isContainerNode(node);
+    entry.visible = node->isVisible();
+
+    node->retain();
+    out.push_back(entry);
+
+    if (entry.children != npos) {
+        CCObject* obj;
+        CCARRAY_FOREACH(node->getChildren(), obj) {
+            auto child = reinterpret_cast<CCNode*>(obj);
+            if (child)
+                this->collect(child, base + ix, base, out);
+        }
+    }
+
+    out[ix].end = base + static_cast<unsigned int>(out.size());
+}
+
+void SpatialIndex::build(CCNode* root) {
+    this->clear();
+    if (!root) return;
+
+    // whatever the mirror logged so far is in the build already
+    if (m_log == SceneMirror::npos)
+        m_log = g_mirror.openLog();
+    g_mirror.takeChanges(m_log, m_changes);
+
+    root->retain();
+    m_root = root;
+    m_rootTransform = g_frame.worldTransform(root);
+
+    CCObject* obj;
+    CCARRAY_FOREACH(root->getChildren(), obj) {
+        auto node = reinterpret_cast<CCNode*>(obj);
+        if (node)
+            this->collect(node, npos, 0, m_entries);
+    }
+
+    for (unsigned int i = 0; i < m_entries.size(); i++)
+        if (m_entries[i].children != npos)
+            m_parents.push_back(i);
+
+    this->buildTree();
+    m_invalid = false;
+}
+
+void SpatialIndex::buildTree() {
+    auto count = static_cast<unsigned int>(m_entries.size());
+
+    m_items.resize(count);
+    for (unsigned int i = 0; i < count; i++)
+        m_items[i] = i;
+    m_leafOf.resize(count);
+    m_pending.clear();
+    m_deadItems = 0;
+    m_nodes.clear();
+    m_dirtyLeaves.clear();
+    m_nodes.reserve(count / s_leafSize * 2 + 1);
+
+    if (count)
+        this->buildNode(0, count, npos);
+
+    m_version++;
+}
+
+// an entry whose children were collected again may have gained or
+// lost them. checkParents only follows its transform while it has
+// some, so whatever moved in between is refreshed once patched in
+void SpatialIndex::restamp(node_bounds& entry, unsigned int ix) {
+    auto was = entry.children;
+    entry.children = indexedChildren(entry.node);
+    if ((was == npos) == (entry.children == npos))
+        return;
+
+    if (entry.children != npos)
+        entry.transform = entry.node->nodeToParentTransform();
+    m_restamped.push_back(ix);
+}
+
+unsigned int SpatialIndex::remapped(unsigned int old) const {
+    if (old == npos || old < m_from)
+        return old;
+    return m_remap[old - m_from];
+}
+
+void SpatialIndex::moveOver(unsigned int old) {
+    auto entry = m_entries[old];
+    entry.parent = this->remapped(entry.parent);
+    m_remap[old - m_from] = m_from + static_cast<unsigned int>(m_tail.size());
+    m_tail.push_back(entry);
+}
+
+// appends the indexed children of the entry at `old` (npos for the
+// root) to m_tail, where the entry itself now sits at `self`. children
+// that were indexed under it already keep their entries and bounds:
+// subtrees with nothing stale inside move over whole, only what's new
+// is collected from cocos
+void SpatialIndex::recollect(unsigned int old, unsigned int self, unsigned int base) {
+    auto parent = old == npos ? m_root : m_entries[old].node;
+    if (old != npos && indexedChildren(parent) == npos)
+        return;
+
+    CCObject* obj;
+    CCARRAY_FOREACH(parent->getChildren(), obj) {
+        auto node = reinterpret_cast<CCNode*>(obj);
+        if (!node) continue;
+
+        auto q = this->entryOf(node);
+        if (q == npos || q < m_from || m_entries[q].parent != old || m_remap[q - m_from] != npos) {
+            this->collect(node, self, base, m_tail);
+            continue;
+        }
+
+        auto end = m_entries[q].end;
+        auto inner = std::lower_bound(m_staleRoots.begin(), m_staleRoots.end(), q);
+        if (inner != m_staleRoots.end() && *inner < end) {
+            // something further down changed, go through it child by child
+            auto ix = static_cast<unsigned int>(m_tail.size());
+            m_remap[q - m_from] = base + ix;
+            m_tail.push_back(m_entries[q]);
+            m_tail[ix].parent = self;
+            if (*inner == q)
+                this->restamp(m_tail[ix], base + ix);
+            this->recollect(q, base + ix, base);
+            continue;
+        }
+
+        auto offset = base + static_cast<unsigned int>(m_tail.size()) - q;
+        for (auto j = q; j < end; j++) {
+            m_tail.push_back(m_entries[j]);
+            m_tail.back().parent = j == q ? self : m_entries[j].parent + offset;
+            m_remap[j - m_from] = j + offset;
+        }
+    }
+}
+
+// lays the parents the mirror saw changing out again, from the first
+// of them to the end of the index. the tree keeps its shape: surviving
+// items are pointed at their new entries, removed ones are left dead
+// and new entries wait outside it
+void SpatialIndex::patch() {
+    g_mirror.takeChanges(m_log, m_changes);
+    if (m_changes.reset) {
+        m_invalid = true;
+        return;
+    }
+
+    // one of the root's own children changing lays out everything.
+    // nodes the mirror collected again that are indexed already (a
+    // cleanup in place, a move) can't have their subtrees taken over
+    // as they were either
+    auto whole = false;
+    m_staleRoots.clear();
+    for (auto node : m_changes.parents) {
+        if (node == m_root) {
+            whole = true;
+            continue;
+        }
+        auto ix = this->entryOf(node);
+        if (ix != npos)
+            m_staleRoots.push_back(ix);
+    }
+    for (auto node : m_changes.added) {
+        auto ix = this->entryOf(node);
+        if (ix != npos)
+            m_staleRoots.push_back(ix);
+    }
+    if (!whole && m_staleRoots.empty())
+        return;
+
+    // ancestors first, anything inside a range comes along with it
+    std::sort(m_staleRoots.begin(), m_staleRoots.end());
+    m_staleRoots.erase(std::unique(m_staleRoots.begin(), m_staleRoots.end()), m_staleRoots.end());
+
+    m_ranges.clear();
+    if (whole) {
+        m_ranges.push_back(npos);
+    } else {
+        unsigned int covered = 0;
+        for (auto ix : m_staleRoots) {
+            if (ix < covered)
+                continue;
+            m_ranges.push_back(ix);
+            covered = m_entries[ix].end;
+        }
+    }
+
+    auto size = static_cast<unsigned int>(m_entries.size());
+    m_from = whole ? 0 : m_ranges.front() + 1;
+    m_remap.assign(size - m_from, npos);
+    m_tail.clear();
+    m_restamped.clear();
+
+    auto old = m_from;
+    for (auto r : m_ranges) {
+        if (r != npos) {
+            for (; old <= r; old++)
+                this->moveOver(old);
+        }
+
+        auto self = this->remapped(r);
+        if (r != npos)
+            this->restamp(self < m_from ? m_entries[self] : m_tail[self - m_from], self);
+        this->recollect(r, self, m_from);
+
+        old = r == npos ? size : m_entries[r].end;
+    }
+    for (; old < size; old++)
+        this->moveOver(old);
+
+    // whatever wasn't taken over was removed
+    for (auto j = m_from; j < size; j++)
+        if (m_remap[j - m_from] == npos)
+            this->forget(m_entries[j]);
+
+    // subtree ends, bottom up. the first range's root and its ancestors
+    // are the only entries before m_from that reach into the tail
+    auto count = static_cast<unsigned int>(m_tail.size());
+    auto first = whole ? npos : m_from - 1;
+    for (unsigned int i = 0; i < count; i++)
+        m_tail[i].end = m_from + i + 1;
+    for (auto p = first; p != npos; p = m_entries[p].parent)
+        m_entries[p].end = m_from;
+    for (auto i = count; i-- > 0;) {
+        auto p = m_tail[i].parent;
+        if (p == npos)
+            continue;
+        auto& end = p < m_from ? m_entries[p].end : m_tail[p - m_from].end;
+        end = std::max(end, m_tail[i].end);
+    }
+    for (auto p = first; p != npos && m_entries[p].parent != npos; p = m_entries[p].parent) {
+        auto& end = m_entries[m_entries[p].parent].end;
+        end = std::max(end, m_entries[p].end);
+    }
+
+    m_leafTail.assign(count, npos);
+    for (auto j = m_from; j < size; j++) {
+        auto ix = m_remap[j - m_from];
+        if (ix != npos)
+            m_leafTail[ix - m_from] = m_leafOf[j];
+    }
+
+    for (auto& item : m_items) {
+        if (item == npos || item < m_from)
+            continue;
+        item = m_remap[item - m_from];
+        if (item == npos)
+            m_deadItems++;
+    }
+
+    auto dirty = m_dirtyEntries.begin();
+    for (auto ix : m_dirtyEntries) {
+        ix = this->remapped(ix);
+        if (ix != npos)
+            *dirty++ = ix;
+    }
+    m_dirtyEntries.erase(dirty, m_dirtyEntries.end());
+    m_dirtyEntries.insert(m_dirtyEntries.end(), m_restamped.begin(), m_restamped.end());
+
+    m_entries.resize(m_from);
+    m_entries.insert(m_entries.end(), m_tail.begin(), m_tail.end());
+    m_leafOf.resize(m_from);
+    m_leafOf.insert(m_leafOf.end(), m_leafTail.begin(), m_leafTail.end());
+    for (auto i = m_from; i < m_entries.size(); i++)
+        m_positions[m_entries[i].slot] = i;
+
+    // pending entries and parents before m_from stay where they were
+    m_pending.erase(std::lower_bound(m_pending.begin(), m_pending.end(), m_from), m_pending.end());
+    m_parents.erase(std::lower_bound(m_parents.begin(), m_parents.end(), m_from), m_parents.end());
+    for (auto i = m_from; i < m_entries.size(); i++) {
+        if (m_leafOf[i] == npos)
+            m_pending.push_back(i);
+        if (m_entries[i].children != npos)
+            m_parents.push_back(i);
+    }
+
+    if (m_pending.size() + m_deadItems > s_patchSlack + m_entries.size() / 16)
+        this->buildTree();
+    else
+        m_version++;
+}
+
+unsigned int SpatialIndex::buildNode(unsigned int begin, unsigned int end, unsigned int parent) {
+    auto ix = static_cast<unsigned int>(m_nodes.size());
+    m_nodes.push_back({ m_entries[m_items[begin]].rect, begin, 0, end - begin, parent });
+
+    auto centerMinX = FLT_MAX, centerMaxX = -FLT_MAX;
+    auto centerMinY = FLT_MAX, centerMaxY = -FLT_MAX;
+    auto bounds = m_nodes[ix].bounds;
+    for (auto i = begin; i < end; i++) {
+        auto const& rect = m_entries[m_items[i]].rect;
+        bounds = mergeRects(bounds, rect);
+        centerMinX = std::min(centerMinX, rect.getMidX());
+        centerMaxX = std::max(centerMaxX, rect.getMidX());
+        centerMinY = std::min(centerMinY, rect.getMidY());
+        centerMaxY = std::max(centerMaxY, rect.getMidY());
+    }
+    m_nodes[ix].bounds = bounds;
+
+    if (end - begin <= s_leafSize) {
+        for (auto i = begin; i < end; i++)
+            m_leafOf[m_items[i]] = ix;
+        return ix;
+    }
+
+    // median split along the axis the centers are spread out the most on
+    auto splitX = centerMaxX - centerMinX >= centerMaxY - centerMinY;
+    auto mid = begin + (end - begin) / 2;
+    std::nth_element(
+        m_items.begin() + begin, m_items.begin() + mid, m_items.begin() + end,
+        [this, splitX](unsigned int a, unsigned int b) -> bool {
+            auto const& ra = m_entries[a].rect;
+            auto const& rb = m_entries[b].rect;
+            return splitX ? ra.getMidX() < rb.getMidX() : ra.getMidY() < rb.getMidY();
+        }
+    );
+
+    auto left = this->buildNode(begin, mid, ix);
+    auto right = this->buildNode(mid, end, ix);
+
+    m_nodes[ix].first = left;
+    m_nodes[ix].second = right;
+    m_nodes[ix].count = 0;
+
+    return ix;
+}
+
+unsigned int SpatialIndex::entryOf(CCNode* node) const {
+    auto it = m_lookup.find(node);
+    if (it == m_lookup.end())
+        return npos;
+    return m_positions[it->second];
+}
+
+void SpatialIndex::markDirty(CCNode* node) {
+    auto ix = this->entryOf(node);
+    if (ix != npos)
+        m_dirtyEntries.push_back(ix);
+}
+
+// a parent moving takes its whole subtree along, so unlike the rest
+// those aren't left for the slice to get around to
+void SpatialIndex::checkParents() {
+    auto size = static_cast<unsigned int>(m_entries.size());
+    unsigned int covered = 0;
+
+    auto const& rootTransform = g_frame.worldTransform(m_root);
+    if (!transformEquals(rootTransform, m_rootTransform)) {
+        m_rootTransform = rootTransform;
+        for (unsigned int i = 0; i < size; i = m_entries[i].end)
+            m_dirtyEntries.push_back(i);
+        covered = size;
+    }
+
+    for (auto ix : m_parents) {
+        auto& entry = m_entries[ix];
+        auto transform = entry.node->nodeToParentTransform();
+        if (transformEquals(transform, entry.transform))
+            continue;
+
+        entry.transform = transform;
+        if (ix >= covered) {
+            m_dirtyEntries.push_back(ix);
+            covered = entry.end;
+        }
+    }
+}
+
+void SpatialIndex::validateSlice(unsigned int count) {
+    if (m_invalid || m_entries.empty())
+        return;
+
+    this->checkParents();
+
+    auto size = static_cast<unsigned int>(m_entries.size());
+    count = std::min(count, size);
+
+    for (unsigned int i = 0; i < count; i++) {
+        if (m_validateCursor >= size)
+            m_validateCursor = 0;
+
+        auto& entry = m_entries[m_validateCursor];
+        auto expectedParent = entry.parent == npos ? m_root : m_entries[entry.parent].node;
+
+        if (
+            entry.node->getParent() != expectedParent ||
+            (entry.children != npos && entry.node->getChildrenCount() != entry.children)
+        ) {
+            m_invalid = true;
+            return;
+        }
+
+        // nothing structural, hover checks it on the node anyway
+        entry.visible = entry.node->isVisible();
+
+        auto rect = getNodeWorldRect(entry.node);
+        if (!rectEquals(rect, entry.rect)) {
+            entry.rect = rect;
+            if (m_leafOf[m_validateCursor] != npos)
+                m_dirtyLeaves.push_back(m_leafOf[m_validateCursor]);
+        }
+
+        m_validateCursor++;
+    }
+}
+
+void SpatialIndex::refresh() {
+    if (m_invalid)
+        return;
+
+    auto moved = !m_dirtyEntries.empty();
+    for (auto ix : m_dirtyEntries) {
+        for (auto i = ix; i < m_entries[ix].end; i++) {
+            if (!this->isAttached(i)) {
+                m_invalid = true;
+                break;
+            }
+            m_entries[i].rect = getNodeWorldRect(m_entries[i].node);
+            if (m_leafOf[i] != npos)
+                m_dirtyLeaves.push_back(m_leafOf[i]);
+        }
+        if (m_invalid)
+            break;
+    }
+    m_dirtyEntries.clear();
+
+    if (m_invalid) {
+        m_dirtyLeaves.clear();
+        return;
+    }
+
+    if (moved || !m_dirtyLeaves.empty())
+        m_version++;
+
+    // walking up from every leaf costs O(k log n), past a certain
+    // point a single bottom-up pass over the whole tree is cheaper
+    if (m_dirtyLeaves.size() > m_nodes.size() / 8) {
+        this->refitAll();
+    } else {
+        std::sort(m_dirtyLeaves.begin(), m_dirtyLeaves.end());
+        auto last = std::unique(m_dirtyLeaves.begin(), m_dirtyLeaves.end());
+        for (auto it = m_dirtyLeaves.begin(); it != last; it++)
+            this->refitFrom(*it);
+    }
+    m_dirtyLeaves.clear();
+}
+
+// removed items don't count, a leaf left with none of them keeps the
+// bounds it had until the tree is built again
+void SpatialIndex::fitLeaf(bvh_node& node) const {
+    auto fitted = false;
+    for (auto i = node.first; i < node.first + node.count; i++) {
+        auto ix = m_items[i];
+        if (ix == npos)
+            continue;
+        node.bounds = fitted ? mergeRects(node.bounds, m_entries[ix].rect) : m_entries[ix].rect;
+        fitted = true;
+    }
+}
+
+void SpatialIndex::refitFrom(unsigned int leaf) {
+    auto& node = m_nodes[leaf];
+    this->fitLeaf(node);
+
+    auto ix = node.parent;
+    while (ix != npos) {
+        auto& inner = m_nodes[ix];
+        inner.bounds = mergeRects(m_nodes[inner.first].bounds, m_nodes[inner.second].bounds);
+        ix = inner.parent;
+    }
+}
+
+void SpatialIndex::refitAll() {
+    // children are always pushed after their parent, so walking the
+    // array backwards visits every node after both of its children
+    for (auto ix = static_cast<unsigned int>(m_nodes.size()); ix-- > 0;) {
+        auto& node = m_nodes[ix];
+        if (node.count)
+            this->fitLeaf(node);
+        else
+            node.bounds = mergeRects(m_nodes[node.first].bounds, m_nodes[node.second].bounds);
+    }
+}
+
+bool SpatialIndex::isAttached(unsigned int ix) const {
+    while (ix != npos) {
+        auto const& entry = m_entries[ix];
+        auto expectedParent = entry.parent == npos ? m_root : m_entries[entry.parent].node;
+        if (entry.node->getParent() != expectedParent)
+            return false;
+        ix = entry.parent;
+    }
+    return true;
+}
+
+bool SpatialIndex::containsExact(node_bounds const& entry, CCPoint const& worldPos) const {
+    auto node = entry.node;
+    auto pos = node->getPosition();
+    auto size = node->getScaledContentSize();
+    auto rect = CCRect { pos.x, pos.y, size.width, size.height };
+
+    rect.origin = rect.origin - rect.size / 2;
+
+    return rect.containsPoint(g_frame.toNode(node->getParent(), worldPos));
+}
+
+// false if the entry turned out to be detached, the index is
+// invalid from then on
+bool SpatialIndex::pick(unsigned int ix, CCPoint const& worldPos, bool containers, unsigned int& best, int& bestZ) {
+    auto const& entry = m_entries[ix];
+
+    if (entry.container != containers)
+        return true;
+    if (!entry.rect.containsPoint(worldPos))
+        return true;
+
+    auto z = entry.node->getZOrder();
+    if (best != npos && (z < bestZ || (z == bestZ && ix < best)))
+        return true;
+
+    if (!this->isAttached(ix)) {
+        m_invalid = true;
+        return false;
+    }
+    if (!entry.node->isVisible() || !this->containsExact(entry, worldPos))
+        return true;
+
+    best = ix;
+    bestZ = z;
+    return true;
+}
+
+CCNode* SpatialIndex::nodeAt(CCPoint const& worldPos, bool containers) {
+    if (m_invalid || m_entries.empty())
+        return nullptr;
+
+    unsigned int stack[s_maxDepth];
+    unsigned int top = 0;
+    if (!m_nodes.empty())
+        stack[top++] = 0;
+
+    auto best = npos;
+    auto bestZ = 0;
+
+    while (top) {
+        auto const& node = m_nodes[stack[--top]];
+
+        if (!node.bounds.containsPoint(worldPos))
+            continue;
+
+        if (!node.count) {
+            stack[top++] = node.first;
+            stack[top++] = node.second;
+            continue;
+        }
+
+        for (auto i = node.first; i < node.first + node.count; i++) {
+            auto ix = m_items[i];
+            if (ix != npos && !this->pick(ix, worldPos, containers, best, bestZ))
+                return nullptr;
+        }
+    }
+
+    // added since the tree was built
+    for (auto ix : m_pending)
+        if (!this->pick(ix, worldPos, containers, best, bestZ))
+            return nullptr;
+
+    return best == npos ? nullptr : m_entries[best].node;
+}
@@ -0,0 +1,125 @@
+#ifndef __SPATIAL_INDEX_HPP__
+#define __SPATIAL_INDEX_HPP__
+
+#include <vector>
+#include <unordered_map>
+#include <cocos2d.h>
+#include "scene_graph.hpp"
+#include "scene_mirror.hpp"
+
+using namespace cocos2d;
+
+// the node's content rect centered on its position, in world space
+CCRect getNodeWorldRect(CCNode* node);
+
+struct node_bounds {
+    CCRect rect;            // world space AABB
+    CCNode* node;
+    unsigned int parent;    // entry index of the parent, or npos for the root's children
+    unsigned int end;       // one past the last entry of this node's subtree
+    unsigned int children;  // child count when built, npos if the children aren't indexed
+    unsigned int slot;      // where the lookup keeps its index
+    CCAffineTransform transform;    // node to parent, when the children are indexed
+    bool container;
+    bool visible;
+};
+
+struct bvh_node {
+    CCRect bounds;
+    unsigned int first;     // left child, or first item if this is a leaf
+    unsigned int second;    // right child
+    unsigned int count;     // 0 for inner nodes
+    unsigned int parent;
+};
+
+// world-space bounding volume hierarchy over the nodes that the
+// hover logic can pick. entries are stored in depth-first order, so
+// a subtree is a contiguous range and, on equal z order, the node
+// visited last wins (same as the old recursive walk did). nodes added
+// or removed are patched in from the mirror's change log: new entries
+// wait outside the tree, removed ones leave dead items in its leaves,
+// and the tree is only built again once enough of either piles up
+class SpatialIndex {
+    public:
+        static constexpr unsigned int npos = static_cast<unsigned int>(-1);
+
+        ~SpatialIndex();
+
+        void build(CCNode* root);
+        void clear();
+        void invalidate();
+        // catches up with the mirror first, so only a new root or
+        // something it couldn't follow needs a rebuild
+        bool needsRebuild(CCNode* root);
+
+        // recompute bounds of this node and everything below it
+        void markDirty(CCNode* node);
+        // called every frame. parents whose transform changed get
+        // their subtree refreshed, then up to `count` more entries are
+        // checked, rolling through the index over successive frames.
+        // structural changes the mirror didn't see (child counts
+        // differing) flag a rebuild
+        void validateSlice(unsigned int count);
+        void refresh();
+
+        CCNode* nodeAt(CCPoint const& worldPos, bool containers);
+
+        std::vector<node_bounds> const& entries() const { return m_entries; }
+        unsigned int entryOf(CCNode* node) const;
+        // bumped whenever a build or refresh changes any bounds
+        unsigned int version() const { return m_version; }
+
+    protected:
+        void collect(CCNode* node, unsigned int parent, unsigned int base, std::vector<node_bounds>& out);
+        void recollect(unsigned int old, unsigned int self, unsigned int base);
+        void patch();
+        void restamp(node_bounds& entry, unsigned int ix);
+        void moveOver(unsigned int old);
+        unsigned int remapped(unsigned int old) const;
+        unsigned int assign(CCNode* node, unsigned int ix);
+        void forget(node_bounds const& entry);
+        void checkParents();
+        void buildTree();
+        unsigned int buildNode(unsigned int begin, unsigned int end, unsigned int parent);
+        void fitLeaf(bvh_node& node) const;
+        void refitFrom(unsigned int leaf);
+        void refitAll();
+        bool isAttached(unsigned int entry) const;
+        bool containsExact(node_bounds const& entry, CCPoint const& worldPos) const;
+        bool pick(unsigned int ix, CCPoint const& worldPos, bool containers, unsigned int& best, int& bestZ);
+
+        CCNode* m_root = nullptr;
+        bool m_invalid = true;
+        unsigned int m_validateCursor = 0;
+        unsigned int m_version = 0;
+        CCAffineTransform m_rootTransform;
+
+        std::vector<node_bounds> m_entries;
+        std::vector<unsigned int> m_items;     // entry indices referenced by leaves, npos once removed
+        std::vector<unsigned int> m_leafOf;    // entry index -> leaf, npos if not in the tree yet
+        std::vector<unsigned int> m_pending;   // entries added since the tree was built
+        unsigned int m_deadItems = 0;
+        std::vector<unsigned int> m_parents;   // entries whose children are indexed
+        std::vector<bvh_node> m_nodes;
+        std::vector<unsigned int> m_dirtyEntries;
+        std::vector<unsigned int> m_dirtyLeaves;
+        // node to slot to entry, so moving entries around only has to
+        // rewrite the flat slot array
+        std::unordered_map<CCNode*, unsigned int> m_lookup;
+        std::vector<unsigned int> m_positions;
+        std::vector<unsigned int> m_freeSlots;
+
+        // patching: everything from m_from on is laid out again in
+        // m_tail, m_remap takes old indices there to new ones
+        uint32_t m_log = SceneMirror::npos;
+        mirror_changes m_changes {};
+        std::vector<unsigned int> m_staleRoots;
+        std::vector<unsigned int> m_ranges;
+        std::vector<node_bounds> m_tail;
+        std::vector<unsigned int> m_remap;
+        std::vector<unsigned int> m_leafTail;
+        std::vector<unsigned int> m_restamped;
+        unsigned int m_from = 0;
+};
+
+#endif
@@ -0,0 +1,165 @@
+#include "task_scheduler.hpp"
+#include <algorithm>
+
+TaskScheduler g_tasks;
+
+namespace {
+    using steady_clock = std::chrono::steady_clock;
+
+    steady_clock::time_point deadlineIn(double ms) {
+        return steady_clock::now() + std::chrono::duration_cast<steady_clock::duration>(
+            std::chrono::duration<double, std::milli>(ms)
+        );
+    }
+
+    // highest priority first, and in the order they were added within one
+    void insertOrdered(std::vector<task>& tasks, task&& t) {
+        auto it = std::find_if(tasks.begin(), tasks.end(), [&](task const& other) {
+            return other.priority < t.priority;
+        });
+        tasks.insert(it, std::move(t));
+    }
+}
+
+unsigned int TaskScheduler::add(std::string name, task_priority priority, task::step_fn step, task::cancel_fn onCancel) {
+    task t;
+    t.id = m_nextId++;
+    t.name = std::move(name);
+    t.priority = priority;
+    t.done = 0;
+    t.total = 0;
+    t.ms = 0.0;
+    t.frames = 0;
+    t.cancelled = false;
+    t.step = std::move(step);
+    t.onCancel = std::move(onCancel);
+
+    auto id = t.id;
+    if (m_running)
+        m_added.push_back(std::move(t));
+    else
+        insertOrdered(m_tasks, std::move(t));
+    return id;
+}
+
+unsigned int TaskScheduler::start(std::string name, task_priority priority, task::step_fn step, task::cancel_fn onCancel) {
+    auto id = this->add(std::move(name), priority, std::move(step), std::move(onCancel));
+    if (m_running)
+        return id;
+
+    auto it = std::find_if(m_tasks.begin(), m_tasks.end(), [&](task const& t) { return t.id == id; });
+
+    m_running = true;
+    auto more = this->runTask(*it, deadlineIn(m_budgetMs));
+    m_running = false;
+
+    // the step may have added tasks, which moves things around
+    it = std::find_if(m_tasks.begin(), m_tasks.end(), [&](task const& t) { return t.id == id; });
+    if (!more) {
+        m_tasks.erase(it);
+        m_stats.completed++;
+    }
+    for (auto& t : m_added)
+        insertOrdered(m_tasks, std::move(t));
+    m_added.clear();
+
+    this->dropCancelled();
+
+    return id;
+}
+
+void TaskScheduler::cancel(unsigned int id) {
+    for (auto& t : m_tasks)
+        if (t.id == id)
+            t.cancelled = true;
+    for (auto& t : m_added)
+        if (t.id == id)
+            t.cancelled = true;
+
+    if (!m_running)
+        this->dropCancelled();
+}
+
+void TaskScheduler::cancelAll() {
+    for (auto& t : m_tasks)
+        t.cancelled = true;
+    for (auto& t : m_added)
+        t.cancelled = true;
+
+    if (!m_running)
+        this->dropCancelled();
+}
+
+void TaskScheduler::dropCancelled() {
+    // pulled out first, a cancel callback is free to add or cancel tasks
+    std::vector<task> dropped;
+    for (auto it = m_tasks.begin(); it != m_tasks.end();) {
+        if (it->cancelled) {
+            dropped.push_back(std::move(*it));
+            it = m_tasks.erase(it);
+        } else {
+            it++;
+        }
+    }
+
+    for (auto& t : dropped) {
+        m_stats.cancelled++;
+        if (t.onCancel)
+            t.onCancel();
+    }
+}
+
+bool TaskScheduler::runTask(task& t, steady_clock::time_point deadline) {
+    auto start = steady_clock::now();
+
+    task_context ctx { t.done, t.total, deadline, 0 };
+
+    auto more = true;
+    do {
+        more = t.step(ctx);
+        ctx.steps++;
+    } while (more && !t.cancelled && !ctx.expired());
+
+    t.done = ctx.done;
+    t.total = ctx.total;
+    t.frames++;
+    t.ms += std::chrono::duration<double, std::milli>(steady_clock::now() - start).count();
+
+    return more;
+}
+
+void TaskScheduler::run() {
+    auto start = steady_clock::now();
+    auto deadline = deadlineIn(m_budgetMs);
+
+    this->dropCancelled();
+
+    m_running = true;
+    size_t i = 0;
+    while (i < m_tasks.size() && steady_clock::now() < deadline) {
+        auto& t = m_tasks[i];
+        if (t.cancelled) {
+            i++;
+            continue;
+        }
+
+        if (this->runTask(t, deadline)) {
+            i++;
+            continue;
+        }
+
+        m_tasks.erase(m_tasks.begin() + i);
+        m_stats.completed++;
+    }
+    m_running = false;
+
+    for (auto& t : m_added)
+        insertOrdered(m_tasks, std::move(t));
+    m_added.clear();
+
+    this->dropCancelled();
+
+    m_stats.lastMs = std::chrono::duration<double, std::milli>(steady_clock::now() - start).count();
+    if (m_stats.lastMs > m_budgetMs)
+        m_stats.overruns++;
+}
@@ -0,0 +1,94 @@
+#ifndef __TASK_SCHEDULER_HPP__
+#define __TASK_SCHEDULER_HPP__
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+enum task_priority : uint8_t {
+    tpLow,
+    tpNormal,
+    tpHigh,
+};
+
+// handed to every step. `done` / `total` are the task's progress, kept
+// between steps; a step that loops on its own should stop once expired().
+// a slice is the run of steps a task gets in one go, nothing else runs
+// in between them; `steps` is 0 on the first one of every slice
+struct task_context {
+    size_t done;
+    size_t total;
+    std::chrono::steady_clock::time_point deadline;
+    unsigned int steps;
+
+    bool expired() const {
+        return std::chrono::steady_clock::now() >= deadline;
+    }
+};
+
+struct task {
+    using step_fn = std::function<bool(task_context&)>;
+    using cancel_fn = std::function<void()>;
+
+    unsigned int id;
+    std::string name;
+    task_priority priority;
+    size_t done;
+    size_t total;
+    double ms;                  // time spent in it so far
+    unsigned int frames;        // frames it got to run on
+    bool cancelled;
+    step_fn step;               // does a small piece of work, false once finished
+    cancel_fn onCancel;
+};
+
+struct task_scheduler_stats {
+    double lastMs;              // time spent in the last run
+    unsigned int overruns;      // runs that went past the budget
+    unsigned int completed;
+    unsigned int cancelled;
+};
+
+// cooperative scheduler for explorer work that's too big for one frame.
+// run() is called once per frame from the scheduler hook and keeps
+// calling steps of the highest priority task (oldest first) until the
+// frame's budget is used up, so a task resumes where it left off on
+// the next frame. everything here happens on the main thread
+class TaskScheduler {
+    public:
+        unsigned int add(std::string name, task_priority priority, task::step_fn step, task::cancel_fn onCancel = nullptr);
+        // same as add, but the first slice runs right away, for work
+        // that should be as far along as possible before the next draw
+        unsigned int start(std::string name, task_priority priority, task::step_fn step, task::cancel_fn onCancel = nullptr);
+
+        // the task is dropped before it runs again, ids of finished
+        // tasks are ignored
+        void cancel(unsigned int id);
+        void cancelAll();
+
+        void run();
+
+        void setBudget(double ms) { m_budgetMs = ms; }
+        double budget() const { return m_budgetMs; }
+
+        std::vector<task> const& tasks() const { return m_tasks; }
+        task_scheduler_stats const& stats() const { return m_stats; }
+
+    protected:
+        // false if the task finished
+        bool runTask(task& t, std::chrono::steady_clock::time_point deadline);
+        void dropCancelled();
+
+        std::vector<task> m_tasks;
+        std::vector<task> m_added;  // added from inside a step, merged after the run
+        bool m_running = false;
+        unsigned int m_nextId = 1;
+        double m_budgetMs = 1.0;
+        task_scheduler_stats m_stats {};
+};
+
+extern TaskScheduler g_tasks;
+
+#endif
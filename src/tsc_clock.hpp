@@ -0,0 +1,43 @@
+#ifndef __TSC_CLOCK_HPP__
+#define __TSC_CLOCK_HPP__
+
+#include <chrono>
+#include <cstdint>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+// turns tsc ticks into ms. the rate is worked out against steady_clock
+// since the first update(), and only trusted after 100 ms of that
+struct tsc_clock {
+    uint64_t tscStart = 0;
+    std::chrono::steady_clock::time_point clockStart;
+    double ticksPerMs = 0.0;
+
+    void update() {
+        auto tsc = __rdtsc();
+        auto now = std::chrono::steady_clock::now();
+
+        if (!tscStart) {
+            tscStart = tsc;
+            clockStart = now;
+            return;
+        }
+
+        auto ms = std::chrono::duration<double, std::milli>(now - clockStart).count();
+        if (ms > 100.0)
+            ticksPerMs = (tsc - tscStart) / ms;
+    }
+
+    bool ready() const {
+        return ticksPerMs > 0.0;
+    }
+
+    float toMs(uint64_t ticks) const {
+        return static_cast<float>(ticks / ticksPerMs);
+    }
+};
+
+#endif
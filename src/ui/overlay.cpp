@@ -0,0 +1,156 @@
+#include "overlay.hpp"
+#include <cmath>
+#include <algorithm>
+
+namespace {
+    // one reserve can't go past what 16-bit indices address
+    constexpr unsigned int s_maxChunkQuads = 0xffff / 4;
+
+    unsigned int quadsOf(overlay_shape shape) {
+        return shape == osRect ? 4 : 1;
+    }
+
+    void normalize(ImVec2& min, ImVec2& max) {
+        if (min.x > max.x) std::swap(min.x, max.x);
+        if (min.y > max.y) std::swap(min.y, max.y);
+    }
+}
+
+uint32_t Overlay::styleOf(overlay_shape shape, ImU32 color, float thickness) {
+    auto res = m_styleLookup.emplace(style_key { shape, color, thickness }, static_cast<uint32_t>(m_styles.size()));
+    if (res.second)
+        m_styles.push_back({ shape, color, thickness });
+    return res.first->second;
+}
+
+void Overlay::fill(ImVec2 const& min, ImVec2 const& max, ImU32 color) {
+    primitive p { min, max, this->styleOf(osFill, color, 0.0f) };
+    normalize(p.a, p.b);
+    m_primitives.push_back(p);
+}
+
+void Overlay::rect(ImVec2 const& min, ImVec2 const& max, ImU32 color, float thickness) {
+    primitive p { min, max, this->styleOf(osRect, color, thickness) };
+    normalize(p.a, p.b);
+    m_primitives.push_back(p);
+}
+
+void Overlay::line(ImVec2 const& from, ImVec2 const& to, ImU32 color, float thickness) {
+    m_primitives.push_back({ from, to, this->styleOf(osLine, color, thickness) });
+}
+
+void Overlay::flush(ImDrawList& list) {
+    m_stats = {};
+    m_stats.styles = static_cast<unsigned int>(m_styles.size());
+
+    auto clipMin = list.GetClipRectMin();
+    auto clipMax = list.GetClipRectMax();
+
+    // group by style with a counting sort, fills before outlines before lines
+    std::vector<uint32_t> order(m_styles.size());
+    for (uint32_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return m_styles[a].shape < m_styles[b].shape;
+    });
+
+    std::vector<uint32_t> rank(m_styles.size());
+    for (uint32_t i = 0; i < order.size(); i++)
+        rank[order[i]] = i;
+
+    m_counts.assign(m_styles.size() + 1, 0);
+    for (auto& p : m_primitives) {
+        auto& style = m_styles[p.style];
+        auto pad = style.thickness / 2;
+
+        auto minX = std::min(p.a.x, p.b.x) - pad;
+        auto minY = std::min(p.a.y, p.b.y) - pad;
+        auto maxX = std::max(p.a.x, p.b.x) + pad;
+        auto maxY = std::max(p.a.y, p.b.y) + pad;
+
+        if (maxX < clipMin.x || maxY < clipMin.y || minX > clipMax.x || minY > clipMax.y) {
+            m_stats.culled++;
+            p.style = static_cast<uint32_t>(-1);
+            continue;
+        }
+
+        m_counts[rank[p.style] + 1]++;
+    }
+
+    for (size_t i = 1; i < m_counts.size(); i++)
+        m_counts[i] += m_counts[i - 1];
+
+    m_sorted.resize(m_counts.back());
+    {
+        auto offsets = m_counts;
+        for (auto& p : m_primitives)
+            if (p.style != static_cast<uint32_t>(-1))
+                m_sorted[offsets[rank[p.style]]++] = &p;
+    }
+
+    // without vertex offsets the whole list has to fit in 16-bit indices
+    auto quadBudget = static_cast<unsigned int>(-1);
+    if (sizeof(ImDrawIdx) == 2 && !(list.Flags & ImDrawListFlags_AllowVtxOffset))
+        quadBudget = (0xffff - std::min(list._VtxCurrentIdx, 0xffffu)) / 4;
+
+    auto uv = ImGui::GetFontTexUvWhitePixel();
+
+    for (uint32_t r = 0; r < order.size(); r++) {
+        auto& style = m_styles[order[r]];
+        auto perQuad = quadsOf(style.shape);
+        auto h = style.thickness / 2;
+
+        auto begin = m_counts[r];
+        auto end = m_counts[r + 1];
+
+        while (begin < end) {
+            auto fit = std::min(std::min(end - begin, s_maxChunkQuads / perQuad), quadBudget / perQuad);
+            if (!fit) {
+                m_stats.dropped += end - begin;
+                break;
+            }
+
+            list.PrimReserve(fit * perQuad * 6, fit * perQuad * 4);
+            quadBudget -= fit * perQuad;
+
+            for (auto i = begin; i < begin + fit; i++) {
+                auto a = m_sorted[i]->a;
+                auto b = m_sorted[i]->b;
+
+                switch (style.shape) {
+                    case osFill:
+                        list.PrimRect(a, b, style.color);
+                        break;
+
+                    case osRect:
+                        list.PrimRect({ a.x - h, a.y - h }, { b.x + h, a.y + h }, style.color);
+                        list.PrimRect({ a.x - h, b.y - h }, { b.x + h, b.y + h }, style.color);
+                        list.PrimRect({ a.x - h, a.y + h }, { a.x + h, b.y - h }, style.color);
+                        list.PrimRect({ b.x - h, a.y + h }, { b.x + h, b.y - h }, style.color);
+                        break;
+
+                    case osLine: {
+                        auto dx = b.x - a.x;
+                        auto dy = b.y - a.y;
+                        auto len = sqrtf(dx * dx + dy * dy);
+                        auto nx = len > 0.0f ? -dy / len * h : 0.0f;
+                        auto ny = len > 0.0f ? dx / len * h : 0.0f;
+
+                        list.PrimQuadUV(
+                            { a.x + nx, a.y + ny }, { b.x + nx, b.y + ny },
+                            { b.x - nx, b.y - ny }, { a.x - nx, a.y - ny },
+                            uv, uv, uv, uv, style.color
+                        );
+                    } break;
+                }
+            }
+
+            m_stats.drawn += fit;
+            begin += fit;
+        }
+    }
+
+    m_primitives.clear();
+    m_styles.clear();
+    m_styleLookup.clear();
+}
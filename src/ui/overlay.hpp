@@ -0,0 +1,78 @@
+#ifndef __OVERLAY_HPP__
+#define __OVERLAY_HPP__
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <imgui.h>
+
+enum overlay_shape : uint8_t {
+    osFill,
+    osRect,
+    osLine,
+};
+
+struct overlay_style {
+    overlay_shape shape;
+    ImU32 color;
+    float thickness;
+};
+
+struct overlay_stats {
+    unsigned int drawn;
+    unsigned int culled;
+    unsigned int dropped;   // didn't fit in the draw list's 16-bit indices
+    unsigned int styles;
+};
+
+// collects the frame's highlight rects and guide lines instead of
+// drawing them right away. flush() culls what's outside the clip rect
+// and draws each style's primitives together as plain quads, fills
+// first, then outlines, then lines
+class Overlay {
+    public:
+        void fill(ImVec2 const& min, ImVec2 const& max, ImU32 color);
+        void rect(ImVec2 const& min, ImVec2 const& max, ImU32 color, float thickness);
+        void line(ImVec2 const& from, ImVec2 const& to, ImU32 color, float thickness);
+
+        void flush(ImDrawList& list);
+
+        overlay_stats const& stats() const { return m_stats; }
+
+    protected:
+        struct primitive {
+            ImVec2 a;
+            ImVec2 b;
+            uint32_t style;
+        };
+
+        struct style_key {
+            overlay_shape shape;
+            ImU32 color;
+            float thickness;
+
+            bool operator==(style_key const& other) const {
+                return shape == other.shape && color == other.color && thickness == other.thickness;
+            }
+        };
+
+        struct style_key_hash {
+            size_t operator()(style_key const& key) const {
+                uint32_t thickness;
+                std::memcpy(&thickness, &key.thickness, sizeof(thickness));
+                return (static_cast<size_t>(key.color) * 0x9e3779b9u) ^ (static_cast<size_t>(thickness) * 31) ^ key.shape;
+            }
+        };
+
+        uint32_t styleOf(overlay_shape shape, ImU32 color, float thickness);
+
+        std::vector<overlay_style> m_styles;
+        std::unordered_map<style_key, uint32_t, style_key_hash> m_styleLookup;
+        std::vector<primitive> m_primitives;
+        std::vector<uint32_t> m_counts;
+        std::vector<primitive const*> m_sorted;
+        overlay_stats m_stats {};
+};
+
+#endif
@@ -0,0 +1,134 @@
+#include "profiler_panel.hpp"
+
+#ifdef DESIGNER_PROFILE
+
+#include <cfloat>
+#include <algorithm>
+#include <imgui.h>
+#include "tsc_clock.hpp"
+
+namespace {
+    constexpr size_t s_historySize = 240;
+
+    char const* const s_zoneNames[pzCount] = {
+        "RenderMain",
+        "Tree view",
+        "Hover",
+        "Snapping",
+        "Queue drain",
+        "Tasks",
+        "Snapshot",
+        "Mouse hook",
+        "Keyboard hook",
+        "Scroll hook",
+        "Scene switch hook",
+        "Child hooks",
+    };
+
+    struct ring_reader {
+        ProfileRing* ring;
+        uint64_t cursor;
+    };
+
+    // the last samples of one zone, in ms
+    struct zone_history {
+        float samples[s_historySize];
+        size_t next;
+        size_t count;
+        unsigned long long calls;
+    };
+
+    // panel side, main thread only
+    std::vector<ring_reader> s_readers;
+    std::vector<ProfileRing*> s_newRings;
+    std::vector<profile_sample> s_batch;
+    zone_history s_zones[pzCount];
+    int s_selected = pzRenderMain;
+
+    // calibrated from the first time the panel was drawn
+    tsc_clock s_clock;
+
+    void collect() {
+        s_newRings.clear();
+        profileRings(s_readers.size(), s_newRings);
+        for (auto ring : s_newRings)
+            s_readers.push_back({ ring, 0 });
+
+        s_batch.clear();
+        for (auto& reader : s_readers)
+            reader.cursor = reader.ring->read(reader.cursor, s_batch);
+
+        if (!s_clock.ready())
+            return;
+
+        for (auto const& sample : s_batch) {
+            auto& zone = s_zones[sample.zone];
+            zone.samples[zone.next] = s_clock.toMs(sample.ticks);
+            zone.next = (zone.next + 1) % s_historySize;
+            zone.count = std::min(zone.count + 1, s_historySize);
+            zone.calls++;
+        }
+    }
+}
+
+void showProfiler() {
+    s_clock.update();
+    collect();
+
+    if (!s_clock.ready()) {
+        ImGui::Text("Calibrating...");
+        return;
+    }
+
+    ImGui::Columns(5, "profiler");
+    ImGui::Text("Zone");
+    ImGui::NextColumn();
+    ImGui::Text("p50 (ms)");
+    ImGui::NextColumn();
+    ImGui::Text("p99 (ms)");
+    ImGui::NextColumn();
+    ImGui::Text("max (ms)");
+    ImGui::NextColumn();
+    ImGui::Text("calls");
+    ImGui::NextColumn();
+    ImGui::Separator();
+
+    float sorted[s_historySize];
+    for (int i = 0; i < pzCount; i++) {
+        auto const& zone = s_zones[i];
+
+        if (ImGui::Selectable(s_zoneNames[i], s_selected == i, ImGuiSelectableFlags_SpanAllColumns))
+            s_selected = i;
+        ImGui::NextColumn();
+
+        if (zone.count) {
+            std::copy(zone.samples, zone.samples + zone.count, sorted);
+            std::sort(sorted, sorted + zone.count);
+            ImGui::Text("%.3f", sorted[zone.count / 2]);
+            ImGui::NextColumn();
+            ImGui::Text("%.3f", sorted[(zone.count - 1) * 99 / 100]);
+            ImGui::NextColumn();
+            ImGui::Text("%.3f", sorted[zone.count - 1]);
+            ImGui::NextColumn();
+        } else {
+            for (int c = 0; c < 3; c++) {
+                ImGui::TextDisabled("-");
+                ImGui::NextColumn();
+            }
+        }
+
+        ImGui::Text("%llu", zone.calls);
+        ImGui::NextColumn();
+    }
+    ImGui::Columns(1);
+
+    // oldest first, so the graph scrolls to the left
+    auto const& zone = s_zones[s_selected];
+    auto offset = zone.count < s_historySize ? 0 : static_cast<int>(zone.next);
+    ImGui::PlotLines(
+        "##history", zone.samples, static_cast<int>(zone.count), offset,
+        s_zoneNames[s_selected], 0.0f, FLT_MAX, ImVec2(0.0f, 80.0f)
+    );
+}
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef __PROFILER_PANEL_HPP__
+#define __PROFILER_PANEL_HPP__
+
+#include "profiler.hpp"
+
+#ifdef DESIGNER_PROFILE
+
+// the frame breakdown, drawn inside the explorer window
+void showProfiler();
+
+#endif
+
+#endif
@@ -0,0 +1,146 @@
+#include "sched_profiler_panel.hpp"
+#include <imgui.h>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+    // the table only shows the top of whatever it's sorted by
+    constexpr size_t s_maxShown = 100;
+
+    enum sched_column {
+        scTarget,
+        scName,
+        scCalls,
+        scLastFrame,
+        scAverage,
+        scP99,
+        scTotal,
+
+        scColumnCount,
+    };
+
+    char const* s_columnNames[scColumnCount] = {
+        "Target", "Callback", "Calls", "Frame (ms)", "Avg (ms)", "p99 (ms)", "Total (ms)",
+    };
+
+    int s_sortColumn = scLastFrame;
+    bool s_sortDescending = true;
+
+    struct shown_row {
+        uint32_t index;
+        float lastMs;
+        float averageMs;
+        float p99Ms;
+        float totalMs;
+    };
+
+    std::vector<shown_row> s_shown;
+
+    float p99Of(sched_row const& row, tsc_clock const& clock) {
+        if (!row.count)
+            return 0.0f;
+
+        uint32_t sorted[sched_row::historySize];
+        std::copy(row.history, row.history + row.count, sorted);
+        auto nth = sorted + (row.count - 1) * 99 / 100;
+        std::nth_element(sorted, nth, sorted + row.count);
+        return clock.toMs(*nth);
+    }
+}
+
+CCNode* showSchedProfiler(SchedProfiler const& profiler) {
+    auto const& clock = profiler.clock();
+    if (!clock.ready()) {
+        ImGui::Text("Calibrating...");
+        return nullptr;
+    }
+
+    auto const& stats = profiler.stats();
+    ImGui::Text(
+        "Scheduler %.3f ms: timers %.3f ms, actions %.3f ms, rest %.3f ms (%u rows)",
+        stats.schedulerMs, stats.timersMs, stats.actionsMs,
+        std::max(stats.schedulerMs - stats.timersMs - stats.actionsMs, 0.0f), stats.rows
+    );
+
+    auto const& rows = profiler.rows();
+    s_shown.clear();
+    for (uint32_t i = 0; i < rows.size(); i++) {
+        auto const& r = rows[i];
+        s_shown.push_back({
+            i,
+            clock.toMs(r.lastFrameTicks),
+            r.calls ? clock.toMs(r.ticks) / r.calls : 0.0f,
+            // only worked out for every row when it's what's sorted by
+            s_sortColumn == scP99 ? p99Of(r, clock) : 0.0f,
+            clock.toMs(r.ticks),
+        });
+    }
+
+    auto key = [&](shown_row const& s) -> double {
+        switch (s_sortColumn) {
+            case scCalls:       return static_cast<double>(rows[s.index].calls);
+            case scLastFrame:   return s.lastMs;
+            case scAverage:     return s.averageMs;
+            case scP99:         return s.p99Ms;
+            case scTotal:       return s.totalMs;
+            default:            return 0.0;
+        }
+    };
+    auto byName = [&](shown_row const& a, shown_row const& b) {
+        auto const& ra = rows[a.index];
+        auto const& rb = rows[b.index];
+        auto res = s_sortColumn == scTarget ?
+            std::strcmp(ra.targetName, rb.targetName) :
+            std::strcmp(ra.name, rb.name);
+        return s_sortDescending ? res > 0 : res < 0;
+    };
+    auto shown = std::min(s_shown.size(), s_maxShown);
+    std::partial_sort(s_shown.begin(), s_shown.begin() + shown, s_shown.end(), [&](shown_row const& a, shown_row const& b) {
+        if (s_sortColumn == scTarget || s_sortColumn == scName)
+            return byName(a, b);
+        return s_sortDescending ? key(a) > key(b) : key(a) < key(b);
+    });
+
+    ImGui::Columns(scColumnCount, "scheduler");
+    for (int i = 0; i < scColumnCount; i++) {
+        if (ImGui::Selectable(s_columnNames[i], s_sortColumn == i)) {
+            if (s_sortColumn == i)
+                s_sortDescending = !s_sortDescending;
+            else
+                s_sortColumn = i;
+        }
+        ImGui::NextColumn();
+    }
+    ImGui::Separator();
+
+    CCNode* clicked = nullptr;
+    for (size_t i = 0; i < shown; i++) {
+        auto const& s = s_shown[i];
+        auto const& r = rows[s.index];
+
+        ImGui::PushID(static_cast<int>(s.index));
+        if (ImGui::Selectable(r.targetName, false, ImGuiSelectableFlags_SpanAllColumns) && r.node)
+            clicked = r.node;
+        ImGui::PopID();
+        ImGui::NextColumn();
+
+        if (r.kind == skTimer && r.interval > 0.0f)
+            ImGui::Text("%s (every %.2fs)", r.name, r.interval);
+        else
+            ImGui::TextUnformatted(r.name);
+        ImGui::NextColumn();
+        ImGui::Text("%llu", r.calls);
+        ImGui::NextColumn();
+        ImGui::Text("%.3f", s.lastMs);
+        ImGui::NextColumn();
+        ImGui::Text("%.4f", s.averageMs);
+        ImGui::NextColumn();
+        ImGui::Text("%.4f", s_sortColumn == scP99 ? s.p99Ms : p99Of(r, clock));
+        ImGui::NextColumn();
+        ImGui::Text("%.1f", s.totalMs);
+        ImGui::NextColumn();
+    }
+    ImGui::Columns(1);
+
+    return clicked;
+}
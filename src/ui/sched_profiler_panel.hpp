@@ -0,0 +1,10 @@
+#ifndef __SCHED_PROFILER_PANEL_HPP__
+#define __SCHED_PROFILER_PANEL_HPP__
+
+#include "sched_profiler.hpp"
+
+// the sortable per target table. returns the node of the row that
+// was clicked, if any, which may not be alive anymore
+CCNode* showSchedProfiler(SchedProfiler const& profiler);
+
+#endif
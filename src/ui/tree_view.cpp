@@ -0,0 +1,311 @@
+#include "tree_view.hpp"
+#include "profiler.hpp"
+#include "scene_graph.hpp"
+#include <imgui.h>
+#include <sstream>
+#include <algorithm>
+
+TreeView::~TreeView() {
+    this->clearRows();
+}
+
+void TreeView::invalidate() {
+    m_dirty = true;
+}
+
+void TreeView::setColumns(columns_fn columns, float x) {
+    m_columns = columns;
+    m_columnsX = x;
+}
+
+void TreeView::clearRows() {
+    for (auto& row : m_rows)
+        if (row.kind == rkNode)
+            row.node->release();
+    m_rows.clear();
+}
+
+void TreeView::pushRow(
+    tree_row_kind kind, CCNode* node, unsigned int index, unsigned int last, unsigned int depth
+) {
+    tree_row row;
+    row.kind = kind;
+    row.node = node;
+    row.index = index;
+    row.last = last;
+    row.depth = depth;
+    row.children = node->getChildrenCount();
+    row.tag = node->getTag();
+
+    switch (kind) {
+        case rkNode: {
+            std::stringstream stream;
+            stream << "[" << index << "] " << getNodeName(node);
+            if (row.tag != -1)
+                stream << " (" << row.tag << ")";
+            if (row.children)
+                stream << " {" << row.children << "}";
+            row.label = stream.str();
+            node->retain();
+        } break;
+
+        case rkAttributes:
+            row.label = "Attributes";
+            break;
+
+        case rkGroup:
+            row.label = "[" + std::to_string(index) + ".." + std::to_string(last) + "]";
+            break;
+    }
+
+    m_rows.push_back(std::move(row));
+}
+
+void TreeView::flatten(CCNode* node, unsigned int index, unsigned int depth) {
+    this->pushRow(rkNode, node, index, index, depth);
+
+    if (!m_open.count(node))
+        return;
+
+    this->pushRow(rkAttributes, node, index, index, depth + 1);
+
+    auto children = node->getChildren();
+    auto count = node->getChildrenCount();
+
+    if (count <= groupSize) {
+        for (unsigned int i = 0; i < count; i++)
+            this->flatten(reinterpret_cast<CCNode*>(children->objectAtIndex(i)), i, depth + 1);
+        return;
+    }
+
+    for (unsigned int first = 0; first < count; first += groupSize) {
+        auto last = std::min(first + groupSize, count) - 1;
+
+        this->pushRow(rkGroup, node, first, last, depth + 1);
+
+        if (!m_groupsOpen.count({ node, first }))
+            continue;
+
+        for (auto i = first; i <= last; i++)
+            this->flatten(reinterpret_cast<CCNode*>(children->objectAtIndex(i)), i, depth + 2);
+    }
+}
+
+void TreeView::setRoot(CCNode* root) {
+    if (root == m_root)
+        return;
+
+    // what's open is keyed by node, none of which are around anymore
+    // once the scene changed, and their addresses get reused
+    m_open.clear();
+    m_attributesOpen.clear();
+    m_groupsOpen.clear();
+    m_root = root;
+    m_dirty = true;
+}
+
+void TreeView::rebuild(CCNode* root) {
+    this->setRoot(root);
+    this->clearRows();
+
+    if (root)
+        this->flatten(root, 0, 0);
+
+    m_dirty = false;
+}
+
+void TreeView::openPath(CCNode* root, std::vector<int> const& loc) {
+    if (!root || loc.empty())
+        return;
+    this->setRoot(root);
+
+    // the first entry is the scene itself
+    CCNode* node = root;
+    m_open.insert(node);
+
+    for (auto it = loc.begin() + 1; it != loc.end(); it++) {
+        auto ix = static_cast<unsigned int>(*it);
+        if (node->getChildrenCount() <= ix)
+            break;
+
+        if (node->getChildrenCount() > groupSize)
+            m_groupsOpen.insert({ node, ix / groupSize * groupSize });
+
+        node = reinterpret_cast<CCNode*>(node->getChildren()->objectAtIndex(ix));
+        m_open.insert(node);
+    }
+
+    m_attributesOpen.insert(node);
+    m_scrollTarget = node;
+    m_dirty = true;
+}
+
+bool TreeView::isStale(tree_row const& row) const {
+    if (row.kind == rkNode && row.tag != row.node->getTag())
+        return true;
+
+    // children only come and go through the hooked functions, so the
+    // rest is only checked by render() when the structure stamp moved
+    if (!m_structureChanged)
+        return false;
+
+    if (row.children != row.node->getChildrenCount())
+        return true;
+
+    if (row.kind != rkNode || row.node == m_root)
+        return false;
+
+    // removed, or moved around inside its parent
+    auto parent = row.node->getParent();
+    if (!parent || parent->getChildrenCount() <= row.index)
+        return true;
+
+    return parent->getChildren()->objectAtIndex(row.index) != row.node;
+}
+
+bool TreeView::drawRow(tree_row const& row) {
+    if (this->isStale(row))
+        m_dirty = true;
+
+    auto indent = row.depth * ImGui::GetStyle().IndentSpacing;
+    if (indent > 0.0f)
+        ImGui::Indent(indent);
+
+    bool open, toggled = false;
+    switch (row.kind) {
+        case rkNode:
+            open = m_open.count(row.node);
+            ImGui::SetNextItemOpen(open);
+            if (ImGui::TreeNodeEx(row.node, ImGuiTreeNodeFlags_NoTreePushOnOpen, "%s", row.label.c_str()) != open) {
+                if (open)
+                    m_open.erase(row.node);
+                else
+                    m_open.insert(row.node);
+                toggled = true;
+            }
+            if (m_columns) {
+                ImGui::SameLine(m_columnsX);
+                m_columns(row.node);
+            }
+            break;
+
+        case rkAttributes:
+            open = m_attributesOpen.count(row.node);
+            ImGui::SetNextItemOpen(open);
+            if (ImGui::TreeNodeEx(row.node + 1, ImGuiTreeNodeFlags_NoTreePushOnOpen, "%s", row.label.c_str()) != open) {
+                if (open)
+                    m_attributesOpen.erase(row.node);
+                else
+                    m_attributesOpen.insert(row.node);
+                toggled = true;
+            }
+            break;
+
+        case rkGroup:
+            open = m_groupsOpen.count({ row.node, row.index });
+            ImGui::SetNextItemOpen(open);
+            ImGui::PushID(row.node);
+            if (ImGui::TreeNodeEx(
+                reinterpret_cast<void*>(static_cast<uintptr_t>(row.index)),
+                ImGuiTreeNodeFlags_NoTreePushOnOpen, "%s", row.label.c_str()
+            ) != open) {
+                if (open)
+                    m_groupsOpen.erase({ row.node, row.index });
+                else
+                    m_groupsOpen.insert({ row.node, row.index });
+                toggled = true;
+            }
+            ImGui::PopID();
+            break;
+    }
+
+    if (indent > 0.0f)
+        ImGui::Unindent(indent);
+
+    if (toggled)
+        m_dirty = true;
+
+    return toggled;
+}
+
+void TreeView::render(CCNode* root, attributes_fn drawAttributes, uint32_t generation) {
+    PROFILE_SCOPE(pzTreeView);
+
+    m_structureChanged = generation != m_generation;
+    m_generation = generation;
+
+    // rows that are scrolled away wouldn't notice the change later on
+    if (m_structureChanged && !m_dirty) {
+        for (auto const& row : m_rows) {
+            if (this->isStale(row)) {
+                m_dirty = true;
+                break;
+            }
+        }
+    }
+    m_structureChanged = false;
+
+    if (m_dirty || root != m_root)
+        this->rebuild(root);
+
+    const auto itemHeight = ImGui::GetTextLineHeightWithSpacing();
+    const auto rowCount = static_cast<unsigned int>(m_rows.size());
+
+    // rows are uniform except for open attribute panels, so clip
+    // each run of rows up to and including the next open panel's
+    // header, draw the panel itself unclipped, and carry on
+    unsigned int start = 0;
+    while (start < rowCount) {
+        auto end = start;
+        while (end < rowCount && !(
+            m_rows[end].kind == rkAttributes && m_attributesOpen.count(m_rows[end].node)
+        ))
+            end++;
+        auto segmentEnd = std::min(end + 1, rowCount);
+
+        if (m_scrollTarget) {
+            for (auto i = start; i < segmentEnd; i++) {
+                if (m_rows[i].kind == rkNode && m_rows[i].node == m_scrollTarget) {
+                    auto y = ImGui::GetCursorPosY() + (i - start) * itemHeight;
+                    ImGui::SetScrollFromPosY(y - ImGui::GetScrollY());
+                    m_scrollTarget = nullptr;
+                    break;
+                }
+            }
+        }
+
+        bool changed = false;
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(segmentEnd - start), itemHeight);
+        while (clipper.Step()) {
+            for (auto i = clipper.DisplayStart; i < clipper.DisplayEnd; i++)
+                changed |= this->drawRow(m_rows[start + i]);
+        }
+        clipper.End();
+
+        // the row list no longer matches what's open, draw the
+        // rest next frame once it's been rebuilt
+        if (changed)
+            return;
+
+        if (end < rowCount) {
+            auto const& row = m_rows[end];
+            auto indent = (row.depth + 1) * ImGui::GetStyle().IndentSpacing;
+
+            ImGui::Indent(indent);
+            ImGui::PushID(row.node);
+            auto alive = drawAttributes(row.node);
+            ImGui::PopID();
+            ImGui::Unindent(indent);
+
+            if (!alive) {
+                m_dirty = true;
+                return;
+            }
+        }
+
+        start = segmentEnd;
+    }
+
+    m_scrollTarget = nullptr;
+}
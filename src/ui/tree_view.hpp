@@ -0,0 +1,78 @@
+#ifndef __TREE_VIEW_HPP__
+#define __TREE_VIEW_HPP__
+
+#include <vector>
+#include <string>
+#include <set>
+#include <unordered_set>
+#include <cstdint>
+#include <cocos2d.h>
+
+using namespace cocos2d;
+
+enum tree_row_kind {
+    rkNode,
+    rkAttributes,
+    rkGroup,
+};
+
+struct tree_row {
+    tree_row_kind kind;
+    CCNode* node;           // for groups, the node whose children are grouped
+    unsigned int index;     // index in parent, or first child index for groups
+    unsigned int last;      // last child index for groups
+    unsigned int depth;
+    unsigned int children;  // child count when the row was built
+    int tag;
+    std::string label;
+};
+
+// flattened list of the rows that are currently expanded in the
+// explorer. it's only rebuilt when something is expanded/collapsed
+// or the rows on screen notice the scene changed under them, and
+// drawn through ImGuiListClipper so a frame only costs the rows that
+// are actually visible
+class TreeView {
+    public:
+        static constexpr unsigned int groupSize = 1000;
+
+        using attributes_fn = bool(*)(CCNode*);
+        using columns_fn = void(*)(CCNode*);
+
+        ~TreeView();
+
+        // `generation` is the scene's structure stamp, rows are only
+        // checked against the scene when it changes
+        void render(CCNode* root, attributes_fn drawAttributes, uint32_t generation);
+        // expand everything along a tree location (as returned by
+        // getNodeLocationInTree) and scroll to the node at its end
+        void openPath(CCNode* root, std::vector<int> const& loc);
+        void invalidate();
+        // extra columns drawn after every node row, starting at `x`.
+        // nullptr turns them off
+        void setColumns(columns_fn columns, float x);
+
+    protected:
+        void rebuild(CCNode* root);
+        void setRoot(CCNode* root);
+        void flatten(CCNode* node, unsigned int index, unsigned int depth);
+        void pushRow(tree_row_kind kind, CCNode* node, unsigned int index, unsigned int last, unsigned int depth);
+        void clearRows();
+        bool drawRow(tree_row const& row);
+        bool isStale(tree_row const& row) const;
+
+        CCNode* m_root = nullptr;
+        bool m_dirty = true;
+        bool m_structureChanged = true;
+        uint32_t m_generation = 0;
+        CCNode* m_scrollTarget = nullptr;
+        columns_fn m_columns = nullptr;
+        float m_columnsX = 0.0f;
+
+        std::vector<tree_row> m_rows;
+        std::unordered_set<CCNode*> m_open;
+        std::unordered_set<CCNode*> m_attributesOpen;
+        std::set<std::pair<CCNode*, unsigned int>> m_groupsOpen;
+};
+
+#endif